@@ -658,8 +658,10 @@ ALenum ALeffectslot::init()
     if(!factory) return AL_INVALID_VALUE;
     Effect.State = factory->create();
     if(!Effect.State) return AL_OUT_OF_MEMORY;
+    Effect.InputOrder = factory->getInputOrder();
 
     Effect.State->add_ref();
+    Params.InputOrder = Effect.InputOrder;
     Params.mEffectState = Effect.State;
     return AL_NO_ERROR;
 }
@@ -697,6 +699,7 @@ ALenum ALeffectslot::initEffect(ALeffect *effect, ALCcontext *context)
             Effect.Props = effect->Props;
         }
 
+        Effect.InputOrder = factory->getInputOrder();
         Effect.State->release();
         Effect.State = State;
     }
@@ -738,6 +741,7 @@ void ALeffectslot::updateProps(ALCcontext *context)
 
     props->Type = Effect.Type;
     props->Props = Effect.Props;
+    props->InputOrder = Effect.InputOrder;
     /* Swap out any stale effect state object there may be in the container, to
      * delete it.
      */
@@ -28,6 +28,7 @@ struct ALeffectslotProps {
 
     ALenum Type;
     EffectProps Props;
+    ALuint InputOrder;
 
     EffectState *State;
 
@@ -45,6 +46,7 @@ struct ALeffectslot {
     struct {
         ALenum Type{AL_EFFECT_NULL};
         EffectProps Props{};
+        ALuint InputOrder{0u};
 
         EffectState *State{nullptr};
     } Effect;
@@ -62,6 +64,7 @@ struct ALeffectslot {
 
         ALenum EffectType{AL_EFFECT_NULL};
         EffectProps mEffectProps{};
+        ALuint InputOrder{0u};
         EffectState *mEffectState{nullptr};
 
         float RoomRolloff{0.0f}; /* Added to the source's room rolloff, not multiplied. */
@@ -81,7 +84,9 @@ struct ALeffectslot {
     /* Wet buffer configuration is ACN channel order with N3D scaling.
      * Consequently, effects that only want to work with mono input can use
      * channel 0 by itself. Effects that want multichannel can process the
-     * ambisonics signal and make a B-Format source pan.
+     * ambisonics signal and make a B-Format source pan. The mixing buffer has
+     * lines for the device's ambisonic order, while the wet buffer only uses
+     * as many as the effect's input order needs.
      */
     MixParams Wet;
 
@@ -29,12 +29,15 @@
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
+#include <exception>
+#include <functional>
 #include <iterator>
 #include <limits>
 #include <memory>
 #include <mutex>
 #include <new>
 #include <numeric>
+#include <thread>
 #include <utility>
 
 #include "AL/al.h"
@@ -48,9 +51,13 @@
 #include "almalloc.h"
 #include "alnumeric.h"
 #include "aloptional.h"
+#include "alu.h"
 #include "atomic.h"
+#include "filestream.h"
 #include "inprogext.h"
+#include "logging.h"
 #include "opthelpers.h"
+#include "voice.h"
 
 
 namespace {
@@ -100,6 +107,8 @@ constexpr int MSADPCMAdaptionCoeff[7][2] = {
     { 392, -232 }
 };
 
+} // namespace
+
 
 void DecodeIMA4Block(int16_t *dst, const al::byte *src, size_t numchans, size_t align)
 {
@@ -211,6 +220,8 @@ void DecodeMSADPCMBlock(int16_t *dst, const al::byte *src, size_t numchans, size
     }
 }
 
+namespace {
+
 void Convert_int16_ima4(int16_t *dst, const al::byte *src, size_t numchans, size_t len,
     size_t align)
 {
@@ -328,8 +339,85 @@ ALbuffer *AllocBuffer(ALCdevice *device)
     return buffer;
 }
 
+/** Stops any prefetching for a callback buffer, and releases its ring. */
+void ClearCallbackPrefetch(ALCdevice *device, ALbuffer *buffer)
+{
+    if(!buffer->mCallbackRing)
+        return;
+    device->mBufferWorker->removeCallback(buffer);
+    buffer->mFileStream = nullptr;
+    buffer->mCallbackRing = nullptr;
+    buffer->mCallbackEnded.store(false, std::memory_order_relaxed);
+    buffer->mCallbackRestart.store(false, std::memory_order_relaxed);
+    buffer->mCallbackWritten = 0;
+    buffer->mCallbackRestartPos = 0;
+    buffer->mCallbackStartPos = 0;
+    buffer->mCallbackLoop.store(false, std::memory_order_relaxed);
+}
+
+/**
+ * Stops building a buffer's resample cache, and marks any cache as unusable.
+ * A cache that was ready may be in use by the mixer, so this waits for the
+ * current mix to finish before it can be changed.
+ */
+void ClearResampleCache(ALCdevice *device, ALbuffer *buffer)
+{
+    if(buffer->mResampledData.empty())
+        return;
+    device->mBufferWorker->removeResample(buffer);
+    if(buffer->mResampledReady.exchange(false, std::memory_order_acq_rel))
+        device->waitForMix();
+}
+
+/**
+ * Replaces a buffer's resample cache with a new one to be built for the
+ * current data and device rate, if requested. Data that can be modified
+ * through mapping, or is played through a callback, won't get a cache.
+ * Returns false if the cache or worker thread can't be created.
+ */
+bool QueueResampleCache(ALCdevice *device, ALbuffer *buffer)
+{
+    ClearResampleCache(device, buffer);
+    al::vector<float,16>{}.swap(buffer->mResampledData);
+    buffer->mResampledLen = 0;
+    buffer->mResampledStep = 0;
+    if(!buffer->ResampleCache || buffer->Callback || buffer->SampleLen == 0
+        || buffer->Frequency == device->Frequency || (buffer->Access&AL_MAP_WRITE_BIT_SOFT))
+        return true;
+
+    /* This must match the step the mixer calculates for unit pitch. */
+    const auto Pitch = static_cast<float>(buffer->Frequency) /
+        static_cast<float>(device->Frequency);
+    const ALuint step{(Pitch > float{MAX_PITCH}) ? ALuint{MAX_PITCH<<FRACTIONBITS} :
+        maxu(fastf2u(Pitch * FRACTIONONE), 1)};
+    const ALuint numchans{buffer->channelsFromFmt()};
+    const uint64_t len{((uint64_t{buffer->SampleLen}<<FRACTIONBITS) + step-1) / step};
+    if UNLIKELY(len > std::numeric_limits<ALuint>::max()/numchans)
+    {
+        ERR("Resample cache too large for buffer %u\n", buffer->id);
+        return false;
+    }
+
+    try {
+        if(!device->mBufferWorker)
+            device->mBufferWorker = std::make_unique<BufferWorker>();
+        al::vector<float,16>(static_cast<size_t>(len)*numchans).swap(buffer->mResampledData);
+    }
+    catch(std::exception &e) {
+        ERR("Failed to create resample cache for buffer %u: %s\n", buffer->id, e.what());
+        return false;
+    }
+    buffer->mResampledLen = static_cast<ALuint>(len);
+    buffer->mResampledStep = step;
+    device->mBufferWorker->addResample(buffer);
+    return true;
+}
+
 void FreeBuffer(ALCdevice *device, ALbuffer *buffer)
 {
+    ClearCallbackPrefetch(device, buffer);
+    ClearResampleCache(device, buffer);
+
     const ALuint id{buffer->id - 1};
     const size_t lidx{id >> 6};
     const ALuint slidx{id & 0x3f};
@@ -551,18 +639,38 @@ void LoadData(ALCcontext *context, ALbuffer *ALBuf, ALsizei freq, ALuint size,
     ALBuf->Access = access;
     ALBuf->AmbiOrder = ambiorder;
 
+    ALCdevice *device{context->mDevice.get()};
+    ClearCallbackPrefetch(device, ALBuf);
+    ClearResampleCache(device, ALBuf);
     ALBuf->Callback = nullptr;
     ALBuf->UserData = nullptr;
 
     ALBuf->SampleLen = frames;
     ALBuf->LoopStart = 0;
     ALBuf->LoopEnd = ALBuf->SampleLen;
+
+    /* Queue the resample cache to be built, if requested. */
+    if UNLIKELY(!QueueResampleCache(device, ALBuf))
+        SETERR_RETURN(context, AL_OUT_OF_MEMORY,, "Failed to create resample cache for buffer %u",
+            ALBuf->id);
+}
+
+/** Decodes sample frames from a buffer's file stream, for file-backed buffers. */
+ALsizei AL_APIENTRY FileStreamCallback(ALvoid *userptr, ALvoid *sampledata, ALsizei numbytes)
+{
+    auto *stream = static_cast<FileStream*>(userptr);
+    const size_t frames{static_cast<ALuint>(numbytes) / stream->mFrameSize};
+    const size_t got{stream->read(static_cast<al::byte*>(sampledata), frames)};
+    return static_cast<ALsizei>(got * stream->mFrameSize);
 }
 
-/** Prepares the buffer to use the specified callback, using the specified format. */
+/**
+ * Prepares the buffer to use the specified callback, using the specified
+ * format. File-backed buffers also pass the stream the callback reads from.
+ */
 void PrepareCallback(ALCcontext *context, ALbuffer *ALBuf, ALsizei freq,
     UserFmtChannels SrcChannels, UserFmtType SrcType, LPALBUFFERCALLBACKTYPESOFT callback,
-    void *userptr)
+    void *userptr, ALuint prefetch, std::unique_ptr<FileStream> stream)
 {
     if UNLIKELY(ReadRef(ALBuf->ref) != 0 || ALBuf->MappedAccess != 0)
         SETERR_RETURN(context, AL_INVALID_OPERATION,, "Modifying callback for in-use buffer %u",
@@ -604,8 +712,35 @@ void PrepareCallback(ALCcontext *context, ALbuffer *ALBuf, ALsizei freq,
     const ALuint ambiorder{(DstChannels == FmtBFormat2D || DstChannels == FmtBFormat3D) ?
         ALBuf->UnpackAmbiOrder : 0};
 
-    al::vector<al::byte,16>(FrameSizeFromFmt(DstChannels, DstType, ambiorder) *
-        size_t{BUFFERSIZE + (MAX_RESAMPLER_PADDING>>1)}).swap(ALBuf->mData);
+    ALCdevice *device{context->mDevice.get()};
+    ClearCallbackPrefetch(device, ALBuf);
+    ClearResampleCache(device, ALBuf);
+    al::vector<float,16>{}.swap(ALBuf->mResampledData);
+
+    /* A prefetching callback gets a ring of at least the requested size, and
+     * no less than what the mixer may need for an update. Otherwise, the mixer
+     * calls the callback to fill the buffer's storage directly.
+     */
+    const ALuint framesize{FrameSizeFromFmt(DstChannels, DstType, ambiorder)};
+    const size_t minsize{BUFFERSIZE + (MAX_RESAMPLER_PADDING>>1)};
+    if(prefetch > 0)
+    {
+        if(!device->mBufferWorker)
+        {
+            try {
+                device->mBufferWorker = std::make_unique<BufferWorker>();
+            }
+            catch(std::exception &e) {
+                SETERR_RETURN(context, AL_OUT_OF_MEMORY,,
+                    "Failed to start buffer worker thread: %s", e.what());
+            }
+        }
+        al::vector<al::byte,16>{}.swap(ALBuf->mData);
+        ALBuf->mCallbackRing = RingBuffer::Create(maxz(prefetch, minsize),
+            framesize, false);
+    }
+    else
+        al::vector<al::byte,16>(framesize * minsize).swap(ALBuf->mData);
 
     ALBuf->Callback = callback;
     ALBuf->UserData = userptr;
@@ -620,9 +755,17 @@ void PrepareCallback(ALCcontext *context, ALbuffer *ALBuf, ALsizei freq,
     ALBuf->Access = 0;
     ALBuf->AmbiOrder = ambiorder;
 
+    /* A file's length is known, allowing sources to set an offset into it. */
     ALBuf->SampleLen = 0;
+    if(stream)
+        ALBuf->SampleLen = static_cast<ALuint>(minu64(stream->mLength,
+            std::numeric_limits<ALint>::max()));
     ALBuf->LoopStart = 0;
     ALBuf->LoopEnd = ALBuf->SampleLen;
+    ALBuf->mFileStream = std::move(stream);
+
+    if(ALBuf->mCallbackRing)
+        device->mBufferWorker->addCallback(ALBuf);
 }
 
 
@@ -1017,6 +1160,11 @@ START_API_FUNC
             size_t byteoff{static_cast<ALuint>(offset)/byte_align * align * frame_size};
             size_t samplen{static_cast<ALuint>(length)/byte_align * align};
 
+            /* Any resample cache is now out of date, and gets rebuilt after
+             * the new data is in.
+             */
+            ClearResampleCache(device, albuf);
+
             void *dst = albuf->mData.data() + byteoff;
             if(usrfmt->type == UserFmtIMA4 && albuf->mFmtType == FmtShort)
                 Convert_int16_ima4(static_cast<int16_t*>(dst), static_cast<const al::byte*>(data),
@@ -1029,6 +1177,10 @@ START_API_FUNC
                 assert(long{usrfmt->type} == long{albuf->mFmtType});
                 memcpy(dst, data, size_t{samplen} * frame_size);
             }
+
+            if UNLIKELY(!QueueResampleCache(device, albuf))
+                context->setError(AL_OUT_OF_MEMORY,
+                    "Failed to create resample cache for buffer %u", albuf->id);
         }
     }
 }
@@ -1197,6 +1349,26 @@ START_API_FUNC
             albuf->UnpackAmbiOrder = static_cast<ALuint>(value);
         break;
 
+    case AL_BUFFER_CALLBACK_PREFETCH_SOFT:
+        if UNLIKELY(value < 0)
+            context->setError(AL_INVALID_VALUE, "Invalid callback prefetch size %d", value);
+        else
+            albuf->CallbackPrefetch = static_cast<ALuint>(value);
+        break;
+
+    case AL_BUFFER_RESAMPLE_CACHE_SOFT:
+        if UNLIKELY(value != AL_FALSE && value != AL_TRUE)
+            context->setError(AL_INVALID_VALUE, "Invalid resample cache value %d", value);
+        else if(albuf->ResampleCache != (value != AL_FALSE))
+        {
+            /* Build or drop the cache for any data already loaded. */
+            albuf->ResampleCache = value != AL_FALSE;
+            if UNLIKELY(!QueueResampleCache(device, albuf))
+                context->setError(AL_OUT_OF_MEMORY,
+                    "Failed to create resample cache for buffer %u", albuf->id);
+        }
+        break;
+
     default:
         context->setError(AL_INVALID_ENUM, "Invalid buffer integer property 0x%04x", param);
     }
@@ -1235,6 +1407,8 @@ START_API_FUNC
         case AL_AMBISONIC_LAYOUT_SOFT:
         case AL_AMBISONIC_SCALING_SOFT:
         case AL_UNPACK_AMBISONIC_ORDER_SOFT:
+        case AL_BUFFER_CALLBACK_PREFETCH_SOFT:
+        case AL_BUFFER_RESAMPLE_CACHE_SOFT:
             alBufferi(buffer, param, values[0]);
             return;
         }
@@ -1398,6 +1572,14 @@ START_API_FUNC
         *value = static_cast<int>(albuf->UnpackAmbiOrder);
         break;
 
+    case AL_BUFFER_CALLBACK_PREFETCH_SOFT:
+        *value = static_cast<int>(albuf->CallbackPrefetch);
+        break;
+
+    case AL_BUFFER_RESAMPLE_CACHE_SOFT:
+        *value = albuf->ResampleCache ? AL_TRUE : AL_FALSE;
+        break;
+
     default:
         context->setError(AL_INVALID_ENUM, "Invalid buffer integer property 0x%04x", param);
     }
@@ -1441,6 +1623,8 @@ START_API_FUNC
     case AL_AMBISONIC_LAYOUT_SOFT:
     case AL_AMBISONIC_SCALING_SOFT:
     case AL_UNPACK_AMBISONIC_ORDER_SOFT:
+    case AL_BUFFER_CALLBACK_PREFETCH_SOFT:
+    case AL_BUFFER_RESAMPLE_CACHE_SOFT:
         alGetBufferi(buffer, param, values);
         return;
     }
@@ -1495,7 +1679,46 @@ START_API_FUNC
             context->setError(AL_INVALID_ENUM, "Invalid format 0x%04x", format);
         else
             PrepareCallback(context.get(), albuf, freq, usrfmt->channels, usrfmt->type, callback,
-                userptr);
+                userptr, albuf->CallbackPrefetch, nullptr);
+    }
+}
+END_API_FUNC
+
+AL_API void AL_APIENTRY alBufferFileSOFT(ALuint buffer, const ALchar *filename)
+START_API_FUNC
+{
+    ContextRef context{GetContextRef()};
+    if UNLIKELY(!context) return;
+
+    /* Open the file and read its header before taking the buffer lock, so
+     * other buffer calls aren't held up by the file I/O.
+     */
+    std::unique_ptr<FileStream> stream;
+    if(filename)
+        stream = FileStream::Open(filename);
+
+    ALCdevice *device{context->mDevice.get()};
+    std::lock_guard<std::mutex> _{device->BufferLock};
+
+    ALbuffer *albuf = LookupBuffer(device, buffer);
+    if UNLIKELY(!albuf)
+        context->setError(AL_INVALID_NAME, "Invalid buffer ID %u", buffer);
+    else if UNLIKELY(!filename)
+        context->setError(AL_INVALID_VALUE, "NULL filename");
+    else if UNLIKELY(!stream)
+        context->setError(AL_INVALID_VALUE, "Failed to open %s for streaming", filename);
+    else
+    {
+        /* Files are always decoded ahead on the prefetch thread, with at least
+         * half a second buffered.
+         */
+        const ALuint prefetch{maxu(albuf->CallbackPrefetch, stream->mSampleRate/2)};
+        const auto rate = static_cast<ALsizei>(stream->mSampleRate);
+        const auto channels = static_cast<UserFmtChannels>(stream->mChannels);
+        const auto type = static_cast<UserFmtType>(stream->mType);
+        void *userptr{stream.get()};
+        PrepareCallback(context.get(), albuf, rate, channels, type, FileStreamCallback, userptr,
+            prefetch, std::move(stream));
     }
 }
 END_API_FUNC
@@ -1608,6 +1831,203 @@ ALuint ChannelsFromFmt(FmtChannels chans, ALuint ambiorder) noexcept
 }
 
 
+BufferWorker::BufferWorker()
+{ mThread = std::thread{std::mem_fn(&BufferWorker::run), this}; }
+
+BufferWorker::~BufferWorker()
+{
+    mKillNow.store(true, std::memory_order_release);
+    mSem.post();
+    mThread.join();
+}
+
+void BufferWorker::addCallback(ALbuffer *buffer)
+{
+    {
+        std::lock_guard<std::mutex> _{mBufferLock};
+        mBuffers.emplace_back(buffer);
+    }
+    mSem.post();
+}
+
+void BufferWorker::removeCallback(ALbuffer *buffer)
+{
+    /* The lock is held while filling, so the buffer isn't in use once it's
+     * removed.
+     */
+    std::lock_guard<std::mutex> _{mBufferLock};
+    auto iter = std::find(mBuffers.begin(), mBuffers.end(), buffer);
+    if(iter != mBuffers.end())
+        mBuffers.erase(iter);
+}
+
+void BufferWorker::addResample(ALbuffer *buffer)
+{
+    {
+        std::lock_guard<std::mutex> _{mBufferLock};
+        mResampleJobs.emplace_back(ResampleJob{buffer, {}, 0u, 0u});
+    }
+    mSem.post();
+}
+
+void BufferWorker::removeResample(ALbuffer *buffer)
+{
+    std::lock_guard<std::mutex> _{mBufferLock};
+    auto iter = std::find_if(mResampleJobs.begin(), mResampleJobs.end(),
+        [buffer](const ResampleJob &job) noexcept -> bool { return job.mBuffer == buffer; });
+    if(iter != mResampleJobs.end())
+        mResampleJobs.erase(iter);
+}
+
+void BufferWorker::resampleNext()
+{
+    /* Resample a limited amount at a time, so callbacks can be kept filled
+     * and jobs removed without much delay.
+     */
+    static constexpr ALuint ResampleChunkSize{BUFFERSIZE * 16};
+    static constexpr ALuint Padding{MAX_RESAMPLER_PADDING >> 1};
+
+    ResampleJob &job = mResampleJobs.front();
+    ALbuffer *buffer{job.mBuffer};
+    const ALuint step{buffer->mResampledStep};
+    const ALuint len{buffer->mResampledLen};
+    if(job.mSrc.empty())
+    {
+        /* Load the channel as floats, with silence on either end for the
+         * resampler.
+         */
+        const size_t numchans{buffer->channelsFromFmt()};
+        const size_t samplesize{buffer->bytesFromFmt()};
+        job.mSrc.resize(buffer->SampleLen + Padding*2 + 1, 0.0f);
+        LoadSamples(&job.mSrc[Padding], buffer->mData.data() + job.mChannel*samplesize,
+            numchans, buffer->mFmtType, buffer->SampleLen);
+    }
+
+    /* Always use the best resampler for the cache. */
+    InterpState state;
+    ResamplerFunc resample{PrepareResampler(Resampler::BSinc24, step, &state)};
+
+    const ALuint todo{minu(len - job.mDone, ResampleChunkSize)};
+    const uint64_t pos{uint64_t{job.mDone} * step};
+    float *dst{&buffer->mResampledData[size_t{job.mChannel}*len + job.mDone]};
+    const float *out{resample(&state, &job.mSrc[Padding + (pos>>FRACTIONBITS)],
+        static_cast<ALuint>(pos&FRACTIONMASK), step, {dst, todo})};
+    if(out != dst) std::copy_n(out, todo, dst);
+
+    job.mDone += todo;
+    if(job.mDone < len)
+        return;
+
+    job.mDone = 0;
+    job.mSrc.clear();
+    if(++job.mChannel < buffer->channelsFromFmt())
+        return;
+
+    TRACE("Built resample cache for buffer %u (%u -> %u samples)\n", buffer->id,
+        buffer->SampleLen, len);
+    buffer->mResampledReady.store(true, std::memory_order_release);
+    mResampleJobs.erase(mResampleJobs.begin());
+}
+
+void BufferWorker::fillCallback(ALbuffer *buffer)
+{
+    RingBuffer *ring{buffer->mCallbackRing.get()};
+    if(buffer->mCallbackRestart.load(std::memory_order_acquire))
+    {
+        /* The mixer leaves the ring alone until the restart is cleared, so
+         * it's safe to reset here. What's there is kept if none of it has been
+         * played yet (and for files, it starts where the voice does), as when
+         * first playing after being prefetched. Refill it before letting the
+         * mixer have it back, to avoid an underrun.
+         */
+        FileStream *stream{buffer->mFileStream.get()};
+        const ALuint pos{buffer->mCallbackRestartPos};
+        if(ring->readSpace() != buffer->mCallbackWritten
+            || (stream && pos != buffer->mCallbackStartPos))
+        {
+            ring->reset();
+            buffer->mCallbackWritten = 0;
+            if(stream)
+            {
+                if(!stream->seek(pos))
+                    ERR("Failed to seek buffer %u to %u\n", buffer->id, pos);
+                buffer->mCallbackStartPos = pos;
+            }
+        }
+        buffer->mCallbackEnded.store(false, std::memory_order_relaxed);
+        fillRing(buffer);
+        buffer->mCallbackRestart.store(false, std::memory_order_release);
+        return;
+    }
+    if(buffer->mCallbackEnded.load(std::memory_order_relaxed))
+        return;
+    fillRing(buffer);
+}
+
+void BufferWorker::fillRing(ALbuffer *buffer)
+{
+    RingBuffer *ring{buffer->mCallbackRing.get()};
+    FileStream *stream{buffer->mFileStream.get()};
+    const size_t framesize{buffer->frameSizeFromFmt()};
+    bool rewound{false};
+    bool more{true};
+    while(more)
+    {
+        more = false;
+        auto data = ring->getWriteVector();
+        for(auto &seg : {data.first, data.second})
+        {
+            if(seg.len == 0) break;
+
+            const size_t needBytes{seg.len * framesize};
+            const ALsizei gotBytes{buffer->Callback(buffer->UserData, seg.buf,
+                static_cast<ALsizei>(needBytes))};
+            const size_t gotFrames{(gotBytes > 0) ? static_cast<size_t>(gotBytes)/framesize : 0};
+            ring->writeAdvance(gotFrames);
+            buffer->mCallbackWritten += gotFrames;
+            if(gotFrames < seg.len)
+            {
+                /* A short return means the callback has no more data, unless
+                 * a looping file can start over (and isn't failing to read
+                 * anything after doing so).
+                 */
+                rewound = rewound && gotFrames == 0;
+                if(stream && !rewound && buffer->mCallbackLoop.load(std::memory_order_relaxed)
+                    && stream->rewind())
+                    rewound = more = true;
+                else
+                    buffer->mCallbackEnded.store(true, std::memory_order_release);
+                break;
+            }
+            rewound = false;
+        }
+    }
+}
+
+int BufferWorker::run()
+{
+    althrd_setname(BUFFER_THREAD_NAME);
+
+    while(!mKillNow.load(std::memory_order_acquire))
+    {
+        bool pending{false};
+        {
+            std::lock_guard<std::mutex> _{mBufferLock};
+            for(ALbuffer *buffer : mBuffers)
+                fillCallback(buffer);
+            if(!mResampleJobs.empty())
+            {
+                resampleNext();
+                pending = !mResampleJobs.empty();
+            }
+        }
+        if(!pending)
+            mSem.wait();
+    }
+    return 0;
+}
+
+
 BufferSubList::~BufferSubList()
 {
     uint64_t usemask{~FreeMask};
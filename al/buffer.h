@@ -2,6 +2,11 @@
 #define AL_BUFFER_H
 
 #include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
 
 #include "AL/al.h"
 
@@ -9,6 +14,8 @@
 #include "almalloc.h"
 #include "atomic.h"
 #include "inprogext.h"
+#include "ringbuffer.h"
+#include "threads.h"
 #include "vector.h"
 
 
@@ -62,6 +69,12 @@ ALuint ChannelsFromFmt(FmtChannels chans, ALuint ambiorder) noexcept;
 inline ALuint FrameSizeFromFmt(FmtChannels chans, FmtType type, ALuint ambiorder) noexcept
 { return ChannelsFromFmt(chans, ambiorder) * BytesFromFmt(type); }
 
+/* Decodes a block of 'align' sample frames to interleaved 16-bit samples. */
+void DecodeIMA4Block(int16_t *dst, const al::byte *src, size_t numchans, size_t align);
+void DecodeMSADPCMBlock(int16_t *dst, const al::byte *src, size_t numchans, size_t align);
+
+class FileStream;
+
 
 struct ALbuffer {
     al::vector<al::byte,16> mData;
@@ -85,6 +98,47 @@ struct ALbuffer {
     LPALBUFFERCALLBACKTYPESOFT Callback{nullptr};
     void *UserData{nullptr};
 
+    /* The requested prefetch size (in sample frames) for callbacks. When set,
+     * the callback is called from a worker thread to fill mCallbackRing ahead
+     * of the mixer, and mCallbackEnded is set once it returns short.
+     *
+     * A voice starting to play the buffer sets mCallbackRestart from the
+     * mixer, and leaves the ring alone until the worker clears it. The worker
+     * discards what was prefetched (unless none of it was played yet) and
+     * clears mCallbackEnded before refilling, so the callback gets called
+     * again like it would be without prefetching. mCallbackWritten counts the
+     * frames written since the ring was last reset, for the worker to tell if
+     * any were played.
+     */
+    ALuint CallbackPrefetch{0u};
+    RingBufferPtr mCallbackRing;
+    std::atomic<bool> mCallbackEnded{false};
+    std::atomic<bool> mCallbackRestart{false};
+    size_t mCallbackWritten{0u};
+
+    /* The file decoded by the callback for file-backed buffers. These have a
+     * known length, and restart from mCallbackRestartPos (the voice's
+     * position, set with mCallbackRestart). mCallbackStartPos is where the
+     * ring was last reset from, and the worker loops the file while the
+     * playing voice has mCallbackLoop set.
+     */
+    std::unique_ptr<FileStream> mFileStream;
+    ALuint mCallbackRestartPos{0u};
+    ALuint mCallbackStartPos{0u};
+    std::atomic<bool> mCallbackLoop{false};
+
+    /* When set, a copy of the buffer resampled to the device rate is built in
+     * the background after loading, which voices playing at unit pitch can
+     * use instead of resampling. The samples are stored by channel, each
+     * mResampledLen long, with the cached sample i being at the buffer
+     * position i*mResampledStep.
+     */
+    bool ResampleCache{false};
+    al::vector<float,16> mResampledData;
+    ALuint mResampledLen{0u};
+    ALuint mResampledStep{0u};
+    std::atomic<bool> mResampledReady{false};
+
     ALuint LoopStart{0u};
     ALuint LoopEnd{0u};
 
@@ -110,4 +164,47 @@ struct ALbuffer {
     DISABLE_ALLOC()
 };
 
+
+/* Runs background work for a device's buffers on a worker thread: keeping the
+ * rings of prefetching callback buffers filled by calling their callbacks, and
+ * building resample caches a piece at a time.
+ */
+class BufferWorker {
+    struct ResampleJob {
+        ALbuffer *mBuffer;
+        /* The channel being resampled, as float samples with padding. */
+        al::vector<float,16> mSrc;
+        ALuint mChannel;
+        ALuint mDone;
+    };
+
+    std::mutex mBufferLock;
+    al::vector<ALbuffer*> mBuffers;
+    al::vector<ResampleJob> mResampleJobs;
+
+    al::semaphore mSem;
+    std::atomic<bool> mKillNow{false};
+    std::thread mThread;
+
+    void fillCallback(ALbuffer *buffer);
+    void fillRing(ALbuffer *buffer);
+    void resampleNext();
+    int run();
+
+public:
+    BufferWorker();
+    ~BufferWorker();
+
+    void addCallback(ALbuffer *buffer);
+    void removeCallback(ALbuffer *buffer);
+
+    void addResample(ALbuffer *buffer);
+    void removeResample(ALbuffer *buffer);
+
+    /** Wakes the worker to top up the rings. Safe to call from the mixer. */
+    void wake() { mSem.post(); }
+
+    DEF_NEWDEL(BufferWorker)
+};
+
 #endif
@@ -46,6 +46,14 @@ struct ALlistener {
         alu::Matrix Matrix;
         alu::Vector Velocity;
 
+        /* The untransformed properties, to tell what changed with an update
+         * (and when the listener only turned).
+         */
+        std::array<float,3> WorldPosition;
+        std::array<float,3> WorldVelocity;
+        std::array<float,3> OrientAt;
+        std::array<float,3> OrientUp;
+
         float Gain;
         float MetersPerUnit;
 
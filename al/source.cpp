@@ -140,6 +140,7 @@ void UpdateSourceProps(const ALsource *source, Voice *voice, ALCcontext *context
     props->StereoPan = source->StereoPan;
 
     props->Radius = source->Radius;
+    props->Priority = source->Priority;
 
     props->Direct.Gain = source->Direct.Gain;
     props->Direct.GainHF = source->Direct.GainHF;
@@ -160,13 +161,19 @@ void UpdateSourceProps(const ALsource *source, Voice *voice, ALCcontext *context
     };
     std::transform(source->Send.cbegin(), source->Send.cend(), props->Send, copy_send);
 
+    props->mSubmix = source->mSubmixTarget ? source->mSubmixTarget->mSubmixBus.get() : nullptr;
+    if(props->mSubmix)
+        IncrementRef(props->mSubmix->mVoiceRef);
+
     /* Set the new container for updating internal parameters. */
     props = voice->mUpdate.exchange(props, std::memory_order_acq_rel);
     if(props)
     {
         /* If there was an unused update container, put it back in the
-         * freelist.
+         * freelist. The voice never used its bus.
          */
+        if(props->mSubmix)
+            DecrementRef(props->mSubmix->mVoiceRef);
         AtomicReplaceHead(context->mFreeVoiceProps, props);
     }
 }
@@ -200,7 +207,7 @@ int64_t GetSourceSampleOffset(ALsource *Source, ALCcontext *context, nanoseconds
         std::atomic_thread_fence(std::memory_order_acquire);
     } while(refcount != device->MixCount.load(std::memory_order_relaxed));
 
-    if(!voice)
+    if(!voice || !Source->queue)
         return 0;
 
     const ALbufferlistitem *BufferList{Source->queue};
@@ -239,7 +246,7 @@ double GetSourceSecOffset(ALsource *Source, ALCcontext *context, nanoseconds *cl
         std::atomic_thread_fence(std::memory_order_acquire);
     } while(refcount != device->MixCount.load(std::memory_order_relaxed));
 
-    if(!voice)
+    if(!voice || !Source->queue)
         return 0.0f;
 
     const ALbufferlistitem *BufferList{Source->queue};
@@ -288,7 +295,7 @@ double GetSourceOffset(ALsource *Source, ALenum name, ALCcontext *context)
         std::atomic_thread_fence(std::memory_order_acquire);
     } while(refcount != device->MixCount.load(std::memory_order_relaxed));
 
-    if(!voice)
+    if(!voice || !Source->queue)
         return 0.0;
 
     const ALbufferlistitem *BufferList{Source->queue};
@@ -440,17 +447,43 @@ void InitVoice(Voice *voice, ALsource *source, ALbufferlistitem *BufferList, ALC
 {
     voice->mLoopBuffer.store(source->Looping ? source->queue : nullptr, std::memory_order_relaxed);
 
-    ALbuffer *buffer{BufferList->mBuffer};
-    ALuint num_channels{buffer->channelsFromFmt()};
-    voice->mFrequency = buffer->Frequency;
-    voice->mFmtChannels = buffer->mFmtChannels;
-    voice->mSampleSize  = buffer->bytesFromFmt();
-    voice->mAmbiLayout = static_cast<AmbiLayout>(buffer->AmbiLayout);
-    voice->mAmbiScaling = static_cast<AmbiNorm>(buffer->AmbiScaling);
-    voice->mAmbiOrder = buffer->AmbiOrder;
-
-    if(buffer->Callback) voice->mFlags |= VOICE_IS_CALLBACK;
-    else if(source->SourceType == AL_STATIC) voice->mFlags |= VOICE_IS_STATIC;
+    ALuint num_channels;
+    if(SubmixBus *bus{source->mSubmixBus.get()})
+    {
+        /* Submix bus lines are float samples at the device rate, with a
+         * first-order ambisonic bus using ACN/N3D.
+         */
+        num_channels = static_cast<ALuint>(bus->mBuffer.size());
+        voice->mFrequency = device->Frequency;
+        voice->mFmtChannels = bus->mFmtChannels;
+        voice->mSampleSize = sizeof(float);
+        voice->mAmbiLayout = AmbiLayout::ACN;
+        voice->mAmbiScaling = AmbiNorm::N3D;
+        voice->mAmbiOrder = (bus->mFmtChannels == FmtBFormat3D) ? 1 : 0;
+
+        voice->mFlags |= VOICE_IS_BUS;
+        voice->mSubmixInput = bus;
+    }
+    else
+    {
+        ALbuffer *buffer{BufferList->mBuffer};
+        num_channels = buffer->channelsFromFmt();
+        voice->mFrequency = buffer->Frequency;
+        voice->mFmtChannels = buffer->mFmtChannels;
+        voice->mSampleSize  = buffer->bytesFromFmt();
+        voice->mAmbiLayout = static_cast<AmbiLayout>(buffer->AmbiLayout);
+        voice->mAmbiScaling = static_cast<AmbiNorm>(buffer->AmbiScaling);
+        voice->mAmbiOrder = buffer->AmbiOrder;
+
+        if(buffer->Callback)
+        {
+            voice->mFlags |= VOICE_IS_CALLBACK;
+            if(buffer->mCallbackRing)
+                voice->mFlags |= VOICE_CALLBACK_RESTART;
+        }
+        else if(source->SourceType == AL_STATIC) voice->mFlags |= VOICE_IS_STATIC;
+        voice->mSubmixInput = nullptr;
+    }
     voice->mNumCallbackSamples = 0;
 
     /* Clear the stepping value explicitly so the mixer knows not to mix this
@@ -462,6 +495,7 @@ void InitVoice(Voice *voice, ALsource *source, ALbufferlistitem *BufferList, ALC
         al::vector<Voice::ChannelData>{}.swap(voice->mChans);
     voice->mChans.reserve(maxu(2, num_channels));
     voice->mChans.resize(num_channels);
+    voice->initMixState(device);
 
     /* Don't need to set the VOICE_IS_AMBISONIC flag if the device is not
      * higher order than the voice. No HF scaling is necessary to mix it.
@@ -480,8 +514,6 @@ void InitVoice(Voice *voice, ALsource *source, ALbufferlistitem *BufferList, ALC
             chandata.mPrevSamples.fill(0.0f);
             chandata.mAmbiScale = scales[*(OrderFromChan++)];
             chandata.mAmbiSplitter = splitter;
-            chandata.mDryParams = DirectParams{};
-            std::fill_n(chandata.mWetParams.begin(), device->NumAuxSends, SendParams{});
         }
 
         voice->mFlags |= VOICE_IS_AMBISONIC;
@@ -490,11 +522,7 @@ void InitVoice(Voice *voice, ALsource *source, ALbufferlistitem *BufferList, ALC
     {
         /* Clear previous samples. */
         for(auto &chandata : voice->mChans)
-        {
             chandata.mPrevSamples.fill(0.0f);
-            chandata.mDryParams = DirectParams{};
-            std::fill_n(chandata.mWetParams.begin(), device->NumAuxSends, SendParams{});
-        }
     }
 
     if(device->AvgSpeakerDist > 0.0f)
@@ -551,6 +579,42 @@ void SendVoiceChanges(ALCcontext *ctx, VoiceChange *tail)
     }
 }
 
+/**
+ * Checks if a submix bus has members, or voices that may still mix into it.
+ * Voices release a bus when the mixer applies an update moving them off of
+ * it, while stopped voices that aren't in use anymore have theirs released
+ * here, along with any update they didn't get to apply.
+ */
+bool IsSubmixBusInUse(ALCcontext *context, ALsource *bus)
+{
+    if(ReadRef(bus->mSubmixRef) != 0)
+        return true;
+    SubmixBus *submix{bus->mSubmixBus.get()};
+    if(!submix || ReadRef(submix->mVoiceRef) == 0)
+        return false;
+
+    for(Voice *voice : context->getVoicesSpan())
+    {
+        if(voice->mPlayState.load(std::memory_order_acquire) != Voice::Stopped
+            || voice->mSourceID.load(std::memory_order_relaxed) != 0u
+            || voice->mPendingChange.load(std::memory_order_relaxed))
+            continue;
+
+        if(SubmixBus *oldbus{voice->mProps.mSubmix})
+        {
+            DecrementRef(oldbus->mVoiceRef);
+            voice->mProps.mSubmix = nullptr;
+        }
+        if(VoicePropsItem *props{voice->mUpdate.exchange(nullptr, std::memory_order_acq_rel)})
+        {
+            if(props->mSubmix)
+                DecrementRef(props->mSubmix->mVoiceRef);
+            AtomicReplaceHead(context->mFreeVoiceProps, props);
+        }
+    }
+    return ReadRef(submix->mVoiceRef) != 0;
+}
+
 
 bool SetVoiceOffset(Voice *oldvoice, const VoicePos &vpos, ALsource *source, ALCcontext *context,
     ALCdevice *device)
@@ -744,6 +808,14 @@ void FreeSource(ALCcontext *context, ALsource *source)
             SendVoiceChanges(context, vchg);
         }
     }
+    /* A bus's lines may still be getting read by the current mix. */
+    if(source->mSubmixBus)
+        context->mDevice->waitForMix();
+    /* The stopping voice keeps its own reference on the bus it mixes into,
+     * until it's no longer in use.
+     */
+    if(ALsource *bus{source->mSubmixTarget})
+        DecrementRef(bus->mSubmixRef);
 
     al::destroy_at(source);
 
@@ -859,6 +931,9 @@ enum SourceProp : ALenum {
     /* AL_EXT_SOURCE_RADIUS */
     srcRadius = AL_SOURCE_RADIUS,
 
+    /* AL_SOFT_source_priority */
+    srcPrioritySOFT = AL_SOURCE_PRIORITY_SOFT,
+
     /* AL_EXT_BFORMAT */
     srcOrientation = AL_ORIENTATION,
 
@@ -871,6 +946,10 @@ enum SourceProp : ALenum {
     /* ALC_SOFT_device_clock */
     srcSampleOffsetClockSOFT = AL_SAMPLE_OFFSET_CLOCK_SOFT,
     srcSecOffsetClockSOFT = AL_SEC_OFFSET_CLOCK_SOFT,
+
+    /* AL_SOFT_submix_bus */
+    srcSubmixFormatSOFT = AL_SUBMIX_FORMAT_SOFT,
+    srcSubmixBusSOFT = AL_SUBMIX_BUS_SOFT,
 };
 
 
@@ -909,6 +988,7 @@ ALuint FloatValsByProp(ALenum prop)
     case AL_BUFFERS_PROCESSED:
     case AL_SOURCE_TYPE:
     case AL_SOURCE_RADIUS:
+    case AL_SOURCE_PRIORITY_SOFT:
     case AL_SOURCE_RESAMPLER_SOFT:
     case AL_SOURCE_SPATIALIZE_SOFT:
         return 1;
@@ -931,6 +1011,8 @@ ALuint FloatValsByProp(ALenum prop)
     case AL_BUFFER:
     case AL_DIRECT_FILTER:
     case AL_AUXILIARY_SEND_FILTER:
+    case AL_SUBMIX_FORMAT_SOFT:
+    case AL_SUBMIX_BUS_SOFT:
         break; /* i/i64 only */
     case AL_SAMPLE_OFFSET_LATENCY_SOFT:
     case AL_SAMPLE_OFFSET_CLOCK_SOFT:
@@ -971,6 +1053,7 @@ ALuint DoubleValsByProp(ALenum prop)
     case AL_BUFFERS_PROCESSED:
     case AL_SOURCE_TYPE:
     case AL_SOURCE_RADIUS:
+    case AL_SOURCE_PRIORITY_SOFT:
     case AL_SOURCE_RESAMPLER_SOFT:
     case AL_SOURCE_SPATIALIZE_SOFT:
         return 1;
@@ -991,6 +1074,8 @@ ALuint DoubleValsByProp(ALenum prop)
     case AL_BUFFER:
     case AL_DIRECT_FILTER:
     case AL_AUXILIARY_SEND_FILTER:
+    case AL_SUBMIX_FORMAT_SOFT:
+    case AL_SUBMIX_BUS_SOFT:
         break; /* i/i64 only */
     case AL_SAMPLE_OFFSET_LATENCY_SOFT:
     case AL_SAMPLE_OFFSET_CLOCK_SOFT:
@@ -1145,7 +1230,8 @@ bool SetSourcefv(ALsource *Source, ALCcontext *Context, SourceProp prop, const a
 
         if(Voice *voice{GetSourceVoice(Source, Context)})
         {
-            if((voice->mFlags&VOICE_IS_CALLBACK))
+            /* Only file-backed callback buffers have a length to seek in. */
+            if((voice->mFlags&VOICE_IS_CALLBACK) && Source->queue->mSampleLen == 0)
                 SETERR_RETURN(Context, AL_INVALID_VALUE, false,
                     "Source offset for callback is invalid");
             auto vpos = GetSampleOffset(Source->queue, prop, values[0]);
@@ -1165,6 +1251,13 @@ bool SetSourcefv(ALsource *Source, ALCcontext *Context, SourceProp prop, const a
         Source->Radius = values[0];
         return UpdateSourceProps(Source, Context);
 
+    case AL_SOURCE_PRIORITY_SOFT:
+        CHECKSIZE(values, 1);
+        CHECKVAL(values[0] >= 0.0f && std::isfinite(values[0]));
+
+        Source->Priority = values[0];
+        return UpdateSourceProps(Source, Context);
+
     case AL_STEREO_ANGLES:
         CHECKSIZE(values, 2);
         CHECKVAL(std::isfinite(values[0]) && std::isfinite(values[1]));
@@ -1241,6 +1334,8 @@ bool SetSourcefv(ALsource *Source, ALCcontext *Context, SourceProp prop, const a
     case AL_AUXILIARY_SEND_FILTER:
     case AL_SAMPLE_OFFSET_LATENCY_SOFT:
     case AL_SAMPLE_OFFSET_CLOCK_SOFT:
+    case AL_SUBMIX_FORMAT_SOFT:
+    case AL_SUBMIX_BUS_SOFT:
         break;
     }
 
@@ -1314,6 +1409,9 @@ bool SetSourceiv(ALsource *Source, ALCcontext *Context, SourceProp prop, const a
         else if(buffer && buffer->Callback && ReadRef(buffer->ref) != 0)
             SETERR_RETURN(Context, AL_INVALID_OPERATION, false,
                 "Setting already-set callback buffer %u", buffer->id);
+        else if(buffer && Source->mSubmixBus)
+            SETERR_RETURN(Context, AL_INVALID_OPERATION, false,
+                "Setting buffer on submix bus source %u", Source->id);
         else
         {
             const ALenum state{GetSourceState(Source, GetSourceVoice(Source, Context))};
@@ -1362,7 +1460,8 @@ bool SetSourceiv(ALsource *Source, ALCcontext *Context, SourceProp prop, const a
 
         if(Voice *voice{GetSourceVoice(Source, Context)})
         {
-            if((voice->mFlags&VOICE_IS_CALLBACK))
+            /* Only file-backed callback buffers have a length to seek in. */
+            if((voice->mFlags&VOICE_IS_CALLBACK) && Source->queue->mSampleLen == 0)
                 SETERR_RETURN(Context, AL_INVALID_VALUE, false,
                     "Source offset for callback is invalid");
             auto vpos = GetSampleOffset(Source->queue, prop, values[0]);
@@ -1456,6 +1555,72 @@ bool SetSourceiv(ALsource *Source, ALCcontext *Context, SourceProp prop, const a
         Source->mSpatialize = static_cast<SpatializeMode>(values[0]);
         return UpdateSourceProps(Source, Context);
 
+    case AL_SUBMIX_FORMAT_SOFT:
+        CHECKSIZE(values, 1);
+        {
+            FmtChannels chans{};
+            size_t numlines{0};
+            switch(values[0])
+            {
+            case AL_NONE: break;
+            case AL_FORMAT_MONO_FLOAT32: chans = FmtMono; numlines = 1; break;
+            case AL_FORMAT_STEREO_FLOAT32: chans = FmtStereo; numlines = 2; break;
+            case AL_FORMAT_BFORMAT3D_FLOAT32: chans = FmtBFormat3D; numlines = 4; break;
+            default:
+                SETERR_RETURN(Context, AL_INVALID_VALUE, false, "Invalid submix format 0x%04x",
+                    values[0]);
+            }
+
+            const ALenum state{GetSourceState(Source, GetSourceVoice(Source, Context))};
+            if(state == AL_PLAYING || state == AL_PAUSED)
+                SETERR_RETURN(Context, AL_INVALID_OPERATION, false,
+                    "Setting submix format on playing or paused source %u", Source->id);
+            if(Source->queue)
+                SETERR_RETURN(Context, AL_INVALID_OPERATION, false,
+                    "Setting submix format on source %u with buffers", Source->id);
+            if(Source->mSubmixTarget)
+                SETERR_RETURN(Context, AL_INVALID_OPERATION, false,
+                    "Setting submix format on submix bus member %u", Source->id);
+            if(IsSubmixBusInUse(Context, Source))
+                SETERR_RETURN(Context, AL_INVALID_OPERATION, false,
+                    "Setting submix format on in-use submix bus %u", Source->id);
+
+            /* A stopped bus voice fades out without reading the bus lines, so
+             * they can be freed once any current mix is done with them.
+             */
+            Context->mDevice->waitForMix();
+            if(numlines > 0)
+                Source->mSubmixBus = std::make_unique<SubmixBus>(chans, numlines);
+            else
+                Source->mSubmixBus = nullptr;
+            Source->mSubmixFormat = values[0];
+        }
+        return true;
+
+    case AL_SUBMIX_BUS_SOFT:
+        CHECKSIZE(values, 1);
+        {
+            ALsource *bus{nullptr};
+            if(values[0] && (bus=LookupSource(Context, static_cast<ALuint>(values[0]))) == nullptr)
+                SETERR_RETURN(Context, AL_INVALID_VALUE, false, "Invalid source ID %u",
+                    static_cast<ALuint>(values[0]));
+            if(bus && !bus->mSubmixBus)
+                SETERR_RETURN(Context, AL_INVALID_VALUE, false, "Source %u is not a submix bus",
+                    bus->id);
+            if(Source->mSubmixBus)
+                SETERR_RETURN(Context, AL_INVALID_OPERATION, false,
+                    "Routing submix bus %u to a submix bus", Source->id);
+
+            /* A playing voice keeps mixing into the old bus until the mixer
+             * applies the update, and holds a reference on it until then.
+             */
+            if(bus) IncrementRef(bus->mSubmixRef);
+            if(ALsource *oldbus{Source->mSubmixTarget})
+                DecrementRef(oldbus->mSubmixRef);
+            Source->mSubmixTarget = bus;
+        }
+        return UpdateSourceProps(Source, Context);
+
 
     case AL_AUXILIARY_SEND_FILTER:
         CHECKSIZE(values, 3);
@@ -1532,6 +1697,7 @@ bool SetSourceiv(ALsource *Source, ALCcontext *Context, SourceProp prop, const a
     case AL_AIR_ABSORPTION_FACTOR:
     case AL_ROOM_ROLLOFF_FACTOR:
     case AL_SOURCE_RADIUS:
+    case AL_SOURCE_PRIORITY_SOFT:
         CHECKSIZE(values, 1);
         fvals[0] = static_cast<float>(values[0]);
         return SetSourcefv(Source, Context, prop, {fvals, 1u});
@@ -1600,6 +1766,7 @@ bool SetSourcei64v(ALsource *Source, ALCcontext *Context, SourceProp prop, const
     case AL_DISTANCE_MODEL:
     case AL_SOURCE_RESAMPLER_SOFT:
     case AL_SOURCE_SPATIALIZE_SOFT:
+    case AL_SUBMIX_FORMAT_SOFT:
         CHECKSIZE(values, 1);
         CHECKVAL(values[0] <= INT_MAX && values[0] >= INT_MIN);
 
@@ -1609,6 +1776,7 @@ bool SetSourcei64v(ALsource *Source, ALCcontext *Context, SourceProp prop, const
     /* 1x uint */
     case AL_BUFFER:
     case AL_DIRECT_FILTER:
+    case AL_SUBMIX_BUS_SOFT:
         CHECKSIZE(values, 1);
         CHECKVAL(values[0] <= UINT_MAX && values[0] >= 0);
 
@@ -1642,6 +1810,7 @@ bool SetSourcei64v(ALsource *Source, ALCcontext *Context, SourceProp prop, const
     case AL_AIR_ABSORPTION_FACTOR:
     case AL_ROOM_ROLLOFF_FACTOR:
     case AL_SOURCE_RADIUS:
+    case AL_SOURCE_PRIORITY_SOFT:
         CHECKSIZE(values, 1);
         fvals[0] = static_cast<float>(values[0]);
         return SetSourcefv(Source, Context, prop, {fvals, 1u});
@@ -1777,6 +1946,11 @@ bool GetSourcedv(ALsource *Source, ALCcontext *Context, SourceProp prop, const a
         values[0] = Source->Radius;
         return true;
 
+    case AL_SOURCE_PRIORITY_SOFT:
+        CHECKSIZE(values, 1);
+        values[0] = Source->Priority;
+        return true;
+
     case AL_STEREO_ANGLES:
         CHECKSIZE(values, 2);
         values[0] = Source->StereoPan[0];
@@ -1867,6 +2041,8 @@ bool GetSourcedv(ALsource *Source, ALCcontext *Context, SourceProp prop, const a
     case AL_AUXILIARY_SEND_FILTER:
     case AL_SAMPLE_OFFSET_LATENCY_SOFT:
     case AL_SAMPLE_OFFSET_CLOCK_SOFT:
+    case AL_SUBMIX_FORMAT_SOFT:
+    case AL_SUBMIX_BUS_SOFT:
         break;
     }
 
@@ -1993,6 +2169,16 @@ bool GetSourceiv(ALsource *Source, ALCcontext *Context, SourceProp prop, const a
         values[0] = static_cast<int>(Source->mSpatialize);
         return true;
 
+    case AL_SUBMIX_FORMAT_SOFT:
+        CHECKSIZE(values, 1);
+        values[0] = Source->mSubmixFormat;
+        return true;
+
+    case AL_SUBMIX_BUS_SOFT:
+        CHECKSIZE(values, 1);
+        values[0] = Source->mSubmixTarget ? static_cast<int>(Source->mSubmixTarget->id) : 0;
+        return true;
+
     /* 1x float/double */
     case AL_CONE_INNER_ANGLE:
     case AL_CONE_OUTER_ANGLE:
@@ -2012,6 +2198,7 @@ bool GetSourceiv(ALsource *Source, ALCcontext *Context, SourceProp prop, const a
     case AL_ROOM_ROLLOFF_FACTOR:
     case AL_CONE_OUTER_GAINHF:
     case AL_SOURCE_RADIUS:
+    case AL_SOURCE_PRIORITY_SOFT:
         CHECKSIZE(values, 1);
         if((err=GetSourcedv(Source, Context, prop, {dvals, 1u})) != false)
             values[0] = static_cast<int>(dvals[0]);
@@ -2121,6 +2308,7 @@ bool GetSourcei64v(ALsource *Source, ALCcontext *Context, SourceProp prop, const
     case AL_ROOM_ROLLOFF_FACTOR:
     case AL_CONE_OUTER_GAINHF:
     case AL_SOURCE_RADIUS:
+    case AL_SOURCE_PRIORITY_SOFT:
         CHECKSIZE(values, 1);
         if((err=GetSourcedv(Source, Context, prop, {dvals, 1u})) != false)
             values[0] = static_cast<int64_t>(dvals[0]);
@@ -2167,6 +2355,7 @@ bool GetSourcei64v(ALsource *Source, ALCcontext *Context, SourceProp prop, const
     case AL_DISTANCE_MODEL:
     case AL_SOURCE_RESAMPLER_SOFT:
     case AL_SOURCE_SPATIALIZE_SOFT:
+    case AL_SUBMIX_FORMAT_SOFT:
         CHECKSIZE(values, 1);
         if((err=GetSourceiv(Source, Context, prop, {ivals, 1u})) != false)
             values[0] = ivals[0];
@@ -2175,6 +2364,7 @@ bool GetSourcei64v(ALsource *Source, ALCcontext *Context, SourceProp prop, const
     /* 1x uint */
     case AL_BUFFER:
     case AL_DIRECT_FILTER:
+    case AL_SUBMIX_BUS_SOFT:
         CHECKSIZE(values, 1);
         if((err=GetSourceiv(Source, Context, prop, {ivals, 1u})) != false)
             values[0] = static_cast<ALuint>(ivals[0]);
@@ -2270,6 +2460,16 @@ START_API_FUNC
         return;
     }
 
+    /* Check that no submix buses are still in use. */
+    auto bus_in_use = [&context](const ALuint sid) -> bool
+    { return IsSubmixBusInUse(context.get(), LookupSource(context.get(), sid)); };
+    invsrc = std::find_if(sources, sources_end, bus_in_use);
+    if UNLIKELY(invsrc != sources_end)
+    {
+        context->setError(AL_INVALID_OPERATION, "Deleting in-use submix bus %u", *invsrc);
+        return;
+    }
+
     /* All good. Delete source IDs. */
     auto delete_source = [&context](const ALuint sid) -> void
     {
@@ -2863,8 +3063,10 @@ START_API_FUNC
             BufferList = BufferList->mNext.load(std::memory_order_relaxed);
         }
 
-        /* If there's nothing to play, go right to stopped. */
-        if UNLIKELY(!BufferList)
+        /* If there's nothing to play, go right to stopped. Submix buses play
+         * their members' mix instead of buffers.
+         */
+        if UNLIKELY(!BufferList && !source->mSubmixBus)
         {
             /* NOTE: A source without any playable buffers should not have a
              * Voice since it shouldn't be in a playing or paused state. So
@@ -3186,6 +3388,8 @@ START_API_FUNC
     /* Can't queue on a Static Source */
     if UNLIKELY(source->SourceType == AL_STATIC)
         SETERR_RETURN(context, AL_INVALID_OPERATION,, "Queueing onto static source %u", src);
+    if UNLIKELY(source->mSubmixBus)
+        SETERR_RETURN(context, AL_INVALID_OPERATION,, "Queueing onto submix bus source %u", src);
 
     /* Check for a valid Buffer, for its frequency and format */
     ALCdevice *device{context->mDevice.get()};
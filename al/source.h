@@ -6,6 +6,7 @@
 #include <cstddef>
 #include <iterator>
 #include <limits>
+#include <memory>
 
 #include "AL/al.h"
 #include "AL/alc.h"
@@ -14,6 +15,7 @@
 #include "almalloc.h"
 #include "alnumeric.h"
 #include "alu.h"
+#include "atomic.h"
 #include "math_defs.h"
 #include "vector.h"
 
@@ -74,6 +76,11 @@ struct ALsource {
 
     float Radius{0.0f};
 
+    /* Scales how loud or near the source needs to be to keep full rendering
+     * quality, and to avoid spatial clustering.
+     */
+    float Priority{1.0f};
+
     /** Direct filter and auxiliary send info. */
     struct {
         float Gain;
@@ -108,6 +115,17 @@ struct ALsource {
     /** Source Buffer Queue head. */
     ALbufferlistitem *queue{nullptr};
 
+    /** Submix bus source this source mixes into. */
+    ALsource *mSubmixTarget{nullptr};
+
+    /**
+     * For a submix bus source, the bus its members mix into, and the number
+     * of sources targeting it.
+     */
+    std::unique_ptr<SubmixBus> mSubmixBus;
+    ALenum mSubmixFormat{AL_NONE};
+    RefCount mSubmixRef{0u};
+
     std::atomic_flag PropsClean;
 
     /* Index into the context's Voices array. Lazily updated, only checked and
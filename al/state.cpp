@@ -227,6 +227,21 @@ START_API_FUNC
         value = static_cast<int>(ResamplerDefault) ? AL_TRUE : AL_FALSE;
         break;
 
+    case AL_CLUSTERED_SOURCES_SOFT:
+        if(context->mClusteredSources.load(std::memory_order_relaxed) != 0)
+            value = AL_TRUE;
+        break;
+
+    case AL_ACTIVE_CLUSTERS_SOFT:
+        if(context->mActiveClusters.load(std::memory_order_relaxed) != 0)
+            value = AL_TRUE;
+        break;
+
+    case AL_LOAD_GOVERNOR_LEVEL_SOFT:
+        if(context->mDevice->mLoadLevel.load(std::memory_order_relaxed) != 0)
+            value = AL_TRUE;
+        break;
+
     default:
         context->setError(AL_INVALID_VALUE, "Invalid boolean property 0x%04x", pname);
     }
@@ -278,6 +293,18 @@ START_API_FUNC
         value = static_cast<ALdouble>(ResamplerDefault);
         break;
 
+    case AL_CLUSTERED_SOURCES_SOFT:
+        value = static_cast<ALdouble>(context->mClusteredSources.load(std::memory_order_relaxed));
+        break;
+
+    case AL_ACTIVE_CLUSTERS_SOFT:
+        value = static_cast<ALdouble>(context->mActiveClusters.load(std::memory_order_relaxed));
+        break;
+
+    case AL_LOAD_GOVERNOR_LEVEL_SOFT:
+        value = static_cast<ALdouble>(context->mDevice->mLoadLevel.load(std::memory_order_relaxed));
+        break;
+
     default:
         context->setError(AL_INVALID_VALUE, "Invalid double property 0x%04x", pname);
     }
@@ -329,6 +356,18 @@ START_API_FUNC
         value = static_cast<ALfloat>(ResamplerDefault);
         break;
 
+    case AL_CLUSTERED_SOURCES_SOFT:
+        value = static_cast<ALfloat>(context->mClusteredSources.load(std::memory_order_relaxed));
+        break;
+
+    case AL_ACTIVE_CLUSTERS_SOFT:
+        value = static_cast<ALfloat>(context->mActiveClusters.load(std::memory_order_relaxed));
+        break;
+
+    case AL_LOAD_GOVERNOR_LEVEL_SOFT:
+        value = static_cast<ALfloat>(context->mDevice->mLoadLevel.load(std::memory_order_relaxed));
+        break;
+
     default:
         context->setError(AL_INVALID_VALUE, "Invalid float property 0x%04x", pname);
     }
@@ -380,6 +419,18 @@ START_API_FUNC
         value = static_cast<int>(ResamplerDefault);
         break;
 
+    case AL_CLUSTERED_SOURCES_SOFT:
+        value = static_cast<ALint>(context->mClusteredSources.load(std::memory_order_relaxed));
+        break;
+
+    case AL_ACTIVE_CLUSTERS_SOFT:
+        value = static_cast<ALint>(context->mActiveClusters.load(std::memory_order_relaxed));
+        break;
+
+    case AL_LOAD_GOVERNOR_LEVEL_SOFT:
+        value = static_cast<ALint>(context->mDevice->mLoadLevel.load(std::memory_order_relaxed));
+        break;
+
     default:
         context->setError(AL_INVALID_VALUE, "Invalid integer property 0x%04x", pname);
     }
@@ -431,6 +482,18 @@ START_API_FUNC
         value = static_cast<ALint64SOFT>(ResamplerDefault);
         break;
 
+    case AL_CLUSTERED_SOURCES_SOFT:
+        value = context->mClusteredSources.load(std::memory_order_relaxed);
+        break;
+
+    case AL_ACTIVE_CLUSTERS_SOFT:
+        value = context->mActiveClusters.load(std::memory_order_relaxed);
+        break;
+
+    case AL_LOAD_GOVERNOR_LEVEL_SOFT:
+        value = context->mDevice->mLoadLevel.load(std::memory_order_relaxed);
+        break;
+
     default:
         context->setError(AL_INVALID_VALUE, "Invalid integer64 property 0x%04x", pname);
     }
@@ -480,6 +543,9 @@ START_API_FUNC
             case AL_GAIN_LIMIT_SOFT:
             case AL_NUM_RESAMPLERS_SOFT:
             case AL_DEFAULT_RESAMPLER_SOFT:
+            case AL_CLUSTERED_SOURCES_SOFT:
+            case AL_ACTIVE_CLUSTERS_SOFT:
+            case AL_LOAD_GOVERNOR_LEVEL_SOFT:
                 values[0] = alGetBoolean(pname);
                 return;
         }
@@ -513,6 +579,9 @@ START_API_FUNC
             case AL_GAIN_LIMIT_SOFT:
             case AL_NUM_RESAMPLERS_SOFT:
             case AL_DEFAULT_RESAMPLER_SOFT:
+            case AL_CLUSTERED_SOURCES_SOFT:
+            case AL_ACTIVE_CLUSTERS_SOFT:
+            case AL_LOAD_GOVERNOR_LEVEL_SOFT:
                 values[0] = alGetDouble(pname);
                 return;
         }
@@ -546,6 +615,9 @@ START_API_FUNC
             case AL_GAIN_LIMIT_SOFT:
             case AL_NUM_RESAMPLERS_SOFT:
             case AL_DEFAULT_RESAMPLER_SOFT:
+            case AL_CLUSTERED_SOURCES_SOFT:
+            case AL_ACTIVE_CLUSTERS_SOFT:
+            case AL_LOAD_GOVERNOR_LEVEL_SOFT:
                 values[0] = alGetFloat(pname);
                 return;
         }
@@ -579,6 +651,9 @@ START_API_FUNC
             case AL_GAIN_LIMIT_SOFT:
             case AL_NUM_RESAMPLERS_SOFT:
             case AL_DEFAULT_RESAMPLER_SOFT:
+            case AL_CLUSTERED_SOURCES_SOFT:
+            case AL_ACTIVE_CLUSTERS_SOFT:
+            case AL_LOAD_GOVERNOR_LEVEL_SOFT:
                 values[0] = alGetInteger(pname);
                 return;
         }
@@ -612,6 +687,9 @@ START_API_FUNC
             case AL_GAIN_LIMIT_SOFT:
             case AL_NUM_RESAMPLERS_SOFT:
             case AL_DEFAULT_RESAMPLER_SOFT:
+            case AL_CLUSTERED_SOURCES_SOFT:
+            case AL_ACTIVE_CLUSTERS_SOFT:
+            case AL_LOAD_GOVERNOR_LEVEL_SOFT:
                 values[0] = alGetInteger64SOFT(pname);
                 return;
         }
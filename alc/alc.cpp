@@ -58,6 +58,7 @@
 #include "AL/efx.h"
 
 #include "al/auxeffectslot.h"
+#include "al/buffer.h"
 #include "al/effect.h"
 #include "al/event.h"
 #include "al/filter.h"
@@ -148,6 +149,9 @@
 #ifdef HAVE_WAVE
 #include "backends/wave.h"
 #endif
+#ifdef HAVE_SHM
+#include "backends/shm.h"
+#endif
 
 
 namespace {
@@ -213,6 +217,9 @@ BackendInfo BackendList[] = {
 #ifdef HAVE_WAVE
     { "wave", WaveBackendFactory::getFactory },
 #endif
+#ifdef HAVE_SHM
+    { "shm", ShmBackendFactory::getFactory },
+#endif
 };
 
 BackendFactory *PlaybackFactory{};
@@ -400,6 +407,7 @@ const struct {
     DECL(alGetPointervSOFT),
 
     DECL(alBufferCallbackSOFT),
+    DECL(alBufferFileSOFT),
     DECL(alGetBufferPtrSOFT),
     DECL(alGetBuffer3PtrSOFT),
     DECL(alGetBufferPtrvSOFT),
@@ -805,6 +813,18 @@ constexpr struct {
 
     DECL(AL_BUFFER_CALLBACK_FUNCTION_SOFT),
     DECL(AL_BUFFER_CALLBACK_USER_PARAM_SOFT),
+    DECL(AL_BUFFER_CALLBACK_PREFETCH_SOFT),
+    DECL(AL_BUFFER_RESAMPLE_CACHE_SOFT),
+
+    DECL(AL_SUBMIX_FORMAT_SOFT),
+    DECL(AL_SUBMIX_BUS_SOFT),
+
+    DECL(AL_CLUSTERED_SOURCES_SOFT),
+    DECL(AL_ACTIVE_CLUSTERS_SOFT),
+
+    DECL(AL_SOURCE_PRIORITY_SOFT),
+
+    DECL(AL_LOAD_GOVERNOR_LEVEL_SOFT),
 
     DECL(AL_UNPACK_AMBISONIC_ORDER_SOFT),
 };
@@ -859,15 +879,20 @@ constexpr ALchar alExtList[] =
     "AL_SOFT_direct_channels_remix "
     "AL_SOFTX_effect_target "
     "AL_SOFTX_events "
+    "AL_SOFTX_file_buffer "
     "AL_SOFTX_filter_gain_ex "
     "AL_SOFT_gain_clamp_ex "
+    "AL_SOFTX_load_governor "
     "AL_SOFT_loop_points "
     "AL_SOFTX_map_buffer "
     "AL_SOFT_MSADPCM "
+    "AL_SOFTX_source_clusters "
     "AL_SOFT_source_latency "
     "AL_SOFT_source_length "
+    "AL_SOFTX_source_priority "
     "AL_SOFT_source_resampler "
-    "AL_SOFT_source_spatialize";
+    "AL_SOFT_source_spatialize "
+    "AL_SOFTX_submix_bus";
 
 std::atomic<ALCenum> LastNullDeviceError{ALC_NO_ERROR};
 
@@ -1980,14 +2005,8 @@ static ALCenum UpdateDeviceParams(ALCdevice *device, const int *attrList)
         device->SourcesMax, device->NumMonoSources, device->NumStereoSources,
         device->AuxiliaryEffectSlotMax, device->NumAuxSends);
 
-    if(device->Uhj_Encoder)
-    {
-        /* NOTE: Don't know why this has to be "copied" into a local constexpr
-         * variable to avoid a reference on Uhj2Encoder::sFilterSize...
-         */
-        constexpr size_t filter_len{Uhj2Encoder::sFilterSize};
-        device->FixedLatency += nanoseconds{seconds{filter_len}} / device->Frequency;
-    }
+    if(auto *encoder{device->Uhj_Encoder.get()})
+        device->FixedLatency += nanoseconds{seconds{encoder->getDelay()}} / device->Frequency;
     if(device->mHrtfState)
         device->FixedLatency += nanoseconds{seconds{HRTF_DIRECT_DELAY}} / device->Frequency;
     if(auto *ambidec = device->AmbiDecoder.get())
@@ -2090,6 +2109,24 @@ static ALCenum UpdateDeviceParams(ALCdevice *device, const int *attrList)
         TRACE("Output limiter enabled, %.4fdB limit\n", thrshld_dB);
     }
 
+    device->mLoadGovernor = false;
+    device->mMixLoad = 0.0f;
+    device->mGovernorHold = 0u;
+    device->mLoadLevel.store(0u, std::memory_order_relaxed);
+    /* Loopback devices are rendered on demand, with no deadline to keep. */
+    if(device->Type != Loopback
+        && GetConfigValueBool(device->DeviceName.c_str(), nullptr, "load-governor", 0))
+    {
+        const float highload{clampf(ConfigValueFloat(device->DeviceName.c_str(), nullptr,
+            "governor-high-load").value_or(85.0f), 1.0f, 100.0f)};
+        const float lowload{clampf(ConfigValueFloat(device->DeviceName.c_str(), nullptr,
+            "governor-low-load").value_or(50.0f), 0.0f, highload)};
+        device->mLoadGovernor = true;
+        device->mGovernorHighLoad = highload / 100.0f;
+        device->mGovernorLowLoad = lowload / 100.0f;
+        TRACE("Load governor enabled (%.0f%% high, %.0f%% low)\n", highload, lowload);
+    }
+
     TRACE("Fixed device latency: %" PRId64 "ns\n", int64_t{device->FixedLatency.count()});
 
     FPUCtl mixer_mode{};
@@ -2177,14 +2214,17 @@ static ALCenum UpdateDeviceParams(ALCdevice *device, const int *attrList)
                 VoiceProps::SendData{});
 
             std::fill(voice->mSend.begin()+num_sends, voice->mSend.end(), Voice::TargetData{});
-            for(auto &chandata : voice->mChans)
+            /* Resize the mixing state for the new output. */
+            voice->initMixState(device);
+            voice->mCluster = nullptr;
+
+            if(VoicePropsItem *update{voice->mUpdate.exchange(nullptr, std::memory_order_acq_rel)})
             {
-                std::fill(chandata.mWetParams.begin()+num_sends, chandata.mWetParams.end(),
-                    SendParams{});
+                if(update->mSubmix)
+                    DecrementRef(update->mSubmix->mVoiceRef);
+                delete update;
             }
 
-            delete voice->mUpdate.exchange(nullptr, std::memory_order_acq_rel);
-
             /* Force the voice to stopped if it was stopping. */
             Voice::State vstate{Voice::Stopping};
             voice->mPlayState.compare_exchange_strong(vstate, Voice::Stopped,
@@ -2210,8 +2250,6 @@ static ALCenum UpdateDeviceParams(ALCdevice *device, const int *attrList)
                     chandata.mPrevSamples.fill(0.0f);
                     chandata.mAmbiScale = scales[*(OrderFromChan++)];
                     chandata.mAmbiSplitter = splitter;
-                    chandata.mDryParams = DirectParams{};
-                    std::fill_n(chandata.mWetParams.begin(), num_sends, SendParams{});
                 }
 
                 voice->mFlags |= VOICE_IS_AMBISONIC;
@@ -2220,11 +2258,7 @@ static ALCenum UpdateDeviceParams(ALCdevice *device, const int *attrList)
             {
                 /* Clear previous samples. */
                 for(auto &chandata : voice->mChans)
-                {
                     chandata.mPrevSamples.fill(0.0f);
-                    chandata.mDryParams = DirectParams{};
-                    std::fill_n(chandata.mWetParams.begin(), num_sends, SendParams{});
-                }
 
                 voice->mFlags &= ~VOICE_IS_AMBISONIC;
             }
@@ -2238,6 +2272,11 @@ static ALCenum UpdateDeviceParams(ALCdevice *device, const int *attrList)
                     chandata.mDryParams.NFCtrlFilter.init(w1);
             }
         }
+        /* Sources get regrouped with their updates. */
+        for(SpatialCluster &cluster : context->mSpatialClusters)
+            cluster.init(device);
+        if(WorldBus *world{context->mWorldBus.get()})
+            world->init(device);
         srclock.unlock();
 
         context->mPropsClean.test_and_set(std::memory_order_release);
@@ -2274,6 +2313,7 @@ ALCdevice::~ALCdevice()
     TRACE("Freeing device %p\n", decltype(std::declval<void*>()){this});
 
     Backend = nullptr;
+    mBufferWorker = nullptr;
 
     size_t count{std::accumulate(BufferList.cbegin(), BufferList.cend(), size_t{0u},
         [](size_t cur, const BufferSubList &sublist) noexcept -> size_t
@@ -2467,6 +2507,10 @@ void ALCcontext::init()
 
     mListener.Params.Matrix = alu::Matrix::Identity();
     mListener.Params.Velocity = alu::Vector{};
+    mListener.Params.WorldPosition = mListener.Position;
+    mListener.Params.WorldVelocity = mListener.Velocity;
+    mListener.Params.OrientAt = mListener.OrientAt;
+    mListener.Params.OrientUp = mListener.OrientUp;
     mListener.Params.Gain = mListener.Gain;
     mListener.Params.MetersPerUnit = mListener.mMetersPerUnit;
     mListener.Params.DopplerFactor = mDopplerFactor;
@@ -2481,6 +2525,50 @@ void ALCcontext::init()
 
     allocVoices(256);
     mActiveVoiceCount.store(64, std::memory_order_relaxed);
+
+    const char *devname{mDevice->DeviceName.c_str()};
+    if(const ALuint numclusters{minu(ConfigValueUInt(devname, nullptr, "source-clusters")
+        .value_or(0u), 256u)})
+    {
+        const float angle{clampf(ConfigValueFloat(devname, nullptr, "cluster-angle")
+            .value_or(10.0f), 0.0f, 180.0f)};
+        mClusterAngle = Deg2Rad(angle);
+        mClusterCosAngle = std::cos(mClusterAngle);
+        mClusterDistance = maxf(ConfigValueFloat(devname, nullptr, "cluster-distance")
+            .value_or(20.0f), 1.0f);
+        TRACE("Clustering distant sources into %u groups (%.1f degrees, %.1f meters)\n",
+            numclusters, angle, mClusterDistance);
+
+        mSpatialClusters = al::vector<SpatialCluster>(numclusters);
+        for(SpatialCluster &cluster : mSpatialClusters)
+            cluster.init(mDevice.get());
+    }
+
+    if(GetConfigValueBool(devname, nullptr, "world-locked-bus", 0))
+    {
+        TRACE("Panning positioned sources into a world-locked bus\n");
+        mWorldBus = std::unique_ptr<WorldBus>{new WorldBus{}};
+        mWorldBus->init(mDevice.get());
+    }
+
+    if(GetConfigValueBool(devname, nullptr, "source-lod", 0))
+    {
+        auto db_to_gain = [](float db) noexcept -> float
+        { return std::pow(10.0f, minf(db, 0.0f) / 20.0f); };
+        const float lodgain{ConfigValueFloat(devname, nullptr, "lod-gain").value_or(-30.0f)};
+        const float lowgain{ConfigValueFloat(devname, nullptr, "lod-low-gain")
+            .value_or(-48.0f)};
+        const float sendgain{ConfigValueFloat(devname, nullptr, "lod-send-gain")
+            .value_or(-60.0f)};
+        mSourceLod = true;
+        mLodGain = db_to_gain(lodgain);
+        mLodLowGain = minf(db_to_gain(lowgain), mLodGain);
+        mLodSendGain = db_to_gain(sendgain);
+        mLodDistance = maxf(ConfigValueFloat(devname, nullptr, "lod-distance").value_or(0.0f),
+            0.0f);
+        TRACE("Source LOD enabled (%.1fdB, %.1fdB, sends %.1fdB, %.1f meters)\n", lodgain,
+            lowgain, sendgain, mLodDistance);
+    }
 }
 
 bool ALCcontext::deinit()
@@ -25,6 +25,7 @@
 #include "atomic.h"
 #include "bufferline.h"
 #include "devformat.h"
+#include "filters/biquad.h"
 #include "filters/splitter.h"
 #include "hrtf.h"
 #include "inprogext.h"
@@ -32,13 +33,14 @@
 #include "vector.h"
 
 class BFormatDec;
+class BufferWorker;
 struct ALbuffer;
 struct ALeffect;
 struct ALfilter;
 struct BackendBase;
 struct Compressor;
 struct EffectState;
-struct Uhj2Encoder;
+struct Uhj2EncoderBase;
 struct bs2b;
 
 
@@ -163,6 +165,8 @@ struct BFChannelConfig {
  */
 #define MAX_RESAMPLER_PADDING 48
 
+#define MAX_SENDS  6
+
 
 struct MixParams {
     /* Coefficient channel mapping for mixing to the buffer. */
@@ -238,6 +242,9 @@ struct ALCdevice : public al::intrusive_ref<ALCdevice> {
     std::mutex BufferLock;
     al::vector<BufferSubList> BufferList;
 
+    /* Worker for prefetching callback buffers, started with the first one. */
+    std::unique_ptr<BufferWorker> mBufferWorker;
+
     // Map of Effects for this device
     std::mutex EffectLock;
     al::vector<EffectSubList> EffectList;
@@ -258,10 +265,16 @@ struct ALCdevice : public al::intrusive_ref<ALCdevice> {
     std::chrono::nanoseconds ClockBase{0};
     std::chrono::nanoseconds FixedLatency{0};
 
-    /* Temp storage used for mixer processing. */
-    alignas(16) float SourceData[BUFFERSIZE + MAX_RESAMPLER_PADDING];
-    alignas(16) float ResampledData[BUFFERSIZE];
-    alignas(16) float FilteredData[BUFFERSIZE];
+    /* Temp storage used for mixer processing. Voice channels are loaded,
+     * resampled, and filtered in groups, one line per filter bank lane.
+     */
+    static constexpr size_t MixerLanes{BiquadBank<1>::sLanes};
+    alignas(16) float SourceData[MixerLanes][BUFFERSIZE + MAX_RESAMPLER_PADDING];
+    alignas(16) float ResampledData[MixerLanes][BUFFERSIZE];
+    /* Filtered lines for the dry path and each auxiliary send, so they can be
+     * mixed together.
+     */
+    alignas(16) float FilteredData[MAX_SENDS+1][MixerLanes][BUFFERSIZE];
     union {
         alignas(16) float HrtfSourceData[BUFFERSIZE + HRTF_HISTORY_LENGTH];
         alignas(16) float NfcSampleData[BUFFERSIZE];
@@ -285,9 +298,15 @@ struct ALCdevice : public al::intrusive_ref<ALCdevice> {
     /* HRTF state and info */
     std::unique_ptr<DirectHrtfState> mHrtfState;
     al::intrusive_ptr<HrtfStore> mHrtf;
+    /* Set to fade sources between HRIRs by interpolating the coefficients,
+     * instead of blending two filters.
+     */
+    bool mHrtfInterpolate{false};
+    /* Optional cache of source HRIRs for quantized directions. */
+    std::unique_ptr<HrtfCoeffCache> mHrtfCache;
 
     /* Ambisonic-to-UHJ encoder */
-    std::unique_ptr<Uhj2Encoder> Uhj_Encoder;
+    std::unique_ptr<Uhj2EncoderBase> Uhj_Encoder;
 
     /* Ambisonic decoder for speakers */
     std::unique_ptr<BFormatDec> AmbiDecoder;
@@ -307,6 +326,18 @@ struct ALCdevice : public al::intrusive_ref<ALCdevice> {
     float DitherDepth{0.0f};
     ALuint DitherSeed{0u};
 
+    /* Mixer load governor. The time taken to mix each update is compared to
+     * the time the update covers, and rendering quality is lowered a level
+     * at a time when the load stays over the high mark, then restored once
+     * it stays under the low mark.
+     */
+    bool mLoadGovernor{false};
+    float mGovernorHighLoad{0.0f};
+    float mGovernorLowLoad{0.0f};
+    float mMixLoad{0.0f};
+    ALuint mGovernorHold{0u};
+    std::atomic<ALuint> mLoadLevel{0u};
+
     /* Running count of the mixer invocations, in 31.1 fixed point. This
      * actually increments *twice* when mixing, first at the start and then at
      * the end, so the bottom bit indicates if the device is currently mixing
@@ -360,6 +391,8 @@ struct ALCdevice : public al::intrusive_ref<ALCdevice> {
 
 #define RECORD_THREAD_NAME "alsoft-record"
 
+#define BUFFER_THREAD_NAME "alsoft-buffers"
+
 
 extern int RTPrioLevel;
 void SetRTPriority(void);
@@ -178,6 +178,36 @@ struct ALCcontext : public al::intrusive_ref<ALCcontext> {
     }
 
 
+    /* Distant sources within the angular tolerance (in radians) of each other
+     * can be grouped into a limited number of spatial clusters, with the
+     * mixer reporting how many sources and clusters were used in the last
+     * update.
+     */
+    al::vector<SpatialCluster> mSpatialClusters;
+    float mClusterAngle{0.0f};
+    float mClusterCosAngle{1.0f};
+    float mClusterDistance{0.0f};
+    std::atomic<ALuint> mClusteredSources{0u};
+    std::atomic<ALuint> mActiveClusters{0u};
+
+    /* Positioned mono sources can pan into a world-locked ambisonic bus, with
+     * the listener's rotation applied to the bus instead of to each source.
+     */
+    std::unique_ptr<WorldBus> mWorldBus;
+
+    /* Sources quieter than the LOD gains (linear, scaled by the source
+     * priority) or further than the LOD distance are rendered with less
+     * detail, and sends under the send gain are dropped.
+     */
+    bool mSourceLod{false};
+    float mLodGain{0.0f};
+    float mLodLowGain{0.0f};
+    float mLodSendGain{0.0f};
+    float mLodDistance{0.0f};
+    /* The device's load governor level the voices were last updated for. */
+    ALuint mLoadLevel{0u};
+
+
     using ALeffectslotArray = al::FlexArray<ALeffectslot*>;
     std::atomic<ALeffectslotArray*> mActiveAuxSlots{nullptr};
 
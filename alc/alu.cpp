@@ -48,6 +48,7 @@
 #include "al/buffer.h"
 #include "al/effect.h"
 #include "al/event.h"
+#include "al/filter.h"
 #include "al/listener.h"
 #include "alcmain.h"
 #include "alcontext.h"
@@ -78,6 +79,7 @@
 #include "threads.h"
 #include "uhjfilter.h"
 #include "vecmat.h"
+#include "vector.h"
 #include "voice.h"
 
 #include "bsinc_tables.h"
@@ -101,6 +103,7 @@ struct LerpTag;
 struct CubicTag;
 struct BSincTag;
 struct FastBSincTag;
+struct PolyBSincTag;
 
 
 static_assert(!(MAX_RESAMPLER_PADDING&1) && MAX_RESAMPLER_PADDING >= BSINC_POINTS_MAX,
@@ -145,6 +148,21 @@ const float ZScale{InitZScale()};
 
 namespace {
 
+/* How far (+3dB) a source needs to rise above a level of detail threshold it
+ * dropped below, to get its detail back.
+ */
+constexpr float LodHysteresis{1.41253754f};
+
+/* The highest load governor level, and the send gain (-30dB) under which
+ * sends are dropped at that level. The governor doesn't lower the reverb's
+ * internal rate, since reverb/quality is only read when the device is set up;
+ * changing it while playing would reallocate the delay lines and cut off the
+ * reverb's tail. There is no voice cap either: every playing voice is still
+ * mixed, and dropping quiet sends only reduces what effects are fed.
+ */
+constexpr ALuint MaxLoadLevel{3u};
+constexpr float GovernorSendGain{0.0316227766f};
+
 struct ChanMap {
     Channel channel;
     float angle;
@@ -195,6 +213,103 @@ inline void BsincPrepare(const ALuint increment, BsincState *state, const BSincT
     state->filter = table->Tab + table->filterOffset[si];
 }
 
+/* Bits of the fractional position between bsinc filter phases. */
+constexpr ALuint BsincPhaseBitDiff{FRACTIONBITS - BSINC_PHASE_BITS};
+
+/* Downsampling steps that are a multiple of a quarter only ever land on the
+ * quarter phases, so the scale-interpolated filters for those phases can be
+ * computed ahead of time. This covers ratios up to 4:1 (e.g. 96khz or 192khz
+ * to 48khz, or 88.2khz to 44.1khz), and steps up to 1.25 go through the
+ * phase-aligned table path below instead (they have no scale interpolation).
+ */
+constexpr ALuint PolyStepBits{FRACTIONBITS - 2};
+constexpr ALuint PolyPhaseCount{1u << (FRACTIONBITS-PolyStepBits)};
+constexpr ALuint PolyMinStep{FRACTIONONE + (1u<<PolyStepBits)};
+constexpr ALuint PolyMaxStep{FRACTIONONE * 4};
+constexpr ALuint PolyStepCount{((PolyMaxStep-PolyMinStep) >> PolyStepBits) + 1};
+
+struct PolyBSincTable {
+    al::vector<float,16> Filters;
+    std::array<const float*,PolyStepCount> Steps{};
+};
+PolyBSincTable PolyBsinc12;
+PolyBSincTable PolyBsinc24;
+
+void InitPolyBsinc(PolyBSincTable &poly, const BSincTable *table)
+{
+    auto step_increment = [](ALuint idx) noexcept -> ALuint
+    { return PolyMinStep + (idx<<PolyStepBits); };
+
+    size_t total{0};
+    BsincState state{};
+    for(ALuint idx{0};idx < PolyStepCount;++idx)
+    {
+        BsincPrepare(step_increment(idx), &state, table);
+        total += state.m * PolyPhaseCount;
+    }
+    poly.Filters.resize(total);
+
+    float *out{poly.Filters.data()};
+    for(ALuint idx{0};idx < PolyStepCount;++idx)
+    {
+        BsincPrepare(step_increment(idx), &state, table);
+        poly.Steps[idx] = out;
+
+        const size_t m{state.m};
+        for(ALuint phase{0};phase < PolyPhaseCount;++phase)
+        {
+            /* Match the bsinc resampler's scale interpolation exactly, so
+             * output is the same either way.
+             */
+            const ALuint pi{(phase<<PolyStepBits) >> BsincPhaseBitDiff};
+            const float *fil{state.filter + m*pi*4};
+            const float *scd{fil + m*2};
+            for(size_t j{0};j < m;++j)
+                *(out++) = fil[j] + state.sf*scd[j];
+        }
+    }
+}
+
+/* Sets up the phase-aligned filter for the given step, if it has one. */
+bool PolyBsincPrepare(const Resampler resampler, const ALuint increment, BsincState *state,
+    const PolyBSincTable &poly)
+{
+    state->polyfilter = nullptr;
+    if(increment > FRACTIONONE && (resampler == Resampler::BSinc12
+        || resampler == Resampler::BSinc24))
+    {
+        if((increment&((1u<<PolyStepBits)-1)) != 0 || increment > PolyMaxStep)
+            return false;
+        state->polyfilter = poly.Steps[(increment-PolyMinStep) >> PolyStepBits];
+        state->pshift = PolyStepBits;
+        state->pstride = state->m;
+        return true;
+    }
+
+    /* Without scale interpolation, the table's filters can be used directly
+     * when the step is a whole number of phases.
+     */
+    if((increment&((1u<<BsincPhaseBitDiff)-1)) != 0)
+        return false;
+    state->polyfilter = state->filter;
+    state->pshift = BsincPhaseBitDiff;
+    state->pstride = state->m * 4;
+    return true;
+}
+
+inline ResamplerFunc SelectPolyResampler()
+{
+#ifdef HAVE_NEON
+    if((CPUCapFlags&CPU_CAP_NEON))
+        return Resample_<PolyBSincTag,NEONTag>;
+#endif
+#ifdef HAVE_SSE
+    if((CPUCapFlags&CPU_CAP_SSE))
+        return Resample_<PolyBSincTag,SSETag>;
+#endif
+    return Resample_<PolyBSincTag,CTag>;
+}
+
 inline ResamplerFunc SelectResampler(Resampler resampler, ALuint increment)
 {
     switch(resampler)
@@ -248,11 +363,22 @@ inline ResamplerFunc SelectResampler(Resampler resampler, ALuint increment)
     return Resample_<PointTag,CTag>;
 }
 
+/* Limits the resampler's quality for the given level of detail. */
+Resampler GetLodResampler(Resampler resampler, ALuint lodlevel)
+{
+    if(lodlevel > 1) return std::min(resampler, Resampler::Linear);
+    if(lodlevel > 0) return std::min(resampler, Resampler::Cubic);
+    return resampler;
+}
+
 } // namespace
 
 void aluInit(void)
 {
     MixDirectHrtf = SelectHrtfMixer();
+
+    InitPolyBsinc(PolyBsinc12, &bsinc12);
+    InitPolyBsinc(PolyBsinc24, &bsinc24);
 }
 
 
@@ -267,10 +393,14 @@ ResamplerFunc PrepareResampler(Resampler resampler, ALuint increment, InterpStat
     case Resampler::FastBSinc12:
     case Resampler::BSinc12:
         BsincPrepare(increment, &state->bsinc, &bsinc12);
+        if(PolyBsincPrepare(resampler, increment, &state->bsinc, PolyBsinc12))
+            return SelectPolyResampler();
         break;
     case Resampler::FastBSinc24:
     case Resampler::BSinc24:
         BsincPrepare(increment, &state->bsinc, &bsinc24);
+        if(PolyBsincPrepare(resampler, increment, &state->bsinc, PolyBsinc24))
+            return SelectPolyResampler();
         break;
     }
     return SelectResampler(resampler, increment);
@@ -405,12 +535,28 @@ bool CalcContextParams(ALCcontext *Context)
     return true;
 }
 
-bool CalcListenerParams(ALCcontext *Context)
+/* Returns the voice property groups that need to be recalculated for the
+ * listener change. With a world-locked bus, a listener that only turned just
+ * sets 'rotated', leaving world-locked voices as they are.
+ */
+ALuint CalcListenerParams(ALCcontext *Context, bool &rotated)
 {
     ALlistener &Listener = Context->mListener;
 
     ALlistenerProps *props{Listener.Params.Update.exchange(nullptr, std::memory_order_acq_rel)};
-    if(!props) return false;
+    if(!props) return 0u;
+
+    const float gain{props->Gain * Context->mGainBoost};
+    const bool moved{Listener.Params.WorldPosition != props->Position
+        || Listener.Params.WorldVelocity != props->Velocity
+        || Listener.Params.MetersPerUnit != props->MetersPerUnit};
+    const bool turned{Listener.Params.OrientAt != props->OrientAt
+        || Listener.Params.OrientUp != props->OrientUp};
+    ALuint changes{(Listener.Params.Gain != gain) ? VOICE_CHANGED_GAIN : 0u};
+    Listener.Params.WorldPosition = props->Position;
+    Listener.Params.WorldVelocity = props->Velocity;
+    Listener.Params.OrientAt = props->OrientAt;
+    Listener.Params.OrientUp = props->OrientUp;
 
     /* AT then UP */
     alu::Vector N{props->OrientAt[0], props->OrientAt[1], props->OrientAt[2], 0.0f};
@@ -435,11 +581,20 @@ bool CalcListenerParams(ALCcontext *Context)
     const alu::Vector vel{props->Velocity[0], props->Velocity[1], props->Velocity[2], 0.0f};
     Listener.Params.Velocity = Listener.Params.Matrix * vel;
 
-    Listener.Params.Gain = props->Gain * Context->mGainBoost;
+    Listener.Params.Gain = gain;
     Listener.Params.MetersPerUnit = props->MetersPerUnit;
 
     AtomicReplaceHead(Context->mFreeListenerProps, props);
-    return true;
+    if(moved)
+        changes = VOICE_CHANGED_ALL;
+    else if(turned)
+    {
+        if(Context->mWorldBus)
+            rotated = true;
+        else
+            changes = VOICE_CHANGED_ALL;
+    }
+    return changes;
 }
 
 bool CalcEffectSlotParams(ALeffectslot *slot, ALeffectslot **sorted_slots, ALCcontext *context)
@@ -457,6 +612,16 @@ bool CalcEffectSlotParams(ALeffectslot *slot, ALeffectslot **sorted_slots, ALCco
     slot->Params.Target = props->Target;
     slot->Params.EffectType = props->Type;
     slot->Params.mEffectProps = props->Props;
+    if(props->InputOrder != slot->Params.InputOrder)
+    {
+        /* Sources only mix as many wet channels as the effect reads. The
+         * mixing buffer already has lines for the device's order.
+         */
+        slot->Params.InputOrder = props->InputOrder;
+        const size_t numwet{minz(AmbiChannelsFromOrder(props->InputOrder),
+            slot->MixBuffer.size())};
+        slot->Wet.Buffer = {slot->MixBuffer.data(), numwet};
+    }
     if(IsReverbEffect(props->Type))
     {
         slot->Params.RoomRolloff = props->Props.Reverb.RoomRolloffFactor;
@@ -698,12 +863,46 @@ void AmbiRotator(std::array<std::array<float,MAX_AMBI_CHANNELS>,MAX_AMBI_CHANNEL
 /* End ambisonic rotation helpers. */
 
 
+/* Gets the HRIR coefficients and delays for a direction, from the device's
+ * cache if it has one.
+ */
+inline void CalcHrtfCoeffs(const ALCdevice *Device, const float elevation, const float azimuth,
+    const float distance, const float spread, HrirArray &coeffs, const al::span<ALuint,2> delays)
+{
+    if(HrtfCoeffCache *cache{Device->mHrtfCache.get()})
+        cache->get(Device->mHrtf.get(), elevation, azimuth, distance, spread, coeffs, delays);
+    else
+        GetHrtfCoeffs(Device->mHrtf.get(), elevation, azimuth, distance, spread, coeffs, delays);
+}
+
+
+/* Points a voice send at the slot's wet buffer. Gains are only kept up to
+ * date for the channels a send mixes, so when the slot gained channels since
+ * the voice last mixed to it, the new ones are silenced to fade in from
+ * nothing rather than from whatever was left in them.
+ */
+void SetSendBuffer(Voice *voice, const ALuint sendidx, const ALeffectslot *slot)
+{
+    const size_t oldchans{voice->mSend[sendidx].Buffer.size()};
+    voice->mSend[sendidx].Buffer = slot->Wet.Buffer;
+    if(slot->Wet.Buffer.size() <= oldchans)
+        return;
+
+    for(auto &chandata : voice->mChans)
+    {
+        const al::span<float> gains{chandata.mWetParams[sendidx].Gains.Current};
+        std::fill(gains.begin()+oldchans, gains.end(), 0.0f);
+    }
+}
+
+
 struct GainTriplet { float Base, HF, LF; };
 
 void CalcPanningAndFilters(Voice *voice, const float xpos, const float ypos, const float zpos,
     const float Distance, const float Spread, const GainTriplet &DryGain,
     const al::span<const GainTriplet,MAX_SENDS> WetGain, ALeffectslot *(&SendSlots)[MAX_SENDS],
-    const VoiceProps *props, const ALlistener &Listener, const ALCdevice *Device)
+    const VoiceProps *props, const ALlistener &Listener, const ALCdevice *Device,
+    const ALuint changes)
 {
     static const ChanMap MonoMap[1]{
         { FrontCenter, 0.0f, 0.0f }
@@ -748,16 +947,28 @@ void CalcPanningAndFilters(Voice *voice, const float xpos, const float ypos, con
 
     const auto Frequency = static_cast<float>(Device->Frequency);
     const ALuint NumSends{Device->NumAuxSends};
+    /* Near-field control is left off for reduced levels of detail. */
+    const bool use_nfc{Device->AvgSpeakerDist > 0.0f && voice->mLodLevel == 0};
 
     const size_t num_channels{voice->mChans.size()};
     ASSUME(num_channels > 0);
 
+    /* The HRTF coefficients only need to be looked up again if the source
+     * moved (or isn't using HRTF yet), and the filters only redesigned if
+     * their gains could have changed.
+     */
+    const bool keep_hrtf{!(changes&VOICE_CHANGED_SPATIAL) && (voice->mFlags&VOICE_HAS_HRTF)};
+    const bool update_filters{(changes&(VOICE_CHANGED_FILTER|VOICE_CHANGED_SPATIAL)) != 0};
+
     for(auto &chandata : voice->mChans)
     {
-        chandata.mDryParams.Hrtf.Target = HrtfFilter{};
-        chandata.mDryParams.Gains.Target.fill(0.0f);
-        std::for_each(chandata.mWetParams.begin(), chandata.mWetParams.begin()+NumSends,
-            [](SendParams &params) -> void { params.Gains.Target.fill(0.0f); });
+        if(chandata.mDryParams.Hrtf && !keep_hrtf)
+            chandata.mDryParams.Hrtf->Target = HrtfFilter{};
+        std::fill(chandata.mDryParams.Gains.Target.begin(), chandata.mDryParams.Gains.Target.end(),
+            0.0f);
+        std::for_each(chandata.mWetParams, chandata.mWetParams+NumSends,
+            [](SendParams &params) -> void
+            { std::fill(params.Gains.Target.begin(), params.Gains.Target.end(), 0.0f); });
     }
 
     DirectMode DirectChannels{props->DirectChannels};
@@ -820,7 +1031,78 @@ void CalcPanningAndFilters(Voice *voice, const float xpos, const float ypos, con
     }
 
     voice->mFlags &= ~(VOICE_HAS_HRTF | VOICE_HAS_NFC);
-    if(voice->mFmtChannels == FmtBFormat2D || voice->mFmtChannels == FmtBFormat3D)
+    if(const SubmixBus *bus{voice->mDryBus})
+    {
+        /* Submix bus members mix into the bus lines with just their gain,
+         * leaving the panning and distance effects to the bus. Channels are
+         * downmixed the same as when panned to a point, so a member played on
+         * a positioned bus is as loud as when played at that position itself.
+         * B-Format members only contribute their first-order response (just W
+         * to mono and stereo buses).
+         */
+        for(size_t c{0};c < num_channels;c++)
+        {
+            const al::span<float> gains{voice->mChans[c].mDryParams.Gains.Target};
+            if(!chans)
+            {
+                const uint8_t *index_map{(voice->mFmtChannels == FmtBFormat2D) ?
+                    GetAmbi2DLayout(voice->mAmbiLayout).data() :
+                    GetAmbiLayout(voice->mAmbiLayout).data()};
+                const size_t acn{index_map[c]};
+                const float gain{DryGain.Base * GetAmbiScales(voice->mAmbiScaling)[acn]};
+                if(bus->mFmtChannels == FmtBFormat3D)
+                {
+                    if(acn < bus->mBuffer.size())
+                        gains[acn] = gain;
+                }
+                else if(acn == 0)
+                    std::fill_n(gains.begin(), bus->mBuffer.size(), gain);
+                continue;
+            }
+
+            if(chans[c].channel == LFE)
+                continue;
+            const float gain{DryGain.Base * downmix_gain};
+            if(bus->mFmtChannels == FmtMono)
+                gains[0] = gain;
+            else if(bus->mFmtChannels == FmtStereo)
+            {
+                /* Left and right channels go to their side, and centered ones
+                 * to both.
+                 */
+                if(chans[c].angle < 0.0f)
+                    gains[0] = gain * 2.0f;
+                else if(chans[c].angle > 0.0f)
+                    gains[1] = gain * 2.0f;
+                else
+                    gains[0] = gains[1] = gain;
+            }
+            else
+            {
+                const auto coeffs = CalcAngleCoeffs(chans[c].angle, chans[c].elevation, 0.0f);
+                for(size_t i{0};i < bus->mBuffer.size();++i)
+                    gains[i] = coeffs[i] * gain;
+            }
+        }
+
+        /* Spatial cluster and world-locked bus members are mono, and still
+         * pan their sends toward their own position.
+         */
+        if(voice->mCluster || (voice->mFlags&VOICE_IS_WORLD_LOCKED))
+        {
+            const auto coeffs = (Device->mRenderMode == StereoPair) ?
+                CalcAngleCoeffs(ScaleAzimuthFront(std::atan2(xpos, -zpos), 1.5f),
+                    std::asin(clampf(ypos, -1.0f, 1.0f)), Spread) :
+                CalcDirectionCoeffs({xpos, ypos, zpos}, Spread);
+            for(ALuint i{0};i < NumSends;i++)
+            {
+                if(const ALeffectslot *Slot{SendSlots[i]})
+                    ComputePanGains(&Slot->Wet, coeffs.data(), WetGain[i].Base,
+                        voice->mChans[0].mWetParams[i].Gains.Target);
+            }
+        }
+    }
+    else if(voice->mFmtChannels == FmtBFormat2D || voice->mFmtChannels == FmtBFormat3D)
     {
         /* Special handling for B-Format sources. */
 
@@ -831,7 +1113,7 @@ void CalcPanningAndFilters(Voice *voice, const float xpos, const float ypos, con
              * others.
              */
 
-            if(Device->AvgSpeakerDist > 0.0f)
+            if(use_nfc)
             {
                 /* Clamp the distance for really close sources, to prevent
                  * excessive bass.
@@ -878,7 +1160,7 @@ void CalcPanningAndFilters(Voice *voice, const float xpos, const float ypos, con
         }
         else
         {
-            if(Device->AvgSpeakerDist > 0.0f)
+            if(use_nfc)
             {
                 /* NOTE: The NFCtrlFilters were created with a w0 of 0, which
                  * is what we want for FOA input. The first channel may have
@@ -1011,17 +1293,19 @@ void CalcPanningAndFilters(Voice *voice, const float xpos, const float ypos, con
             /* Get the HRIR coefficients and delays just once, for the given
              * source direction.
              */
-            GetHrtfCoeffs(Device->mHrtf.get(), ev, az, Distance, Spread,
-                voice->mChans[0].mDryParams.Hrtf.Target.Coeffs,
-                voice->mChans[0].mDryParams.Hrtf.Target.Delay);
-            voice->mChans[0].mDryParams.Hrtf.Target.Gain = DryGain.Base * downmix_gain;
+            if(!keep_hrtf)
+                CalcHrtfCoeffs(Device, ev, az, Distance, Spread,
+                    voice->mChans[0].mDryParams.Hrtf->Target.Coeffs,
+                    voice->mChans[0].mDryParams.Hrtf->Target.Delay);
+            voice->mChans[0].mDryParams.Hrtf->Target.Gain = DryGain.Base * downmix_gain;
 
             /* Remaining channels use the same results as the first. */
             for(size_t c{1};c < num_channels;c++)
             {
                 /* Skip LFE */
                 if(chans[c].channel == LFE) continue;
-                voice->mChans[c].mDryParams.Hrtf.Target = voice->mChans[0].mDryParams.Hrtf.Target;
+                voice->mChans[c].mDryParams.Hrtf->Target =
+                    voice->mChans[0].mDryParams.Hrtf->Target;
             }
 
             /* Calculate the directional coefficients once, which apply to all
@@ -1057,11 +1341,12 @@ void CalcPanningAndFilters(Voice *voice, const float xpos, const float ypos, con
                 /* Get the HRIR coefficients and delays for this channel
                  * position.
                  */
-                GetHrtfCoeffs(Device->mHrtf.get(), chans[c].elevation, chans[c].angle,
-                    std::numeric_limits<float>::infinity(), Spread,
-                    voice->mChans[c].mDryParams.Hrtf.Target.Coeffs,
-                    voice->mChans[c].mDryParams.Hrtf.Target.Delay);
-                voice->mChans[c].mDryParams.Hrtf.Target.Gain = DryGain.Base;
+                if(!keep_hrtf)
+                    CalcHrtfCoeffs(Device, chans[c].elevation, chans[c].angle,
+                        std::numeric_limits<float>::infinity(), Spread,
+                        voice->mChans[c].mDryParams.Hrtf->Target.Coeffs,
+                        voice->mChans[c].mDryParams.Hrtf->Target.Delay);
+                voice->mChans[c].mDryParams.Hrtf->Target.Gain = DryGain.Base;
 
                 /* Normal panning for auxiliary sends. */
                 const auto coeffs = CalcAngleCoeffs(chans[c].angle, chans[c].elevation, Spread);
@@ -1075,6 +1360,24 @@ void CalcPanningAndFilters(Voice *voice, const float xpos, const float ypos, con
             }
         }
 
+        /* Reduced levels of detail truncate the HRIRs to a half or a quarter
+         * of their length. The mix keeps the longer length of the old and new
+         * coefficients while fading between them.
+         */
+        const ALuint irsize{Device->mHrtf->irSize};
+        ALuint hrirsize{irsize};
+        if(voice->mLodLevel > 0)
+        {
+            hrirsize = maxu(irsize >> voice->mLodLevel, MIN_IR_LENGTH);
+            for(auto &chandata : voice->mChans)
+            {
+                auto &coeffs = chandata.mDryParams.Hrtf->Target.Coeffs;
+                std::fill(coeffs.begin()+hrirsize, coeffs.begin()+irsize, float2{});
+            }
+        }
+        voice->mMixHrirSize = minu(maxu(voice->mHrirSize, hrirsize), irsize);
+        voice->mHrirSize = hrirsize;
+
         voice->mFlags |= VOICE_HAS_HRTF;
     }
     else
@@ -1084,7 +1387,7 @@ void CalcPanningAndFilters(Voice *voice, const float xpos, const float ypos, con
         if(Distance > std::numeric_limits<float>::epsilon())
         {
             /* Calculate NFC filter coefficient if needed. */
-            if(Device->AvgSpeakerDist > 0.0f)
+            if(use_nfc)
             {
                 /* Clamp the distance for really close sources, to prevent
                  * excessive bass.
@@ -1138,7 +1441,7 @@ void CalcPanningAndFilters(Voice *voice, const float xpos, const float ypos, con
         }
         else
         {
-            if(Device->AvgSpeakerDist > 0.0f)
+            if(use_nfc)
             {
                 /* If the source distance is 0, simulate a plane-wave by using
                  * infinite distance, which results in a w0 of 0.
@@ -1180,6 +1483,9 @@ void CalcPanningAndFilters(Voice *voice, const float xpos, const float ypos, con
         }
     }
 
+    if(!update_filters)
+        return;
+
     {
         const float hfNorm{props->Direct.HFReference / Frequency};
         const float lfNorm{props->Direct.LFReference / Frequency};
@@ -1219,11 +1525,26 @@ void CalcPanningAndFilters(Voice *voice, const float xpos, const float ypos, con
     }
 }
 
-void CalcNonAttnSourceParams(Voice *voice, const VoiceProps *props, const ALCcontext *ALContext)
+/* Sets the voice's fixed-point stepping value and resampler for the given
+ * pitch.
+ */
+void CalcVoiceStep(Voice *voice, const float pitch, const Resampler resampler)
+{
+    if(!(pitch <= float{MAX_PITCH}))
+        voice->mStep = MAX_PITCH<<FRACTIONBITS;
+    else
+        voice->mStep = maxu(fastf2u(pitch * FRACTIONONE), 1);
+    voice->mResampler = PrepareResampler(GetLodResampler(resampler, voice->mLodLevel),
+        voice->mStep, &voice->mResampleState);
+}
+
+void CalcNonAttnSourceParams(Voice *voice, const VoiceProps *props, const ALCcontext *ALContext,
+    const ALuint changes)
 {
     const ALCdevice *Device{ALContext->mDevice.get()};
     ALeffectslot *SendSlots[MAX_SENDS];
 
+    voice->mLodLevel = minu(ALContext->mLoadLevel, 2u);
     voice->mDirect.Buffer = Device->Dry.Buffer;
     for(ALuint i{0};i < Device->NumAuxSends;i++)
     {
@@ -1236,17 +1557,13 @@ void CalcNonAttnSourceParams(Voice *voice, const VoiceProps *props, const ALCcon
             voice->mSend[i].Buffer = {};
         }
         else
-            voice->mSend[i].Buffer = SendSlots[i]->Wet.Buffer;
+            SetSendBuffer(voice, i, SendSlots[i]);
     }
 
     /* Calculate the stepping value */
-    const auto Pitch = static_cast<float>(voice->mFrequency) /
-        static_cast<float>(Device->Frequency) * props->Pitch;
-    if(Pitch > float{MAX_PITCH})
-        voice->mStep = MAX_PITCH<<FRACTIONBITS;
-    else
-        voice->mStep = maxu(fastf2u(Pitch * FRACTIONONE), 1);
-    voice->mResampler = PrepareResampler(props->mResampler, voice->mStep, &voice->mResampleState);
+    voice->mPitchScale = static_cast<float>(voice->mFrequency) /
+        static_cast<float>(Device->Frequency);
+    CalcVoiceStep(voice, voice->mPitchScale * props->Pitch, props->mResampler);
 
     /* Calculate gains */
     const ALlistener &Listener = ALContext->mListener;
@@ -1265,10 +1582,133 @@ void CalcNonAttnSourceParams(Voice *voice, const VoiceProps *props, const ALCcon
     }
 
     CalcPanningAndFilters(voice, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, DryGain, WetGain, SendSlots, props,
-        Listener, Device);
+        Listener, Device, changes);
+}
+
+void CalcSubmixSourceParams(Voice *voice, const VoiceProps *props, const ALCcontext *ALContext,
+    const ALuint changes)
+{
+    const ALCdevice *Device{ALContext->mDevice.get()};
+    ALeffectslot *SendSlots[MAX_SENDS]{};
+
+    /* Bus members have no sends of their own, the bus sends the group mix. */
+    voice->mLodLevel = minu(ALContext->mLoadLevel, 2u);
+    voice->mDirect.Buffer = props->mSubmix->mBuffer;
+    for(ALuint i{0};i < Device->NumAuxSends;i++)
+        voice->mSend[i].Buffer = {};
+
+    /* Calculate the stepping value */
+    voice->mPitchScale = static_cast<float>(voice->mFrequency) /
+        static_cast<float>(Device->Frequency);
+    CalcVoiceStep(voice, voice->mPitchScale * props->Pitch, props->mResampler);
+
+    /* Calculate gains. The listener gain is applied by the bus. */
+    GainTriplet DryGain;
+    DryGain.Base  = minf(clampf(props->Gain, props->MinGain, props->MaxGain) * props->Direct.Gain,
+        GAIN_MIX_MAX);
+    DryGain.HF = props->Direct.GainHF;
+    DryGain.LF = props->Direct.GainLF;
+    GainTriplet WetGain[MAX_SENDS]{};
+
+    CalcPanningAndFilters(voice, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, DryGain, WetGain, SendSlots, props,
+        ALContext->mListener, Device, changes);
+}
+
+void CalcClusterParams(SpatialCluster *cluster, const ALCcontext *ALContext)
+{
+    const ALCdevice *Device{ALContext->mDevice.get()};
+    ALeffectslot *SendSlots[MAX_SENDS]{};
+
+    /* The members' gains and filters are already applied to the line, so the
+     * cluster only pans it.
+     */
+    VoiceProps props{};
+    props.DirectChannels = DirectMode::Off;
+    props.Direct.HFReference = LOWPASSFREQREF;
+    props.Direct.LFReference = HIGHPASSFREQREF;
+    for(auto &send : props.Send)
+    {
+        send.HFReference = LOWPASSFREQREF;
+        send.LFReference = HIGHPASSFREQREF;
+    }
+
+    Voice *voice{&cluster->mVoice};
+    voice->mDirect.Buffer = Device->Dry.Buffer;
+    const GainTriplet DryGain{1.0f, 1.0f, 1.0f};
+    GainTriplet WetGain[MAX_SENDS]{};
+
+    CalcPanningAndFilters(voice, cluster->mDirection[0], cluster->mDirection[1],
+        cluster->mDirection[2], cluster->mDistance, 0.0f, DryGain, WetGain, SendSlots, &props,
+        ALContext->mListener, Device, VOICE_CHANGED_ALL);
+}
+
+void CalcWorldBusParams(WorldBus *world, const ALCcontext *ALContext)
+{
+    const ALCdevice *Device{ALContext->mDevice.get()};
+    ALeffectslot *SendSlots[MAX_SENDS]{};
+
+    /* The bus is played as a world-relative B-Format source facing the world
+     * axes, so the listener's orientation rotates it.
+     */
+    VoiceProps props{};
+    props.HeadRelative = AL_FALSE;
+    props.OrientAt = {0.0f, 0.0f, -1.0f};
+    props.OrientUp = {0.0f, 1.0f, 0.0f};
+    props.DirectChannels = DirectMode::Off;
+    props.Direct.HFReference = LOWPASSFREQREF;
+    props.Direct.LFReference = HIGHPASSFREQREF;
+    for(auto &send : props.Send)
+    {
+        send.HFReference = LOWPASSFREQREF;
+        send.LFReference = HIGHPASSFREQREF;
+    }
+
+    Voice *voice{&world->mVoice};
+    voice->mDirect.Buffer = Device->Dry.Buffer;
+    const GainTriplet DryGain{1.0f, 1.0f, 1.0f};
+    GainTriplet WetGain[MAX_SENDS]{};
+
+    CalcPanningAndFilters(voice, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, DryGain, WetGain, SendSlots,
+        &props, ALContext->mListener, Device, VOICE_CHANGED_ALL);
 }
 
-void CalcAttnSourceParams(Voice *voice, const VoiceProps *props, const ALCcontext *ALContext)
+/* Finds the spatial cluster closest to the given direction, within the
+ * context's angular tolerance. If none are close enough, an unused cluster is
+ * moved to the direction to start a new group. Returns null if all clusters
+ * are in use elsewhere.
+ */
+SpatialCluster *GetSpatialCluster(ALCcontext *ALContext, const alu::Vector &dir,
+    const float distance)
+{
+    SpatialCluster *closest{nullptr}, *unused{nullptr};
+    float closest_dot{ALContext->mClusterCosAngle};
+    for(SpatialCluster &cluster : ALContext->mSpatialClusters)
+    {
+        if(!cluster.mNumMembers && !cluster.mNewMembers)
+        {
+            if(!unused) unused = &cluster;
+            continue;
+        }
+
+        const float dot{dir[0]*cluster.mDirection[0] + dir[1]*cluster.mDirection[1] +
+            dir[2]*cluster.mDirection[2]};
+        if(dot >= closest_dot)
+        {
+            closest = &cluster;
+            closest_dot = dot;
+        }
+    }
+    if(closest || !unused)
+        return closest;
+
+    unused->mDirection = {dir[0], dir[1], dir[2]};
+    unused->mDistance = distance;
+    CalcClusterParams(unused, ALContext);
+    return unused;
+}
+
+void CalcAttnSourceParams(Voice *voice, const VoiceProps *props, ALCcontext *ALContext,
+    ALuint changes)
 {
     const ALCdevice *Device{ALContext->mDevice.get()};
     const ALuint NumSends{Device->NumAuxSends};
@@ -1279,8 +1719,12 @@ void CalcAttnSourceParams(Voice *voice, const VoiceProps *props, const ALCcontex
     ALeffectslot *SendSlots[MAX_SENDS];
     float RoomRolloff[MAX_SENDS];
     GainTriplet DecayDistance[MAX_SENDS];
+    ALuint ActiveSends{0u};
     for(ALuint i{0};i < NumSends;i++)
     {
+        if(!voice->mSend[i].Buffer.empty())
+            ActiveSends |= 1u << i;
+
         SendSlots[i] = props->Send[i].Slot;
         if(!SendSlots[i] && i == 0)
             SendSlots[i] = ALContext->mDefaultSlot.get();
@@ -1330,7 +1774,7 @@ void CalcAttnSourceParams(Voice *voice, const VoiceProps *props, const ALCcontex
         if(!SendSlots[i])
             voice->mSend[i].Buffer = {};
         else
-            voice->mSend[i].Buffer = SendSlots[i]->Wet.Buffer;
+            SetSendBuffer(voice, i, SendSlots[i]);
     }
 
     /* Transform source to listener space (convert to head relative) */
@@ -1515,9 +1959,64 @@ void CalcAttnSourceParams(Voice *voice, const VoiceProps *props, const ALCcontex
         }
     }
 
+    /* Pick the level of detail to render with, from how audible the source is
+     * given its priority. Detail is lowered as the source falls under the LOD
+     * gain (or goes past the LOD distance), and again under the low gain. The
+     * load governor can impose a minimum level on all sources.
+     */
+    ALuint LodLevel{minu(ALContext->mLoadLevel, 2u)};
+    float SendLodGain{(ALContext->mLoadLevel >= MaxLoadLevel) ? GovernorSendGain : 0.0f};
+    if(ALContext->mSourceLod)
+    {
+        const ALuint oldlevel{voice->mLodLevel};
+        const float importance{DryGain.Base * props->Priority};
+        if(importance < ALContext->mLodLowGain * ((oldlevel > 1) ? LodHysteresis : 1.0f))
+            LodLevel = 2;
+        else if(importance < ALContext->mLodGain * ((oldlevel > 0) ? LodHysteresis : 1.0f))
+            LodLevel = maxu(LodLevel, 1u);
+        else if(ALContext->mLodDistance > 0.0f)
+        {
+            const float lod_dist{ALContext->mLodDistance * props->Priority /
+                ((oldlevel > 0) ? LodHysteresis : 1.0f)};
+            if(Distance*Listener.Params.MetersPerUnit > lod_dist)
+                LodLevel = maxu(LodLevel, 1u);
+        }
+        SendLodGain = maxf(SendLodGain, ALContext->mLodSendGain);
+    }
+    if(SendLodGain > 0.0f)
+    {
+        /* Sends too quiet to be heard fade out, then stop being mixed until
+         * they come back up.
+         */
+        for(ALuint i{0};i < NumSends;i++)
+        {
+            if(!SendSlots[i])
+                continue;
+            const bool active{(ActiveSends&(1u<<i)) != 0};
+            const float sendlevel{WetGain[i].Base * props->Priority};
+            if(!(sendlevel < SendLodGain * (active ? 1.0f : LodHysteresis)))
+                continue;
+            if(active)
+            {
+                WetGain[i].Base = 0.0f;
+                voice->mFadingSends |= 1u << i;
+            }
+            else
+            {
+                SendSlots[i] = nullptr;
+                voice->mSend[i].Buffer = {};
+            }
+        }
+    }
+    /* A new level of detail changes the HRIR length. */
+    if(LodLevel != voice->mLodLevel)
+        changes |= VOICE_CHANGED_SPATIAL;
+    voice->mLodLevel = LodLevel;
+
 
     /* Initial source pitch */
     float Pitch{props->Pitch};
+    float DopplerShift{1.0f};
 
     /* Calculate velocity-based doppler effect */
     float DopplerFactor{props->DopplerFactor * Listener.Params.DopplerFactor};
@@ -1533,6 +2032,7 @@ void CalcAttnSourceParams(Voice *voice, const VoiceProps *props, const ALCcontex
             /* Listener moving away from the source at the speed of sound.
              * Sound waves can't catch it.
              */
+            DopplerShift = 0.0f;
             Pitch = 0.0f;
         }
         else if(!(vss < SpeedOfSound))
@@ -1540,6 +2040,7 @@ void CalcAttnSourceParams(Voice *voice, const VoiceProps *props, const ALCcontex
             /* Source moving toward the listener at the speed of sound. Sound
              * waves bunch up to extreme frequencies.
              */
+            DopplerShift = std::numeric_limits<float>::infinity();
             Pitch = std::numeric_limits<float>::infinity();
         }
         else
@@ -1547,19 +2048,18 @@ void CalcAttnSourceParams(Voice *voice, const VoiceProps *props, const ALCcontex
             /* Source and listener movement is nominal. Calculate the proper
              * doppler shift.
              */
-            Pitch *= (SpeedOfSound-vls) / (SpeedOfSound-vss);
+            DopplerShift = (SpeedOfSound-vls) / (SpeedOfSound-vss);
+            Pitch *= DopplerShift;
         }
     }
 
     /* Adjust pitch based on the buffer and output frequencies, and calculate
      * fixed-point stepping value.
      */
-    Pitch *= static_cast<float>(voice->mFrequency) / static_cast<float>(Device->Frequency);
-    if(Pitch > float{MAX_PITCH})
-        voice->mStep = MAX_PITCH<<FRACTIONBITS;
-    else
-        voice->mStep = maxu(fastf2u(Pitch * FRACTIONONE), 1);
-    voice->mResampler = PrepareResampler(props->mResampler, voice->mStep, &voice->mResampleState);
+    const float rateScale{static_cast<float>(voice->mFrequency) /
+        static_cast<float>(Device->Frequency)};
+    voice->mPitchScale = DopplerShift * rateScale;
+    CalcVoiceStep(voice, Pitch * rateScale, props->mResampler);
 
     float spread{0.0f};
     if(props->Radius > Distance)
@@ -1567,30 +2067,231 @@ void CalcAttnSourceParams(Voice *voice, const VoiceProps *props, const ALCcontex
     else if(Distance > 0.0f)
         spread = std::asin(props->Radius/Distance) * 2.0f;
 
-    CalcPanningAndFilters(voice, ToSource[0], ToSource[1], ToSource[2]*ZScale,
-        Distance*Listener.Params.MetersPerUnit, spread, DryGain, WetGain, SendSlots, props,
-        Listener, Device);
+    /* Distant mono sources narrower than the clustering tolerance may be
+     * grouped with others in a similar direction.
+     */
+    const alu::Vector Panning{ToSource[0], ToSource[1], ToSource[2]*ZScale, 0.0f};
+    const float Meters{Distance * Listener.Params.MetersPerUnit};
+    WorldBus *world{ALContext->mWorldBus.get()};
+    if(world && !props->HeadRelative && voice->mFmtChannels == FmtMono
+        && !(voice->mFlags&VOICE_IS_BUS) && Distance > 0.0f && ZScale > 0.0f)
+    {
+        voice->mFlags |= VOICE_IS_WORLD_LOCKED;
+        voice->mDryBus = &world->mBus;
+        voice->mDirect.Buffer = world->mBus.mBuffer;
+    }
+    else if(!ALContext->mSpatialClusters.empty() && voice->mFmtChannels == FmtMono
+        && !(voice->mFlags&VOICE_IS_BUS) && Distance > 0.0f
+        && Meters >= ALContext->mClusterDistance*props->Priority
+        && spread <= ALContext->mClusterAngle)
+    {
+        if(SpatialCluster *cluster{GetSpatialCluster(ALContext, Panning, Meters)})
+        {
+            voice->mCluster = cluster;
+            voice->mDryBus = &cluster->mBus;
+            voice->mDirect.Buffer = cluster->mBus.mBuffer;
+        }
+    }
+
+    CalcPanningAndFilters(voice, Panning[0], Panning[1], Panning[2], Meters, spread, DryGain,
+        WetGain, SendSlots, props, Listener, Device, changes);
+
+    if((voice->mFlags&VOICE_IS_WORLD_LOCKED))
+    {
+        /* Pan into the bus by the world-space direction, leaving the
+         * listener's orientation to the bus.
+         */
+        alu::Vector dir{props->Position[0] - Listener.Params.WorldPosition[0],
+            props->Position[1] - Listener.Params.WorldPosition[1],
+            props->Position[2] - Listener.Params.WorldPosition[2], 0.0f};
+        dir.normalize();
+        const auto coeffs = CalcDirectionCoeffs({dir[0], dir[1], dir[2]}, spread);
+        ComputePanGains(&world->mMix, coeffs.data(), DryGain.Base,
+            voice->mChans[0].mDryParams.Gains.Target);
+    }
 }
 
-void CalcSourceParams(Voice *voice, ALCcontext *context, bool force)
+/* Returns the groups of properties that differ between the voice's current
+ * properties and an update. An update can replace one the mixer hasn't seen
+ * yet, so the changes are found here rather than tracked with the source.
+ */
+ALuint GetVoiceChanges(const VoiceProps &oldprops, const VoiceProps &newprops,
+    const ALuint numsends)
 {
+    ALuint changes{0u};
+    if(oldprops.Pitch != newprops.Pitch || oldprops.mResampler != newprops.mResampler)
+        changes |= VOICE_CHANGED_PITCH;
+    if(oldprops.Gain != newprops.Gain || oldprops.MinGain != newprops.MinGain
+        || oldprops.MaxGain != newprops.MaxGain || oldprops.Direct.Gain != newprops.Direct.Gain)
+        changes |= VOICE_CHANGED_GAIN;
+    if(oldprops.Direct.GainHF != newprops.Direct.GainHF
+        || oldprops.Direct.HFReference != newprops.Direct.HFReference
+        || oldprops.Direct.GainLF != newprops.Direct.GainLF
+        || oldprops.Direct.LFReference != newprops.Direct.LFReference)
+        changes |= VOICE_CHANGED_FILTER;
+    for(ALuint i{0};i < numsends;++i)
+    {
+        const VoiceProps::SendData &oldsend = oldprops.Send[i];
+        const VoiceProps::SendData &newsend = newprops.Send[i];
+        if(oldsend.Slot != newsend.Slot)
+            changes |= VOICE_CHANGED_GAIN | VOICE_CHANGED_FILTER;
+        if(oldsend.Gain != newsend.Gain)
+            changes |= VOICE_CHANGED_GAIN;
+        if(oldsend.GainHF != newsend.GainHF || oldsend.HFReference != newsend.HFReference
+            || oldsend.GainLF != newsend.GainLF || oldsend.LFReference != newsend.LFReference)
+            changes |= VOICE_CHANGED_FILTER;
+    }
+
+    if(oldprops.OuterGain != newprops.OuterGain || oldprops.InnerAngle != newprops.InnerAngle
+        || oldprops.OuterAngle != newprops.OuterAngle
+        || oldprops.RefDistance != newprops.RefDistance
+        || oldprops.MaxDistance != newprops.MaxDistance
+        || oldprops.RolloffFactor != newprops.RolloffFactor
+        || oldprops.Position != newprops.Position || oldprops.Velocity != newprops.Velocity
+        || oldprops.Direction != newprops.Direction || oldprops.OrientAt != newprops.OrientAt
+        || oldprops.OrientUp != newprops.OrientUp || oldprops.HeadRelative != newprops.HeadRelative
+        || oldprops.mDistanceModel != newprops.mDistanceModel
+        || oldprops.DirectChannels != newprops.DirectChannels
+        || oldprops.mSpatializeMode != newprops.mSpatializeMode
+        || oldprops.DryGainHFAuto != newprops.DryGainHFAuto
+        || oldprops.WetGainAuto != newprops.WetGainAuto
+        || oldprops.WetGainHFAuto != newprops.WetGainHFAuto
+        || oldprops.OuterGainHF != newprops.OuterGainHF
+        || oldprops.AirAbsorptionFactor != newprops.AirAbsorptionFactor
+        || oldprops.RoomRolloffFactor != newprops.RoomRolloffFactor
+        || oldprops.DopplerFactor != newprops.DopplerFactor
+        || oldprops.StereoPan != newprops.StereoPan || oldprops.Radius != newprops.Radius
+        || oldprops.Priority != newprops.Priority || oldprops.mSubmix != newprops.mSubmix)
+        changes |= VOICE_CHANGED_SPATIAL;
+    return changes;
+}
+
+/* Recalculates the voice's parameters for an update, and for the given forced
+ * changes. Only the stages affected by what changed are run.
+ */
+void CalcSourceParams(Voice *voice, ALCcontext *context, ALuint force)
+{
+    const bool starting{voice->mStep == 0};
     VoicePropsItem *props{voice->mUpdate.exchange(nullptr, std::memory_order_acq_rel)};
-    if(!props && !force) return;
+    if(!props && !force && !starting && !(voice->mFlags&VOICE_SWITCHING_DRY)) return;
 
+    /* Starting voices have nothing to keep from their last use, and voices
+     * that faded out to switch dry paths set up the new one from scratch.
+     */
+    ALuint changes{(starting || (voice->mFlags&VOICE_SWITCHING_DRY)) ? VOICE_CHANGED_ALL : force};
     if(props)
     {
+        if(!starting)
+            changes |= GetVoiceChanges(voice->mProps, *props, context->mDevice->NumAuxSends);
+        /* The bus the voice mixed into before won't be used by it anymore. */
+        if(SubmixBus *oldbus{voice->mProps.mSubmix})
+            DecrementRef(oldbus->mVoiceRef);
         voice->mProps = *props;
 
         AtomicReplaceHead(context->mFreeVoiceProps, props);
     }
+    if(!changes)
+        return;
+
+    /* A pitch change alone just needs a new stepping value. */
+    if(changes == VOICE_CHANGED_PITCH)
+    {
+        CalcVoiceStep(voice, voice->mProps.Pitch * voice->mPitchScale,
+            voice->mProps.mResampler);
+        if((voice->mFlags&VOICE_IS_BUS))
+            voice->mStep = FRACTIONONE;
+        return;
+    }
 
-    if((voice->mProps.DirectChannels != DirectMode::Off && voice->mFmtChannels != FmtMono
+    SubmixBus *const olddrybus{voice->mDryBus};
+    const auto olddry = voice->mDirect.Buffer;
+    SpatialCluster *const oldcluster{voice->mCluster};
+    const ALuint oldflags{voice->mFlags};
+    const ALuint oldlod{voice->mLodLevel};
+    const ResamplerFunc oldresampler{voice->mResampler};
+    const InterpState oldresamplestate{voice->mResampleState};
+    voice->mDryBus = voice->mProps.mSubmix;
+    voice->mCluster = nullptr;
+    voice->mFlags &= ~VOICE_IS_WORLD_LOCKED;
+    voice->mFadingSends = 0u;
+
+    if(voice->mProps.mSubmix)
+        CalcSubmixSourceParams(voice, &voice->mProps, context, changes);
+    else if((voice->mProps.DirectChannels != DirectMode::Off && voice->mFmtChannels != FmtMono
             && voice->mFmtChannels != FmtBFormat2D && voice->mFmtChannels != FmtBFormat3D)
         || voice->mProps.mSpatializeMode==SpatializeMode::Off
         || (voice->mProps.mSpatializeMode==SpatializeMode::Auto && voice->mFmtChannels != FmtMono))
-        CalcNonAttnSourceParams(voice, &voice->mProps, context);
+        CalcNonAttnSourceParams(voice, &voice->mProps, context, changes);
     else
-        CalcAttnSourceParams(voice, &voice->mProps, context);
+        CalcAttnSourceParams(voice, &voice->mProps, context, changes);
+
+    /* A bus plays its lines as they are, without pitch or doppler shifts. */
+    if((voice->mFlags&VOICE_IS_BUS))
+        voice->mStep = FRACTIONONE;
+
+    /* A new level of detail crossfades to its resampler, and near-field
+     * compensation on the output, over the next mix.
+     */
+    if(!starting && voice->mLodLevel != oldlod)
+    {
+        if(voice->mResampler != oldresampler)
+        {
+            voice->mPrevResampler = oldresampler;
+            voice->mPrevResampleState = oldresamplestate;
+        }
+        if(!voice->mDryBus && !olddrybus && ((voice->mFlags^oldflags)&VOICE_HAS_NFC))
+            voice->mFlags |= VOICE_NFC_FADING;
+    }
+
+    if(starting || voice->mDryBus == olddrybus)
+    {
+        voice->mFlags &= ~VOICE_SWITCHING_DRY;
+        return;
+    }
+
+    /* The gains for different submix buses (or the output) aren't comparable,
+     * so don't fade between them. Starting voices keep any fade-in they have.
+     */
+    const bool oldsubmix{olddrybus && !oldcluster && !(oldflags&VOICE_IS_WORLD_LOCKED)};
+    if UNLIKELY(oldsubmix || voice->mProps.mSubmix)
+    {
+        voice->mFlags &= ~(VOICE_IS_FADING | VOICE_SWITCHING_DRY);
+        return;
+    }
+
+    /* Spatial cluster and world-locked bus members joining or leaving a group
+     * first fade out on the old dry path, then fade in on the new one from
+     * silence with the next update.
+     */
+    if((voice->mFlags&VOICE_SWITCHING_DRY))
+    {
+        voice->mFlags &= ~VOICE_SWITCHING_DRY;
+        for(auto &chandata : voice->mChans)
+        {
+            DirectParams &parms = chandata.mDryParams;
+            std::fill(parms.Gains.Current.begin(), parms.Gains.Current.end(), 0.0f);
+            if(parms.Hrtf)
+                parms.Hrtf->Old.Gain = 0.0f;
+        }
+        return;
+    }
+
+    constexpr ALuint DryPathFlags{VOICE_HAS_HRTF | VOICE_HAS_NFC | VOICE_IS_WORLD_LOCKED};
+    voice->mDryBus = olddrybus;
+    voice->mDirect.Buffer = olddry;
+    voice->mCluster = oldcluster;
+    voice->mFlags = (voice->mFlags&~(DryPathFlags|VOICE_NFC_FADING)) | (oldflags&DryPathFlags)
+        | VOICE_SWITCHING_DRY;
+    for(auto &chandata : voice->mChans)
+    {
+        DirectParams &parms = chandata.mDryParams;
+        std::fill(parms.Gains.Target.begin(), parms.Gains.Target.end(), 0.0f);
+        if(parms.Hrtf)
+        {
+            parms.Hrtf->Target = parms.Hrtf->Old;
+            parms.Hrtf->Target.Gain = 0.0f;
+        }
+    }
 }
 
 
@@ -1707,17 +2408,87 @@ void ProcessParamUpdates(ALCcontext *ctx, const ALeffectslotArray &slots,
     IncrementRef(ctx->mUpdateCount);
     if LIKELY(!ctx->mHoldUpdates.load(std::memory_order_acquire))
     {
-        bool force{CalcContextParams(ctx)};
-        force |= CalcListenerParams(ctx);
+        /* Context, listener, and effect slot changes force the voice property
+         * groups that depend on them to be recalculated.
+         */
+        bool rotated{false};
+        ALuint force{CalcContextParams(ctx) ? VOICE_CHANGED_ALL : 0u};
+        force |= CalcListenerParams(ctx, rotated);
+        const ALuint loadlevel{ctx->mDevice->mLoadLevel.load(std::memory_order_relaxed)};
+        if UNLIKELY(loadlevel != ctx->mLoadLevel)
+        {
+            ctx->mLoadLevel = loadlevel;
+            force = VOICE_CHANGED_ALL;
+        }
         auto sorted_slots = const_cast<ALeffectslot**>(slots.data() + slots.size());
         for(ALeffectslot *slot : slots)
-            force |= CalcEffectSlotParams(slot, sorted_slots, ctx);
+        {
+            if(CalcEffectSlotParams(slot, sorted_slots, ctx))
+                force |= VOICE_CHANGED_GAIN | VOICE_CHANGED_FILTER;
+        }
+        if(force)
+        {
+            /* Slots outputting to a slot whose wet channel count changed need
+             * their output gains recalculated.
+             */
+            for(ALeffectslot *slot : slots)
+            {
+                ALeffectslot *target{slot->Params.Target};
+                EffectState *state{slot->Params.mEffectState};
+                if(target && state->mOutTarget.size() != target->Wet.Buffer.size())
+                    state->update(ctx, slot, &slot->Params.mEffectProps,
+                        EffectTarget{&target->Wet, nullptr});
+            }
+        }
 
+        WorldBus *world{ctx->mWorldBus.get()};
         for(Voice *voice : voices)
         {
-            /* Only update voices that have a source. */
+            /* Only update voices that have a source. World-locked voices don't
+             * need updating when the listener only turned.
+             */
             if(voice->mSourceID.load(std::memory_order_relaxed) != 0)
-                CalcSourceParams(voice, ctx, force);
+            {
+                CalcSourceParams(voice, ctx, (rotated && !(voice->mFlags&VOICE_IS_WORLD_LOCKED))
+                    ? VOICE_CHANGED_ALL : force);
+                if(SpatialCluster *cluster{voice->mCluster})
+                    ++cluster->mNewMembers;
+                else if((voice->mFlags&VOICE_IS_WORLD_LOCKED))
+                    ++world->mNewMembers;
+            }
+        }
+
+        /* The world-locked bus is rotated for the listener, and set up
+         * without fading when it starts being used.
+         */
+        if(world)
+        {
+            const bool starting{!world->mActive && world->mNewMembers != 0};
+            world->mActive = world->mNumMembers != 0 || world->mNewMembers != 0;
+            world->mNumMembers = world->mNewMembers;
+            world->mNewMembers = 0u;
+            if(starting || force || rotated)
+                CalcWorldBusParams(world, ctx);
+            if(starting)
+                world->mVoice.mFlags &= ~VOICE_IS_FADING;
+        }
+
+        /* Clusters that lost their last members still get mixed for this
+         * update, so stopping members can fade out.
+         */
+        if(!ctx->mSpatialClusters.empty())
+        {
+            ALuint clustered{0u}, active{0u};
+            for(SpatialCluster &cluster : ctx->mSpatialClusters)
+            {
+                clustered += cluster.mNewMembers;
+                active += (cluster.mNewMembers != 0) ? 1u : 0u;
+                cluster.mActive = cluster.mNumMembers != 0 || cluster.mNewMembers != 0;
+                cluster.mNumMembers = cluster.mNewMembers;
+                cluster.mNewMembers = 0u;
+            }
+            ctx->mClusteredSources.store(clustered, std::memory_order_relaxed);
+            ctx->mActiveClusters.store(active, std::memory_order_relaxed);
         }
     }
     IncrementRef(ctx->mUpdateCount);
@@ -1738,17 +2509,44 @@ void ProcessContexts(ALCdevice *device, const ALuint SamplesToDo)
         /* Clear auxiliary effect slot mixing buffers. */
         for(ALeffectslot *slot : auxslots)
         {
-            for(auto &buffer : slot->MixBuffer)
+            for(auto &buffer : slot->Wet.Buffer)
                 buffer.fill(0.0f);
         }
 
-        /* Process voices that have a playing source. */
+        /* Process voices that have a playing source. Submix bus voices wait
+         * for their members to be mixed first.
+         */
+        bool have_buses{false};
         for(Voice *voice : voices)
         {
             const Voice::State vstate{voice->mPlayState.load(std::memory_order_acquire)};
-            if(vstate != Voice::Stopped && vstate != Voice::Pending)
+            if(vstate == Voice::Stopped || vstate == Voice::Pending)
+                continue;
+            if UNLIKELY((voice->mFlags&VOICE_IS_BUS))
+                have_buses = true;
+            else
                 voice->mix(vstate, ctx, SamplesToDo);
         }
+        if UNLIKELY(have_buses)
+        {
+            for(Voice *voice : voices)
+            {
+                const Voice::State vstate{voice->mPlayState.load(std::memory_order_acquire)};
+                if(vstate != Voice::Stopped && vstate != Voice::Pending
+                    && (voice->mFlags&VOICE_IS_BUS))
+                    voice->mix(vstate, ctx, SamplesToDo);
+            }
+        }
+        for(SpatialCluster &cluster : ctx->mSpatialClusters)
+        {
+            if(cluster.mActive)
+                cluster.mVoice.mix(Voice::Playing, ctx, SamplesToDo);
+        }
+        if(WorldBus *world{ctx->mWorldBus.get()})
+        {
+            if(world->mActive)
+                world->mVoice.mix(Voice::Playing, ctx, SamplesToDo);
+        }
 
         /* Process effects. */
         if(const size_t num_slots{auxslots.size()})
@@ -1919,12 +2717,72 @@ void Write(const al::span<const FloatBufferLine> InBuffer, void *OutBuffer, cons
     }
 }
 
+void SendLoadLevelEvent(ALCdevice *device, ALuint level)
+{
+    static constexpr char msg[]{"Mixer load governor level changed"};
+    for(ALCcontext *ctx : *device->mContexts.load(std::memory_order_acquire))
+    {
+        const ALbitfieldSOFT enabledevt{ctx->mEnabledEvts.load(std::memory_order_acquire)};
+        if(!(enabledevt&EventType_Performance))
+            continue;
+
+        RingBuffer *ring{ctx->mAsyncEvents.get()};
+        auto evt_vec = ring->getWriteVector();
+        if(evt_vec.first.len > 0)
+        {
+            AsyncEvent *evt{::new(evt_vec.first.buf) AsyncEvent{EventType_Performance}};
+            evt->u.user.type = AL_EVENT_TYPE_PERFORMANCE_SOFT;
+            evt->u.user.id = 0;
+            evt->u.user.param = level;
+            std::copy(std::begin(msg), std::end(msg), evt->u.user.msg);
+            ring->writeAdvance(1);
+            ctx->mEventSem.post();
+        }
+    }
+}
+
+/* Updates the mixer load from the time taken to mix the given number of
+ * samples. Quality is lowered quickly when the load goes over the high mark,
+ * but only restored after the load has been under the low mark for a while,
+ * so it doesn't switch back and forth.
+ */
+void UpdateLoadGovernor(ALCdevice *device, const std::chrono::nanoseconds elapsed,
+    const ALuint NumSamples)
+{
+    using std::chrono::nanoseconds;
+    using std::chrono::seconds;
+
+    const nanoseconds deadline{nanoseconds{seconds{NumSamples}} / device->Frequency};
+    const float load{static_cast<float>(elapsed.count()) /
+        static_cast<float>(maxi64(deadline.count(), 1))};
+    device->mMixLoad = lerp(device->mMixLoad, load, (load > device->mMixLoad) ? 0.5f : 0.05f);
+
+    /* Wait at least 100ms between lowering quality, and 1s before raising it. */
+    device->mGovernorHold = minu(device->mGovernorHold+NumSamples, device->Frequency);
+    ALuint level{device->mLoadLevel.load(std::memory_order_relaxed)};
+    if(device->mMixLoad > device->mGovernorHighLoad && level < MaxLoadLevel
+        && device->mGovernorHold >= device->Frequency/10)
+        ++level;
+    else if(device->mMixLoad < device->mGovernorLowLoad && level > 0
+        && device->mGovernorHold >= device->Frequency)
+        --level;
+    else
+        return;
+
+    device->mGovernorHold = 0;
+    device->mLoadLevel.store(level, std::memory_order_relaxed);
+    SendLoadLevelEvent(device, level);
+}
+
 } // namespace
 
 void aluMixData(ALCdevice *device, void *OutBuffer, const ALuint NumSamples,
     const size_t FrameStep)
 {
     FPUCtl mixer_mode{};
+    std::chrono::steady_clock::time_point mix_start{};
+    if UNLIKELY(device->mLoadGovernor)
+        mix_start = std::chrono::steady_clock::now();
     for(ALuint SamplesDone{0u};SamplesDone < NumSamples;)
     {
         const ALuint SamplesToDo{minu(NumSamples-SamplesDone, BUFFERSIZE)};
@@ -1993,6 +2851,9 @@ void aluMixData(ALCdevice *device, void *OutBuffer, const ALuint NumSamples,
 
         SamplesDone += SamplesToDo;
     }
+
+    if UNLIKELY(device->mLoadGovernor)
+        UpdateLoadGovernor(device, std::chrono::steady_clock::now() - mix_start, NumSamples);
 }
 
 
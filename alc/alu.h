@@ -16,7 +16,6 @@ struct ALeffectslot;
 
 
 #define MAX_PITCH  10
-#define MAX_SENDS  6
 
 
 using MixerFunc = void(*)(const al::span<const float> InSamples,
@@ -132,7 +131,7 @@ inline std::array<float,MAX_AMBI_CHANNELS> CalcAngleCoeffs(const float azimuth,
  * scale and orient the sound samples.
  */
 void ComputePanGains(const MixParams *mix, const float*RESTRICT coeffs, const float ingain,
-    const al::span<float,MAX_OUTPUT_CHANNELS> gains);
+    const al::span<float> gains);
 
 
 /** Helper to set an identity/pass-through panning for ambisonic mixing (3D input). */
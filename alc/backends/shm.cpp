@@ -0,0 +1,447 @@
+/**
+ * OpenAL cross platform audio library
+ * Copyright (C) 2026 by authors.
+ * This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ *  License along with this library; if not, write to the
+ *  Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ * Or go to http://www.gnu.org/copyleft/lgpl.html
+ */
+
+#include "config.h"
+
+#include "backends/shm.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cinttypes>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <exception>
+#include <functional>
+#include <new>
+#include <string>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "AL/al.h"
+
+#include "albyte.h"
+#include "alcmain.h"
+#include "alconfig.h"
+#include "alexcpt.h"
+#include "almalloc.h"
+#include "alnumeric.h"
+#include "alu.h"
+#include "logging.h"
+#include "threads.h"
+
+
+namespace {
+
+using std::chrono::seconds;
+using std::chrono::milliseconds;
+using std::chrono::nanoseconds;
+
+constexpr ALCchar shmDevice[] = "Shared Memory Ring";
+
+
+/* Posts the semaphore, unless it's already posted. It's used as a wake-up
+ * signal, so the waiter rechecks the positions regardless of the count.
+ */
+void SignalSemaphore(sem_t *sem)
+{
+    int value{0};
+    if(sem_getvalue(sem, &value) == 0 && value > 0)
+        return;
+    sem_post(sem);
+}
+
+/* Waits for the semaphore to be posted, up to the given timeout. */
+bool WaitSemaphore(sem_t *sem, const nanoseconds timeout)
+{
+    timespec ts{};
+    clock_gettime(CLOCK_REALTIME, &ts);
+    const nanoseconds deadline{nanoseconds{ts.tv_nsec} + timeout};
+    ts.tv_sec += static_cast<time_t>(std::chrono::duration_cast<seconds>(deadline).count());
+    ts.tv_nsec = static_cast<long>((deadline % seconds{1}).count());
+
+    while(sem_timedwait(sem, &ts) != 0)
+    {
+        if(errno != EINTR)
+            return false;
+    }
+    return true;
+}
+
+
+struct ShmBackend final : public BackendBase {
+    ShmBackend(ALCdevice *device) noexcept : BackendBase{device} { }
+    ~ShmBackend() override;
+
+    int mixerProc();
+
+    void open(const ALCchar *name) override;
+    bool reset() override;
+    void start() override;
+    void stop() override;
+    ClockLatency getClockLatency() override;
+
+    void closeRing();
+
+    std::string mName;
+    bool mBlocking{false};
+
+    void *mMapping{nullptr};
+    size_t mMapSize{0u};
+    ShmRingHeader *mHeader{nullptr};
+    al::byte *mRing{nullptr};
+    ALuint mCapacity{0u};
+    ALuint mFrameSize{0u};
+
+    std::atomic<bool> mKillNow{true};
+    std::thread mThread;
+
+    DEF_NEWDEL(ShmBackend)
+};
+
+ShmBackend::~ShmBackend()
+{ closeRing(); }
+
+/* Marks the ring as closed and removes it. The semaphores are left alone,
+ * since a consumer may still be waiting on them, and the memory stays valid
+ * for any consumer that has it mapped until it unmaps it.
+ */
+void ShmBackend::closeRing()
+{
+    if(!mHeader)
+        return;
+
+    mHeader->state.store(ShmRingClosed, std::memory_order_release);
+    sem_post(&mHeader->dataReady);
+    sem_post(&mHeader->spaceReady);
+
+    munmap(mMapping, mMapSize);
+    shm_unlink(mName.c_str());
+
+    mMapping = nullptr;
+    mMapSize = 0;
+    mHeader = nullptr;
+    mRing = nullptr;
+}
+
+int ShmBackend::mixerProc()
+{
+    const milliseconds restTime{mDevice->UpdateSize*1000/mDevice->Frequency / 2};
+
+    SetRTPriority();
+    althrd_setname(MIXER_THREAD_NAME);
+
+    const ALuint update{mDevice->UpdateSize};
+    const size_t frameStep{mDevice->channelsFromFmt()};
+
+    int64_t done{0};
+    auto start = std::chrono::steady_clock::now();
+    while(!mKillNow.load(std::memory_order_acquire) &&
+          mDevice->Connected.load(std::memory_order_acquire))
+    {
+        const uint64_t writePos{mHeader->writePos.load(std::memory_order_relaxed)};
+        const uint64_t readPos{mHeader->readPos.load(std::memory_order_acquire)};
+
+        /* Get the number of frames still waiting to be read. The consumer's
+         * read position isn't trusted to be sane.
+         */
+        const uint64_t queued{(readPos < writePos) ?
+            std::min(writePos-readPos, uint64_t{mCapacity}) : 0u};
+
+        if(mBlocking)
+        {
+            /* The consumer paces the output, with another update mixed
+             * whenever there's space for it.
+             */
+            if(mCapacity-queued < update)
+            {
+                WaitSemaphore(&mHeader->spaceReady, restTime);
+                continue;
+            }
+        }
+        else
+        {
+            auto now = std::chrono::steady_clock::now();
+
+            /* This converts from nanoseconds to nanosamples, then to samples. */
+            int64_t avail{std::chrono::duration_cast<seconds>((now-start) *
+                mDevice->Frequency).count()};
+            if(avail-done < update)
+            {
+                std::this_thread::sleep_for(restTime);
+                continue;
+            }
+
+            /* Any unread frames about to be overwritten are lost. */
+            if(queued+update > mCapacity)
+                mHeader->overruns.fetch_add(queued+update - mCapacity,
+                    std::memory_order_relaxed);
+            done += update;
+
+            /* For every completed second, increment the start time and reduce
+             * the samples done. This prevents the difference between the start
+             * time and current time from growing too large, while maintaining
+             * the correct number of samples to render.
+             */
+            if(done >= mDevice->Frequency)
+            {
+                seconds s{done/mDevice->Frequency};
+                start += s;
+                done -= mDevice->Frequency*s.count();
+            }
+        }
+
+        /* Mark the frames about to be overwritten before touching them, so a
+         * consumer copying them out can tell they may be torn.
+         */
+        mHeader->writeEnd.store(writePos+update, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        /* The ring holds a whole number of updates, so each one is mixed
+         * straight into it without wrapping.
+         */
+        al::byte *dst{mRing + (writePos%mCapacity)*mFrameSize};
+        aluMixData(mDevice, dst, update, frameStep);
+
+        mHeader->clockTime.store(GetDeviceClockTime(mDevice).count(), std::memory_order_relaxed);
+        mHeader->writePos.store(writePos+update, std::memory_order_release);
+        SignalSemaphore(&mHeader->dataReady);
+    }
+
+    return 0;
+}
+
+void ShmBackend::open(const ALCchar *name)
+{
+    const char *shmname{GetConfigValue(nullptr, "shm", "name", "")};
+    if(!shmname[0])
+        throw al::backend_exception{ALC_INVALID_VALUE, "No shared memory name"};
+
+    if(!name)
+        name = shmDevice;
+    else if(strcmp(name, shmDevice) != 0)
+        throw al::backend_exception{ALC_INVALID_VALUE, "Device name \"%s\" not found", name};
+
+    /* Portable shared memory names are a single leading slash followed by a
+     * file name.
+     */
+    mName = (shmname[0] == '/') ? shmname : (std::string{"/"} + shmname);
+    if(mName.size() < 2 || mName.find('/', 1) != std::string::npos)
+        throw al::backend_exception{ALC_INVALID_VALUE, "Invalid shared memory name \"%s\"",
+            shmname};
+    mBlocking = GetConfigValueBool(nullptr, "shm", "blocking", 0) != 0;
+
+    mDevice->DeviceName = name;
+}
+
+bool ShmBackend::reset()
+{
+    closeRing();
+
+    ALuint chanmask{0};
+    switch(mDevice->FmtChans)
+    {
+        case DevFmtMono:   chanmask = 0x04; break;
+        case DevFmtStereo: chanmask = 0x01 | 0x02; break;
+        case DevFmtQuad:   chanmask = 0x01 | 0x02 | 0x10 | 0x20; break;
+        case DevFmtX51: chanmask = 0x01 | 0x02 | 0x04 | 0x08 | 0x200 | 0x400; break;
+        case DevFmtX51Rear: chanmask = 0x01 | 0x02 | 0x04 | 0x08 | 0x010 | 0x020; break;
+        case DevFmtX61: chanmask = 0x01 | 0x02 | 0x04 | 0x08 | 0x100 | 0x200 | 0x400; break;
+        case DevFmtX71: chanmask = 0x01 | 0x02 | 0x04 | 0x08 | 0x010 | 0x020 | 0x200 | 0x400; break;
+        case DevFmtAmbi3D: break;
+    }
+
+    /* Keep the ring to a whole number of updates, with at least two. */
+    mDevice->BufferSize = static_cast<ALuint>(RoundUp(maxu(mDevice->BufferSize,
+        mDevice->UpdateSize*2), mDevice->UpdateSize));
+    mCapacity = mDevice->BufferSize;
+    mFrameSize = mDevice->frameSizeFromFmt();
+
+    const size_t dataOffset{RoundUp(sizeof(ShmRingHeader), 64)};
+    const size_t mapSize{dataOffset + size_t{mCapacity}*mFrameSize};
+
+    int fd{shm_open(mName.c_str(), O_RDWR|O_CREAT|O_EXCL, 0600)};
+    if(fd == -1 && errno == EEXIST)
+    {
+        /* Most likely left over from a process that didn't close the device. */
+        WARN("Replacing existing shared memory object %s\n", mName.c_str());
+        shm_unlink(mName.c_str());
+        fd = shm_open(mName.c_str(), O_RDWR|O_CREAT|O_EXCL, 0600);
+    }
+    if(fd == -1)
+    {
+        ERR("Failed to create shared memory object %s: %s\n", mName.c_str(), strerror(errno));
+        return false;
+    }
+    void *ptr{MAP_FAILED};
+    if(ftruncate(fd, static_cast<off_t>(mapSize)) == 0)
+        ptr = mmap(nullptr, mapSize, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+    if(ptr == MAP_FAILED)
+    {
+        ERR("Failed to map %zu bytes of shared memory: %s\n", mapSize, strerror(errno));
+        close(fd);
+        shm_unlink(mName.c_str());
+        return false;
+    }
+    close(fd);
+
+    auto *header = ::new(ptr) ShmRingHeader{};
+    if(sem_init(&header->dataReady, 1, 0) != 0 || sem_init(&header->spaceReady, 1, 0) != 0)
+    {
+        ERR("Failed to create shared semaphores: %s\n", strerror(errno));
+        munmap(ptr, mapSize);
+        shm_unlink(mName.c_str());
+        return false;
+    }
+    mMapping = ptr;
+    mMapSize = mapSize;
+    mHeader = header;
+    mRing = static_cast<al::byte*>(ptr) + dataOffset;
+
+    header->version = ShmRingVersion;
+    header->dataOffset = static_cast<uint32_t>(dataOffset);
+    header->sampleRate = mDevice->Frequency;
+    header->sampleType = static_cast<uint32_t>(mDevice->FmtType);
+    header->channelCount = mDevice->channelsFromFmt();
+    header->channelMask = chanmask;
+    if(mDevice->FmtChans == DevFmtAmbi3D)
+    {
+        header->ambiOrder = mDevice->mAmbiOrder;
+        header->ambiLayout = static_cast<uint32_t>(mDevice->mAmbiLayout);
+        header->ambiScale = static_cast<uint32_t>(mDevice->mAmbiScale);
+    }
+    header->frameSize = mFrameSize;
+    header->capacity = mCapacity;
+    header->updateSize = mDevice->UpdateSize;
+    header->blocking = mBlocking ? 1u : 0u;
+    header->state.store(ShmRingStopped, std::memory_order_relaxed);
+
+    /* Set the magic last, so consumers don't see a partial header. */
+    std::atomic_thread_fence(std::memory_order_release);
+    std::copy(std::begin(ShmRingMagic), std::end(ShmRingMagic), header->magic);
+
+    TRACE("Created %s with %u frames of %u bytes\n", mName.c_str(), mCapacity, mFrameSize);
+
+    setDefaultWFXChannelOrder();
+
+    return true;
+}
+
+void ShmBackend::start()
+{
+    try {
+        mHeader->state.store(ShmRingPlaying, std::memory_order_release);
+        mKillNow.store(false, std::memory_order_release);
+        mThread = std::thread{std::mem_fn(&ShmBackend::mixerProc), this};
+    }
+    catch(std::exception& e) {
+        mHeader->state.store(ShmRingStopped, std::memory_order_release);
+        throw al::backend_exception{ALC_INVALID_DEVICE, "Failed to start mixing thread: %s",
+            e.what()};
+    }
+}
+
+void ShmBackend::stop()
+{
+    if(mKillNow.exchange(true, std::memory_order_acq_rel) || !mThread.joinable())
+        return;
+    mThread.join();
+
+    /* Wake any waiting consumer so it sees the device stopped. */
+    mHeader->state.store(ShmRingStopped, std::memory_order_release);
+    SignalSemaphore(&mHeader->dataReady);
+
+    const uint64_t overruns{mHeader->overruns.load(std::memory_order_relaxed)};
+    if(overruns > 0)
+        WARN("%" PRIu64 " frames were overwritten before being read\n", overruns);
+}
+
+ClockLatency ShmBackend::getClockLatency()
+{
+    if(!mHeader)
+        return BackendBase::getClockLatency();
+
+    ClockLatency ret;
+    uint64_t writePos;
+
+    ALuint refcount;
+    do {
+        refcount = mDevice->waitForMix();
+        ret.ClockTime = GetDeviceClockTime(mDevice);
+        writePos = mHeader->writePos.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while(refcount != ReadRef(mDevice->MixCount));
+
+    /* The latency is however much is waiting in the ring for the consumer. */
+    const uint64_t readPos{mHeader->readPos.load(std::memory_order_acquire)};
+    const uint64_t queued{(readPos < writePos) ?
+        std::min(writePos-readPos, uint64_t{mCapacity}) : 0u};
+    ret.Latency = std::chrono::seconds{queued};
+    ret.Latency /= mDevice->Frequency;
+
+    return ret;
+}
+
+} // namespace
+
+
+bool ShmBackendFactory::init()
+{
+    /* The positions are shared with other processes, so they can't rely on a
+     * process-local lock.
+     */
+    return std::atomic<uint64_t>{}.is_lock_free();
+}
+
+bool ShmBackendFactory::querySupport(BackendType type)
+{ return type == BackendType::Playback; }
+
+std::string ShmBackendFactory::probe(BackendType type)
+{
+    std::string outnames;
+    switch(type)
+    {
+    case BackendType::Playback:
+        /* Includes null char. */
+        outnames.append(shmDevice, sizeof(shmDevice));
+        break;
+    case BackendType::Capture:
+        break;
+    }
+    return outnames;
+}
+
+BackendPtr ShmBackendFactory::createBackend(ALCdevice *device, BackendType type)
+{
+    if(type == BackendType::Playback)
+        return BackendPtr{new ShmBackend{device}};
+    return nullptr;
+}
+
+BackendFactory &ShmBackendFactory::getFactory()
+{
+    static ShmBackendFactory factory{};
+    return factory;
+}
@@ -0,0 +1,21 @@
+#ifndef BACKENDS_SHM_H
+#define BACKENDS_SHM_H
+
+#include "backends/base.h"
+#include "backends/shmring.h"
+
+
+struct ShmBackendFactory final : public BackendFactory {
+public:
+    bool init() override;
+
+    bool querySupport(BackendType type) override;
+
+    std::string probe(BackendType type) override;
+
+    BackendPtr createBackend(ALCdevice *device, BackendType type) override;
+
+    static BackendFactory &getFactory();
+};
+
+#endif /* BACKENDS_SHM_H */
@@ -0,0 +1,96 @@
+#ifndef BACKENDS_SHMRING_H
+#define BACKENDS_SHMRING_H
+
+#include <atomic>
+#include <cstdint>
+
+#include <semaphore.h>
+
+
+/* Layout of the shared memory object the backend mixes into, for consumer
+ * processes to map. The header is followed (at dataOffset bytes from the
+ * start) by a ring of 'capacity' sample frames, with frame N of the output
+ * stored at ring index N % capacity.
+ *
+ * A consumer reads the frames from readPos up to writePos, then advances
+ * readPos. It may poll writePos, or wait on dataReady which the device posts
+ * after writing more frames. Unless the device is blocking, it won't wait for
+ * the consumer and frames left unread for longer than the ring length are
+ * overwritten (counted in overruns).
+ *
+ * The device mixes in place, so an update being overwritten starts before
+ * writePos moves. Before mixing, the device sets writeEnd to the end of the
+ * update it's about to write, followed by a release fence. After copying
+ * frames out, a consumer issues an acquire fence and loads writeEnd; any of
+ * the copied frames before writeEnd-capacity may be torn and must be dropped.
+ * See examples/alshmread.cpp for a consumer.
+ */
+struct ShmRingHeader {
+    /* Holds ShmRingMagic once the rest of the header is initialized. */
+    char magic[8];
+    uint32_t version;
+    uint32_t dataOffset;
+
+    /* The sample rate, and sample type as an ALC_SOFT_loopback enum value
+     * (ALC_SHORT_SOFT, ALC_FLOAT_SOFT, etc).
+     */
+    uint32_t sampleRate;
+    uint32_t sampleType;
+    /* Interleaved channels in WAVEFORMATEXTENSIBLE order, given the speaker
+     * mask. Ambisonic output has a mask of 0, with the order, channel layout,
+     * and normalization given as ALC_SOFT_loopback_bformat enum values.
+     */
+    uint32_t channelCount;
+    uint32_t channelMask;
+    uint32_t ambiOrder;
+    uint32_t ambiLayout;
+    uint32_t ambiScale;
+    uint32_t frameSize;
+
+    /* Length of the ring, and the number of frames mixed at a time. */
+    uint32_t capacity;
+    uint32_t updateSize;
+
+    /* Nonzero if the device waits for the consumer to free space in the ring,
+     * rather than playing in real time.
+     */
+    uint32_t blocking;
+    /* The ShmRingState of the device. Consumers should unmap the object once
+     * it's closed.
+     */
+    std::atomic<uint32_t> state;
+
+    /* Total frames written by the device, the total it will have written
+     * once the update currently being mixed is done (equal to writePos when
+     * idle), and the device clock time (in nanoseconds) at the end of the
+     * last write.
+     */
+    alignas(64) std::atomic<uint64_t> writePos;
+    std::atomic<uint64_t> writeEnd;
+    std::atomic<int64_t> clockTime;
+    /* Frames lost by being overwritten before the consumer read them. */
+    std::atomic<uint64_t> overruns;
+
+    /* Total frames read by the consumer, and the number of times it found
+     * the ring empty when it needed more (maintained by the consumer).
+     */
+    alignas(64) std::atomic<uint64_t> readPos;
+    std::atomic<uint64_t> underruns;
+
+    /* Process-shared semaphores, posted by the device after writing and by
+     * the consumer after reading (when not already posted).
+     */
+    alignas(64) sem_t dataReady;
+    sem_t spaceReady;
+};
+
+constexpr char ShmRingMagic[8]{'A','L','S','H','R','I','N','G'};
+constexpr uint32_t ShmRingVersion{2};
+
+enum ShmRingState : uint32_t {
+    ShmRingStopped = 0,
+    ShmRingPlaying = 1,
+    ShmRingClosed = 2
+};
+
+#endif /* BACKENDS_SHMRING_H */
@@ -41,6 +41,7 @@
 #include "alexcpt.h"
 #include "almalloc.h"
 #include "alnumeric.h"
+#include "alstring.h"
 #include "alu.h"
 #include "compat.h"
 #include "endiantest.h"
@@ -58,6 +59,9 @@ using std::chrono::nanoseconds;
 
 constexpr ALCchar waveDevice[] = "Wave File Writer";
 
+/* How much to mix before writing, when freewheeling. */
+constexpr size_t FreewheelBufferBytes{1u << 20};
+
 constexpr ALubyte SUBTYPE_PCM[]{
     0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0xaa,
     0x00, 0x38, 0x9b, 0x71
@@ -77,6 +81,19 @@ constexpr ALubyte SUBTYPE_BFORMAT_FLOAT[]{
     0xca, 0x00, 0x00, 0x00
 };
 
+constexpr ALubyte Wave64RiffGuid[16]{
+    'r','i','f','f', 0x2e,0x91,0xcf,0x11, 0xa5,0xd6,0x28,0xdb,0x04,0xc1,0x00,0x00
+};
+constexpr ALubyte Wave64WaveGuid[16]{
+    'w','a','v','e', 0xf3,0xac,0xd3,0x11, 0x8c,0xd1,0x00,0xc0,0x4f,0x8e,0xdb,0x8a
+};
+constexpr ALubyte Wave64FmtGuid[16]{
+    'f','m','t',' ', 0xf3,0xac,0xd3,0x11, 0x8c,0xd1,0x00,0xc0,0x4f,0x8e,0xdb,0x8a
+};
+constexpr ALubyte Wave64DataGuid[16]{
+    'd','a','t','a', 0xf3,0xac,0xd3,0x11, 0x8c,0xd1,0x00,0xc0,0x4f,0x8e,0xdb,0x8a
+};
+
 void fwrite16le(ALushort val, FILE *f)
 {
     ALubyte data[2]{ static_cast<ALubyte>(val&0xff), static_cast<ALubyte>((val>>8)&0xff) };
@@ -90,22 +107,59 @@ void fwrite32le(ALuint val, FILE *f)
     fwrite(data, 1, 4, f);
 }
 
+void fwrite64le(uint64_t val, FILE *f)
+{
+    fwrite32le(static_cast<ALuint>(val&0xffffffff), f);
+    fwrite32le(static_cast<ALuint>(val>>32), f);
+}
+
+/* File positions can go past what a 32-bit long holds, so these use 64-bit
+ * offsets where long is smaller.
+ */
+int fseek64(FILE *f, int64_t offset, int origin)
+{
+#ifdef _WIN32
+    return _fseeki64(f, offset, origin);
+#else
+    return fseeko(f, static_cast<off_t>(offset), origin);
+#endif
+}
+
+int64_t ftell64(FILE *f)
+{
+#ifdef _WIN32
+    return _ftelli64(f);
+#else
+    return ftello(f);
+#endif
+}
+
 
 struct WaveBackend final : public BackendBase {
     WaveBackend(ALCdevice *device) noexcept : BackendBase{device} { }
     ~WaveBackend() override;
 
     int mixerProc();
+    bool writeFrames(const ALuint frames);
 
     void open(const ALCchar *name) override;
     bool reset() override;
     void start() override;
     void stop() override;
+    ClockLatency getClockLatency() override;
 
     FILE *mFile{nullptr};
-    long mDataStart{-1};
+    /* Wave64 is used for .w64 files. Otherwise it's a RIFF WAVE file, which
+     * is turned into RF64 if it ends up too large.
+     */
+    bool mWave64{false};
+    bool mFreewheel{false};
+    int64_t mDataStart{-1};
+    uint64_t mDataSize{0u};
 
     al::vector<al::byte> mBuffer;
+    /* Frames mixed but not yet written out, for the reported latency. */
+    std::atomic<ALuint> mPendingFrames{0u};
 
     std::atomic<bool> mKillNow{true};
     std::thread mThread;
@@ -128,12 +182,32 @@ int WaveBackend::mixerProc()
 
     const size_t frameStep{mDevice->channelsFromFmt()};
     const ALuint frameSize{mDevice->frameSizeFromFmt()};
+    const auto bufferFrames = static_cast<ALuint>(mBuffer.size() / frameSize);
 
+    ALuint buffered{0};
     int64_t done{0};
     auto start = std::chrono::steady_clock::now();
     while(!mKillNow.load(std::memory_order_acquire) &&
           mDevice->Connected.load(std::memory_order_acquire))
     {
+        if(mFreewheel)
+        {
+            /* Mix as fast as possible, writing the buffer out when it can't
+             * fit another update.
+             */
+            aluMixData(mDevice, mBuffer.data() + size_t{buffered}*frameSize, mDevice->UpdateSize,
+                frameStep);
+            buffered += mDevice->UpdateSize;
+            if(bufferFrames-buffered < mDevice->UpdateSize)
+            {
+                if(!writeFrames(buffered))
+                    break;
+                buffered = 0;
+            }
+            mPendingFrames.store(buffered, std::memory_order_release);
+            continue;
+        }
+
         auto now = std::chrono::steady_clock::now();
 
         /* This converts from nanoseconds to nanosamples, then to samples. */
@@ -149,41 +223,8 @@ int WaveBackend::mixerProc()
             aluMixData(mDevice, mBuffer.data(), mDevice->UpdateSize, frameStep);
             done += mDevice->UpdateSize;
 
-            if(!IS_LITTLE_ENDIAN)
-            {
-                const ALuint bytesize{mDevice->bytesFromFmt()};
-
-                if(bytesize == 2)
-                {
-                    ALushort *samples = reinterpret_cast<ALushort*>(mBuffer.data());
-                    const size_t len{mBuffer.size() / 2};
-                    for(size_t i{0};i < len;i++)
-                    {
-                        const ALushort samp{samples[i]};
-                        samples[i] = static_cast<ALushort>((samp>>8) | (samp<<8));
-                    }
-                }
-                else if(bytesize == 4)
-                {
-                    ALuint *samples = reinterpret_cast<ALuint*>(mBuffer.data());
-                    const size_t len{mBuffer.size() / 4};
-                    for(size_t i{0};i < len;i++)
-                    {
-                        const ALuint samp{samples[i]};
-                        samples[i] = (samp>>24) | ((samp>>8)&0x0000ff00) |
-                                     ((samp<<8)&0x00ff0000) | (samp<<24);
-                    }
-                }
-            }
-
-            size_t fs{fwrite(mBuffer.data(), frameSize, mDevice->UpdateSize, mFile)};
-            (void)fs;
-            if(ferror(mFile))
-            {
-                ERR("Error writing to file\n");
-                aluHandleDisconnect(mDevice, "Failed to write playback samples");
+            if(!writeFrames(mDevice->UpdateSize))
                 break;
-            }
         }
 
         /* For every completed second, increment the start time and reduce the
@@ -198,10 +239,57 @@ int WaveBackend::mixerProc()
             done -= mDevice->Frequency*s.count();
         }
     }
+    /* Write out whatever's left from freewheeling. */
+    if(buffered > 0 && mDevice->Connected.load(std::memory_order_acquire))
+        writeFrames(buffered);
+    mPendingFrames.store(0u, std::memory_order_release);
 
     return 0;
 }
 
+bool WaveBackend::writeFrames(const ALuint frames)
+{
+    const ALuint frameSize{mDevice->frameSizeFromFmt()};
+    const size_t bytes{size_t{frames} * frameSize};
+
+    if(!IS_LITTLE_ENDIAN)
+    {
+        const ALuint bytesize{mDevice->bytesFromFmt()};
+
+        if(bytesize == 2)
+        {
+            ALushort *samples = reinterpret_cast<ALushort*>(mBuffer.data());
+            const size_t len{bytes / 2};
+            for(size_t i{0};i < len;i++)
+            {
+                const ALushort samp{samples[i]};
+                samples[i] = static_cast<ALushort>((samp>>8) | (samp<<8));
+            }
+        }
+        else if(bytesize == 4)
+        {
+            ALuint *samples = reinterpret_cast<ALuint*>(mBuffer.data());
+            const size_t len{bytes / 4};
+            for(size_t i{0};i < len;i++)
+            {
+                const ALuint samp{samples[i]};
+                samples[i] = (samp>>24) | ((samp>>8)&0x0000ff00) |
+                             ((samp<<8)&0x00ff0000) | (samp<<24);
+            }
+        }
+    }
+
+    size_t fs{fwrite(mBuffer.data(), frameSize, frames, mFile)};
+    mDataSize += uint64_t{fs} * frameSize;
+    if(ferror(mFile))
+    {
+        ERR("Error writing to file\n");
+        aluHandleDisconnect(mDevice, "Failed to write playback samples");
+        return false;
+    }
+    return true;
+}
+
 void WaveBackend::open(const ALCchar *name)
 {
     const char *fname{GetConfigValue(nullptr, "wave", "file", "")};
@@ -224,6 +312,11 @@ void WaveBackend::open(const ALCchar *name)
         throw al::backend_exception{ALC_INVALID_VALUE, "Could not open file '%s': %s", fname,
             strerror(errno)};
 
+    const size_t fnamelen{strlen(fname)};
+    mWave64 = fnamelen >= 4 && al::strcasecmp(fname+fnamelen-4, ".w64") == 0;
+    mFreewheel = GetConfigValueBool(nullptr, "wave", "freewheel", 0) != 0;
+    if(mFreewheel) TRACE("Freewheel rendering to %s\n", fname);
+
     mDevice->DeviceName = name;
 }
 
@@ -233,7 +326,7 @@ bool WaveBackend::reset()
     int isbformat = 0;
     size_t val;
 
-    fseek(mFile, 0, SEEK_SET);
+    fseek64(mFile, 0, SEEK_SET);
     clearerr(mFile);
 
     if(GetConfigValueBool(nullptr, "wave", "bformat", 0))
@@ -282,13 +375,36 @@ bool WaveBackend::reset()
 
     rewind(mFile);
 
-    fputs("RIFF", mFile);
-    fwrite32le(0xFFFFFFFF, mFile); // 'RIFF' header len; filled in at close
+    if(mWave64)
+    {
+        /* Wave64 chunks have a 16-byte GUID and 64-bit length, which includes
+         * the chunk header.
+         */
+        fwrite(Wave64RiffGuid, 1, 16, mFile);
+        fwrite64le(~uint64_t{0}, mFile); // 'riff' chunk len; filled in at close
+        fwrite(Wave64WaveGuid, 1, 16, mFile);
+
+        fwrite(Wave64FmtGuid, 1, 16, mFile);
+        fwrite64le(24+40, mFile); // 'fmt ' chunk len; 40 bytes for EXTENSIBLE
+    }
+    else
+    {
+        fputs("RIFF", mFile);
+        fwrite32le(0xFFFFFFFF, mFile); // 'RIFF' header len; filled in at close
 
-    fputs("WAVE", mFile);
+        fputs("WAVE", mFile);
 
-    fputs("fmt ", mFile);
-    fwrite32le(40, mFile); // 'fmt ' header len; 40 bytes for EXTENSIBLE
+        /* Reserve space for a 'ds64' chunk, in case the file needs to become
+         * RF64 for being over 4GB.
+         */
+        fputs("JUNK", mFile);
+        fwrite32le(28, mFile);
+        for(size_t i{0};i < 28;++i)
+            fputc(0, mFile);
+
+        fputs("fmt ", mFile);
+        fwrite32le(40, mFile); // 'fmt ' header len; 40 bytes for EXTENSIBLE
+    }
 
     // 16-bit val, format type id (extensible: 0xFFFE)
     fwrite16le(0xFFFE, mFile);
@@ -314,20 +430,36 @@ bool WaveBackend::reset()
         (isbformat ? SUBTYPE_BFORMAT_PCM : SUBTYPE_PCM), 1, 16, mFile);
     (void)val;
 
-    fputs("data", mFile);
-    fwrite32le(0xFFFFFFFF, mFile); // 'data' header len; filled in at close
+    if(mWave64)
+    {
+        fwrite(Wave64DataGuid, 1, 16, mFile);
+        fwrite64le(~uint64_t{0}, mFile); // 'data' chunk len; filled in at close
+    }
+    else
+    {
+        fputs("data", mFile);
+        fwrite32le(0xFFFFFFFF, mFile); // 'data' header len; filled in at close
+    }
 
     if(ferror(mFile))
     {
         ERR("Error writing header: %s\n", strerror(errno));
         return false;
     }
-    mDataStart = ftell(mFile);
+    mDataStart = ftell64(mFile);
+    mDataSize = 0;
 
     setDefaultWFXChannelOrder();
 
-    const ALuint bufsize{mDevice->frameSizeFromFmt() * mDevice->UpdateSize};
-    mBuffer.resize(bufsize);
+    /* When freewheeling, mix multiple updates at a time to write out in large
+     * blocks.
+     */
+    const ALuint frameSize{mDevice->frameSizeFromFmt()};
+    size_t bufferFrames{mDevice->UpdateSize};
+    if(mFreewheel)
+        bufferFrames = maxz(bufferFrames,
+            FreewheelBufferBytes / frameSize / mDevice->UpdateSize * mDevice->UpdateSize);
+    mBuffer.resize(bufferFrames * frameSize);
 
     return true;
 }
@@ -350,15 +482,84 @@ void WaveBackend::stop()
         return;
     mThread.join();
 
-    long size{ftell(mFile)};
-    if(size > 0)
+    const uint64_t dataLen{mDataSize};
+    if(mWave64)
+    {
+        /* Wave64 chunks are padded to a multiple of 8 bytes. */
+        const auto pad = static_cast<long>((8 - (dataLen&7)) & 7);
+        for(long i{0};i < pad;++i)
+            fputc(0, mFile);
+
+        if(fseek64(mFile, mDataStart-8, SEEK_SET) == 0)
+            fwrite64le(24 + dataLen, mFile); // 'data' chunk len
+        if(fseek64(mFile, 16, SEEK_SET) == 0)
+            fwrite64le(static_cast<uint64_t>(mDataStart) + dataLen + pad, mFile); // 'riff' len
+        fseek64(mFile, -pad, SEEK_END);
+    }
+    else
     {
-        long dataLen{size - mDataStart};
-        if(fseek(mFile, mDataStart-4, SEEK_SET) == 0)
-            fwrite32le(static_cast<ALuint>(dataLen), mFile); // 'data' header len
-        if(fseek(mFile, 4, SEEK_SET) == 0)
-            fwrite32le(static_cast<ALuint>(size-8), mFile); // 'WAVE' header len
+        const auto pad = static_cast<long>(dataLen&1);
+        if(pad) fputc(0, mFile);
+
+        const uint64_t riffLen{static_cast<uint64_t>(mDataStart) - 8 + dataLen + pad};
+        if(riffLen > 0xFFFFFFFFu)
+        {
+            /* Too big for a normal RIFF file, so make it an RF64 file with the
+             * real sizes in the 'ds64' chunk that replaces the 'JUNK' chunk.
+             */
+            if(fseek64(mFile, 0, SEEK_SET) == 0)
+            {
+                fputs("RF64", mFile);
+                fwrite32le(0xFFFFFFFF, mFile);
+            }
+            if(fseek64(mFile, 12, SEEK_SET) == 0)
+            {
+                fputs("ds64", mFile);
+                fwrite32le(28, mFile);
+                fwrite64le(riffLen, mFile);
+                fwrite64le(dataLen, mFile);
+                fwrite64le(dataLen / mDevice->frameSizeFromFmt(), mFile); // sample count
+                fwrite32le(0, mFile); // table length
+            }
+            if(fseek64(mFile, mDataStart-4, SEEK_SET) == 0)
+                fwrite32le(0xFFFFFFFF, mFile);
+        }
+        else
+        {
+            if(fseek64(mFile, mDataStart-4, SEEK_SET) == 0)
+                fwrite32le(static_cast<ALuint>(dataLen), mFile); // 'data' header len
+            if(fseek64(mFile, 4, SEEK_SET) == 0)
+                fwrite32le(static_cast<ALuint>(riffLen), mFile); // 'WAVE' header len
+        }
+        fseek64(mFile, -pad, SEEK_END);
     }
+    /* Keep the file position at the end of the samples, so restarting
+     * continues from where it stopped (the header is updated again on the
+     * next stop).
+     */
+    fflush(mFile);
+}
+
+ClockLatency WaveBackend::getClockLatency()
+{
+    ClockLatency ret;
+
+    /* The device clock is the number of frames mixed, which is not tied to
+     * real time when freewheeling. The only latency is from mixed samples that
+     * haven't been written to the file yet.
+     */
+    ALuint refcount;
+    ALuint pending;
+    do {
+        refcount = mDevice->waitForMix();
+        ret.ClockTime = GetDeviceClockTime(mDevice);
+        pending = mPendingFrames.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while(refcount != ReadRef(mDevice->MixCount));
+    ret.Latency = std::chrono::seconds{pending};
+    ret.Latency /= mDevice->Frequency;
+
+    return ret;
 }
 
 } // namespace
@@ -30,6 +30,7 @@
 #include "alcontext.h"
 #include "alu.h"
 #include "filters/biquad.h"
+#include "oscillator.h"
 #include "vecmat.h"
 
 namespace {
@@ -135,7 +136,7 @@ void AutowahState::process(const size_t samplesToDo, const al::span<const FloatB
     float env_delay{mEnvDelay};
     for(size_t i{0u};i < samplesToDo;i++)
     {
-        float w0, sample, a;
+        float f0norm, sample, a;
 
         /* Envelope follower described on the book: Audio Effects, Theory,
          * Implementation and Application.
@@ -144,10 +145,14 @@ void AutowahState::process(const size_t samplesToDo, const al::span<const FloatB
         a = (sample > env_delay) ? attack_rate : release_rate;
         env_delay = lerp(sample, env_delay, a);
 
-        /* Calculate the cos and alpha components for this sample's filter. */
-        w0 = minf((bandwidth*env_delay + freq_min), 0.46f) * al::MathDefs<float>::Tau();
-        mEnv[i].cos_w0 = std::cos(w0);
-        mEnv[i].alpha = std::sin(w0)/(2.0f * Q_FACTOR);
+        /* Calculate the cos and alpha components for this sample's filter.
+         * The filter frequency is normalized, so it's already the phase (in
+         * cycles) of w0.
+         */
+        f0norm = minf((bandwidth*env_delay + freq_min), 0.46f);
+        float sin_w0;
+        SinCosCycle(f0norm, sin_w0, mEnv[i].cos_w0);
+        mEnv[i].alpha = sin_w0/(2.0f * Q_FACTOR);
     }
     mEnvDelay = env_delay;
 
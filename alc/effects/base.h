@@ -177,6 +177,10 @@ struct EffectStateFactory {
     virtual EffectState *create() = 0;
     virtual EffectProps getDefaultProps() const noexcept = 0;
     virtual const EffectVtable *getEffectVtable() const noexcept = 0;
+    /* The ambisonic order of the input the effect processes. Sources only mix
+     * this many wet channels into the slot, up to the device's order.
+     */
+    virtual ALuint getInputOrder() const noexcept { return MAX_AMBI_ORDER; }
 };
 
 
@@ -41,6 +41,7 @@
 #include "effects/base.h"
 #include "math_defs.h"
 #include "opthelpers.h"
+#include "oscillator.h"
 #include "vector.h"
 
 
@@ -161,7 +162,7 @@ void ChorusState::update(const ALCcontext *Context, const ALeffectslot *Slot, co
             mLfoScale = 4.0f / static_cast<float>(mLfoRange);
             break;
         case WaveForm::Sinusoid:
-            mLfoScale = al::MathDefs<float>::Tau() / static_cast<float>(mLfoRange);
+            mLfoScale = 1.0f / static_cast<float>(mLfoRange);
             break;
         }
 
@@ -213,7 +214,7 @@ void ChorusState::getSinusoidDelays(ALuint (*delays)[MAX_UPDATE_SAMPLES], const
     {
         offset = (offset+1)%lfo_range;
         const float offset_norm{static_cast<float>(offset) * lfo_scale};
-        return static_cast<ALuint>(fastf2i(std::sin(offset_norm)*depth) + delay);
+        return static_cast<ALuint>(fastf2i(SinCycle(offset_norm)*depth) + delay);
     };
     std::generate_n(delays[0], todo, gen_lfo);
 
@@ -384,6 +385,7 @@ struct ChorusStateFactory final : public EffectStateFactory {
     EffectState *create() override { return new ChorusState{}; }
     EffectProps getDefaultProps() const noexcept override;
     const EffectVtable *getEffectVtable() const noexcept override { return &Chorus_vtable; }
+    ALuint getInputOrder() const noexcept override { return 0; }
 };
 
 EffectProps ChorusStateFactory::getDefaultProps() const noexcept
@@ -511,6 +513,7 @@ struct FlangerStateFactory final : public EffectStateFactory {
     EffectState *create() override { return new ChorusState{}; }
     EffectProps getDefaultProps() const noexcept override;
     const EffectVtable *getEffectVtable() const noexcept override { return &Flanger_vtable; }
+    ALuint getInputOrder() const noexcept override { return 0; }
 };
 
 EffectProps FlangerStateFactory::getDefaultProps() const noexcept
@@ -146,6 +146,7 @@ struct DedicatedStateFactory final : public EffectStateFactory {
     EffectState *create() override { return new DedicatedState{}; }
     EffectProps getDefaultProps() const noexcept override;
     const EffectVtable *getEffectVtable() const noexcept override { return &Dedicated_vtable; }
+    ALuint getInputOrder() const noexcept override { return 0; }
 };
 
 EffectProps DedicatedStateFactory::getDefaultProps() const noexcept
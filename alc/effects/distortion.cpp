@@ -244,6 +244,7 @@ struct DistortionStateFactory final : public EffectStateFactory {
     EffectState *create() override { return new DistortionState{}; }
     EffectProps getDefaultProps() const noexcept override;
     const EffectVtable *getEffectVtable() const noexcept override { return &Distortion_vtable; }
+    ALuint getInputOrder() const noexcept override { return 0; }
 };
 
 EffectProps DistortionStateFactory::getDefaultProps() const noexcept
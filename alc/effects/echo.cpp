@@ -238,6 +238,7 @@ struct EchoStateFactory final : public EffectStateFactory {
     EffectState *create() override { return new EchoState{}; }
     EffectProps getDefaultProps() const noexcept override;
     const EffectVtable *getEffectVtable() const noexcept override { return &Echo_vtable; }
+    ALuint getInputOrder() const noexcept override { return 0; }
 };
 
 EffectProps EchoStateFactory::getDefaultProps() const noexcept
@@ -24,6 +24,7 @@
 #include <cstdlib>
 
 #include <algorithm>
+#include <array>
 #include <functional>
 
 #include "al/auxeffectslot.h"
@@ -88,7 +89,8 @@ struct EqualizerState final : public EffectState {
         float TargetGains[MAX_OUTPUT_CHANNELS]{};
     } mChans[MAX_AMBI_CHANNELS];
 
-    FloatBufferLine mSampleBuffer{};
+    /* Filtered samples for a group of input channels. */
+    std::array<FloatBufferLine,BiquadBank<4>::sLanes> mSampleBuffer{};
 
 
     void deviceUpdate(const ALCdevice *device) override;
@@ -154,16 +156,34 @@ void EqualizerState::update(const ALCcontext *context, const ALeffectslot *slot,
 
 void EqualizerState::process(const size_t samplesToDo, const al::span<const FloatBufferLine> samplesIn, const al::span<FloatBufferLine> samplesOut)
 {
-    const al::span<float> buffer{mSampleBuffer.data(), samplesToDo};
-    auto chan = std::addressof(mChans[0]);
-    for(const auto &input : samplesIn)
-    {
-        const al::span<const float> inbuf{input.data(), samplesToDo};
-        DualBiquad{chan->filter[0], chan->filter[1]}.process(inbuf, buffer.begin());
-        DualBiquad{chan->filter[2], chan->filter[3]}.process(buffer, buffer.begin());
+    using FilterBank = BiquadBank<4>;
+    constexpr size_t NumLanes{FilterBank::sLanes};
 
-        MixSamples(buffer, samplesOut, chan->CurrentGains, chan->TargetGains, samplesToDo, 0u);
-        ++chan;
+    /* Run each group of input channels through their 4-band cascades
+     * together, then mix them out.
+     */
+    for(size_t base{0u};base < samplesIn.size();base += NumLanes)
+    {
+        const size_t numchans{minz(samplesIn.size()-base, NumLanes)};
+
+        FilterBank::FilterLine filters[NumLanes];
+        const float *src[NumLanes];
+        float *dst[NumLanes];
+        for(size_t i{0u};i < numchans;++i)
+        {
+            auto &chan = mChans[base+i];
+            filters[i] = {&chan.filter[0], &chan.filter[1], &chan.filter[2], &chan.filter[3]};
+            src[i] = samplesIn[base+i].data();
+            dst[i] = mSampleBuffer[i].data();
+        }
+        FilterBank{{filters, numchans}}.process(src, dst, samplesToDo);
+
+        for(size_t i{0u};i < numchans;++i)
+        {
+            auto &chan = mChans[base+i];
+            MixSamples({mSampleBuffer[i].data(), samplesToDo}, samplesOut, chan.CurrentGains,
+                chan.TargetGains, samplesToDo, 0u);
+        }
     }
 }
 
@@ -28,8 +28,13 @@
 
 #include "al/auxeffectslot.h"
 #include "alcmain.h"
+#include "alconfig.h"
 #include "alcontext.h"
+#include "alstring.h"
 #include "alu.h"
+#include "filters/phasesplit.h"
+#include "logging.h"
+#include "oscillator.h"
 
 #include "alcomplex.h"
 
@@ -60,6 +65,11 @@ alignas(16) const std::array<double,HIL_SIZE> HannWindow = InitHannWindow();
 
 
 struct FshifterState final : public EffectState {
+    /* Use the IIR phase splitter instead of the STFT Hilbert transform, for
+     * lower latency and CPU use at the cost of quality.
+     */
+    bool mLowLatency{false};
+
     /* Effect parameters */
     size_t mCount{};
     ALuint mPhaseStep[2]{};
@@ -73,6 +83,11 @@ struct FshifterState final : public EffectState {
     complex_d mAnalytic[HIL_SIZE]{};
     complex_d mOutdata[BUFFERSIZE]{};
 
+    /* Low-latency mode's analytic signal. */
+    PhaseSplitter mSplitter;
+    alignas(16) float mInPhase[BUFFERSIZE]{};
+    alignas(16) float mQuadrature[BUFFERSIZE]{};
+
     alignas(16) float mBufferOut[BUFFERSIZE]{};
 
     /* Effect gains for each output channel */
@@ -85,12 +100,23 @@ struct FshifterState final : public EffectState {
     void deviceUpdate(const ALCdevice *device) override;
     void update(const ALCcontext *context, const ALeffectslot *slot, const EffectProps *props, const EffectTarget target) override;
     void process(const size_t samplesToDo, const al::span<const FloatBufferLine> samplesIn, const al::span<FloatBufferLine> samplesOut) override;
+    void processLowLatency(const size_t samplesToDo, const al::span<const FloatBufferLine> samplesIn, const al::span<FloatBufferLine> samplesOut);
 
     DEF_NEWDEL(FshifterState)
 };
 
-void FshifterState::deviceUpdate(const ALCdevice*)
+void FshifterState::deviceUpdate(const ALCdevice *device)
 {
+    mLowLatency = false;
+    if(auto modeopt = ConfigValueStr(device->DeviceName.c_str(), "fshifter", "mode"))
+    {
+        const char *mode{modeopt->c_str()};
+        if(al::strcasecmp(mode, "iir") == 0)
+            mLowLatency = true;
+        else if(al::strcasecmp(mode, "stft") != 0)
+            ERR("Unexpected fshifter mode: %s\n", mode);
+    }
+
     /* (Re-)initializing parameters and clear the buffers. */
     mCount = FIFO_LATENCY;
 
@@ -101,6 +127,7 @@ void FshifterState::deviceUpdate(const ALCdevice*)
     std::fill(std::begin(mOutFIFO),     std::end(mOutFIFO),     complex_d{});
     std::fill(std::begin(mOutputAccum), std::end(mOutputAccum), complex_d{});
     std::fill(std::begin(mAnalytic),    std::end(mAnalytic),    complex_d{});
+    mSplitter.clear();
 
     for(auto &gain : mGains)
     {
@@ -158,6 +185,12 @@ void FshifterState::update(const ALCcontext *context, const ALeffectslot *slot,
 
 void FshifterState::process(const size_t samplesToDo, const al::span<const FloatBufferLine> samplesIn, const al::span<FloatBufferLine> samplesOut)
 {
+    if(mLowLatency)
+    {
+        processLowLatency(samplesToDo, samplesIn, samplesOut);
+        return;
+    }
+
     for(size_t base{0u};base < samplesToDo;)
     {
         size_t todo{minz(HIL_SIZE-mCount, samplesToDo-base)};
@@ -217,6 +250,36 @@ void FshifterState::process(const size_t samplesToDo, const al::span<const Float
     }
 }
 
+void FshifterState::processLowLatency(const size_t samplesToDo, const al::span<const FloatBufferLine> samplesIn, const al::span<FloatBufferLine> samplesOut)
+{
+    /* Get the in-phase and quadrature signals from the phase splitter. Since
+     * the quadrature signal leads by 90 degrees, cos(wt) comes out as -sin(wt)
+     * and i*cos(p) + q*sin(p) gives cos(wt+p), shifting the frequency up.
+     */
+    mSplitter.process({samplesIn[0].data(), samplesToDo}, mInPhase, mQuadrature);
+
+    float *RESTRICT BufferOut{mBufferOut};
+    for(ALsizei c{0};c < 2;++c)
+    {
+        const ALuint phase_step{mPhaseStep[c]};
+        const float sign{static_cast<float>(mSign[c])};
+        ALuint phase_idx{mPhase[c]};
+        for(size_t k{0};k < samplesToDo;++k)
+        {
+            float sinval, cosval;
+            SinCosCycle(static_cast<float>(phase_idx) * (1.0f/FRACTIONONE), sinval, cosval);
+            BufferOut[k] = mInPhase[k]*cosval + mQuadrature[k]*sinval*sign;
+
+            phase_idx += phase_step;
+            phase_idx &= FRACTIONMASK;
+        }
+        mPhase[c] = phase_idx;
+
+        MixSamples({BufferOut, samplesToDo}, samplesOut, mGains[c].Current, mGains[c].Target,
+            maxz(samplesToDo, 512), 0);
+    }
+}
+
 
 void Fshifter_setParamf(EffectProps *props, ALenum param, float val)
 {
@@ -303,6 +366,7 @@ struct FshifterStateFactory final : public EffectStateFactory {
     EffectState *create() override { return new FshifterState{}; }
     EffectProps getDefaultProps() const noexcept override;
     const EffectVtable *getEffectVtable() const noexcept override { return &Fshifter_vtable; }
+    ALuint getInputOrder() const noexcept override { return 0; }
 };
 
 EffectProps FshifterStateFactory::getDefaultProps() const noexcept
@@ -31,6 +31,7 @@
 #include "alcontext.h"
 #include "alu.h"
 #include "filters/biquad.h"
+#include "oscillator.h"
 #include "vecmat.h"
 
 
@@ -38,35 +39,8 @@ namespace {
 
 #define MAX_UPDATE_SAMPLES 128
 
-#define WAVEFORM_FRACBITS  24
-#define WAVEFORM_FRACONE   (1<<WAVEFORM_FRACBITS)
-#define WAVEFORM_FRACMASK  (WAVEFORM_FRACONE-1)
-
-inline float Sin(ALuint index)
-{
-    constexpr float scale{al::MathDefs<float>::Tau() / WAVEFORM_FRACONE};
-    return std::sin(static_cast<float>(index) * scale);
-}
-
-inline float Saw(ALuint index)
-{ return static_cast<float>(index)*(2.0f/WAVEFORM_FRACONE) - 1.0f; }
-
-inline float Square(ALuint index)
-{ return static_cast<float>(static_cast<int>((index>>(WAVEFORM_FRACBITS-2))&2) - 1); }
-
 inline float One(ALuint) { return 1.0f; }
 
-template<float (&func)(ALuint)>
-void Modulate(float *RESTRICT dst, ALuint index, const ALuint step, size_t todo)
-{
-    for(size_t i{0u};i < todo;i++)
-    {
-        index += step;
-        index &= WAVEFORM_FRACMASK;
-        dst[i] = func(index);
-    }
-}
-
 
 struct ModulatorState final : public EffectState {
     void (*mGetSamples)(float*RESTRICT, ALuint, const ALuint, size_t){};
@@ -106,13 +80,13 @@ void ModulatorState::update(const ALCcontext *context, const ALeffectslot *slot,
     mStep = fastf2u(clampf(step*WAVEFORM_FRACONE, 0.0f, float{WAVEFORM_FRACONE-1}));
 
     if(mStep == 0)
-        mGetSamples = Modulate<One>;
+        mGetSamples = GenerateWave<One>;
     else if(props->Modulator.Waveform == AL_RING_MODULATOR_SINUSOID)
-        mGetSamples = Modulate<Sin>;
+        mGetSamples = GenerateWave<WaveSin>;
     else if(props->Modulator.Waveform == AL_RING_MODULATOR_SAWTOOTH)
-        mGetSamples = Modulate<Saw>;
+        mGetSamples = GenerateWave<WaveSaw>;
     else /*if(props->Modulator.Waveform == AL_RING_MODULATOR_SQUARE)*/
-        mGetSamples = Modulate<Square>;
+        mGetSamples = GenerateWave<WaveSquare>;
 
     float f0norm{props->Modulator.HighPassCutoff / static_cast<float>(device->Frequency)};
     f0norm = clampf(f0norm, 1.0f/512.0f, 0.49f);
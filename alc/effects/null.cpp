@@ -140,6 +140,7 @@ struct NullStateFactory final : public EffectStateFactory {
     EffectState *create() override;
     EffectProps getDefaultProps() const noexcept override;
     const EffectVtable *getEffectVtable() const noexcept override;
+    ALuint getInputOrder() const noexcept override { return 0; }
 };
 
 /* Creates EffectState objects of the appropriate type. */
@@ -33,9 +33,13 @@
 #include "al/auxeffectslot.h"
 #include "alcmain.h"
 #include "alcomplex.h"
+#include "alconfig.h"
 #include "alcontext.h"
 #include "alnumeric.h"
+#include "alstring.h"
 #include "alu.h"
+#include "logging.h"
+#include "oscillator.h"
 
 
 namespace {
@@ -49,6 +53,14 @@ using complex_d = std::complex<double>;
 #define STFT_STEP    (STFT_SIZE / OVERSAMP)
 #define FIFO_LATENCY (STFT_STEP * (OVERSAMP-1))
 
+/* The granular (low-latency) mode reads two crossfading grains from a delay
+ * line, each sweeping through GRAIN_TIME seconds of delay. The average delay
+ * is half the grain length.
+ */
+#define GRAIN_TIME       0.01f
+#define GRAIN_LINE_SIZE  4096
+#define GRAIN_LINE_MASK  (GRAIN_LINE_SIZE-1)
+
 /* Define a Hann window, used to filter the STFT input and output. */
 std::array<double,STFT_SIZE> InitHannWindow()
 {
@@ -72,6 +84,11 @@ struct FrequencyBin {
 
 
 struct PshifterState final : public EffectState {
+    /* Use time-domain granular pitch shifting instead of the STFT phase
+     * vocoder, for lower latency and CPU use at the cost of quality.
+     */
+    bool mLowLatency;
+
     /* Effect parameters */
     size_t mCount;
     ALuint mPitchShiftI;
@@ -89,6 +106,14 @@ struct PshifterState final : public EffectState {
     std::array<FrequencyBin,STFT_HALF_SIZE+1> mAnalysisBuffer;
     std::array<FrequencyBin,STFT_HALF_SIZE+1> mSynthesisBuffer;
 
+    /* Granular mode's delay line, and the phase of the first grain's delay
+     * (as a fraction of the grain length).
+     */
+    std::array<float,GRAIN_LINE_SIZE> mGrainLine;
+    size_t mGrainPos;
+    float mGrainLength;
+    float mGrainPhase;
+
     alignas(16) FloatBufferLine mBufferOut;
 
     /* Effect gains for each output channel */
@@ -99,12 +124,23 @@ struct PshifterState final : public EffectState {
     void deviceUpdate(const ALCdevice *device) override;
     void update(const ALCcontext *context, const ALeffectslot *slot, const EffectProps *props, const EffectTarget target) override;
     void process(const size_t samplesToDo, const al::span<const FloatBufferLine> samplesIn, const al::span<FloatBufferLine> samplesOut) override;
+    void processGranular(const size_t samplesToDo, const al::span<const FloatBufferLine> samplesIn, const al::span<FloatBufferLine> samplesOut);
 
     DEF_NEWDEL(PshifterState)
 };
 
 void PshifterState::deviceUpdate(const ALCdevice *device)
 {
+    mLowLatency = false;
+    if(auto modeopt = ConfigValueStr(device->DeviceName.c_str(), "pshifter", "mode"))
+    {
+        const char *mode{modeopt->c_str()};
+        if(al::strcasecmp(mode, "granular") == 0)
+            mLowLatency = true;
+        else if(al::strcasecmp(mode, "stft") != 0)
+            ERR("Unexpected pshifter mode: %s\n", mode);
+    }
+
     /* (Re-)initializing parameters and clear the buffers. */
     mCount       = FIFO_LATENCY;
     mPitchShiftI = FRACTIONONE;
@@ -119,6 +155,12 @@ void PshifterState::deviceUpdate(const ALCdevice *device)
     std::fill(mAnalysisBuffer.begin(),  mAnalysisBuffer.end(),  FrequencyBin{});
     std::fill(mSynthesisBuffer.begin(), mSynthesisBuffer.end(), FrequencyBin{});
 
+    std::fill(mGrainLine.begin(), mGrainLine.end(), 0.0f);
+    mGrainPos    = 0;
+    mGrainLength = minf(std::round(GRAIN_TIME*static_cast<float>(device->Frequency)),
+        float{GRAIN_LINE_SIZE - 4});
+    mGrainPhase  = 0.0f;
+
     std::fill(std::begin(mCurrentGains), std::end(mCurrentGains), 0.0f);
     std::fill(std::begin(mTargetGains),  std::end(mTargetGains),  0.0f);
 }
@@ -138,6 +180,12 @@ void PshifterState::update(const ALCcontext*, const ALeffectslot *slot, const Ef
 
 void PshifterState::process(const size_t samplesToDo, const al::span<const FloatBufferLine> samplesIn, const al::span<FloatBufferLine> samplesOut)
 {
+    if(mLowLatency)
+    {
+        processGranular(samplesToDo, samplesIn, samplesOut);
+        return;
+    }
+
     /* Pitch shifter engine based on the work of Stephan Bernsee.
      * http://blogs.zynaptiq.com/bernsee/pitch-shifting-using-the-ft/
      */
@@ -249,6 +297,51 @@ void PshifterState::process(const size_t samplesToDo, const al::span<const Float
         maxz(samplesToDo, 512), 0);
 }
 
+void PshifterState::processGranular(const size_t samplesToDo, const al::span<const FloatBufferLine> samplesIn, const al::span<FloatBufferLine> samplesOut)
+{
+    /* Each grain reads the delay line at the pitch rate, so its delay changes
+     * by 1-pitch every sample, wrapping around the grain length. The two
+     * grains are half a grain length apart, and each is windowed by
+     * sin^2(pi*phase) so they sum to unity, with a grain silent when its delay
+     * wraps.
+     */
+    const float length{mGrainLength};
+    const float phase_step{(1.0f - static_cast<float>(mPitchShift)) / length};
+    const float *RESTRICT input{samplesIn[0].data()};
+    float *RESTRICT output{mBufferOut.data()};
+
+    auto read_grain = [this,length](const size_t pos, const float phase) -> float
+    {
+        const float delay{phase * length};
+        const ALuint idelay{float2uint(delay)};
+        const float frac{delay - static_cast<float>(idelay)};
+        const float s0{mGrainLine[(pos-idelay) & GRAIN_LINE_MASK]};
+        const float s1{mGrainLine[(pos-idelay-1) & GRAIN_LINE_MASK]};
+        const float window{SinCycle(phase*0.5f)};
+        return lerp(s0, s1, frac) * (window*window);
+    };
+
+    size_t pos{mGrainPos};
+    float phase{mGrainPhase};
+    for(size_t i{0};i < samplesToDo;++i)
+    {
+        mGrainLine[pos] = input[i];
+
+        const float phase2{(phase < 0.5f) ? phase+0.5f : phase-0.5f};
+        output[i] = read_grain(pos, phase) + read_grain(pos, phase2);
+
+        phase += phase_step;
+        if(phase >= 1.0f) phase -= 1.0f;
+        else if(phase < 0.0f) phase += 1.0f;
+        pos = (pos+1) & GRAIN_LINE_MASK;
+    }
+    mGrainPos = pos;
+    mGrainPhase = phase;
+
+    MixSamples({mBufferOut.data(), samplesToDo}, samplesOut, mCurrentGains, mTargetGains,
+        maxz(samplesToDo, 512), 0);
+}
+
 
 void Pshifter_setParamf(EffectProps*, ALenum param, float)
 { throw effect_exception{AL_INVALID_ENUM, "Invalid pitch shifter float property 0x%04x", param}; }
@@ -316,6 +409,7 @@ struct PshifterStateFactory final : public EffectStateFactory {
     EffectState *create() override;
     EffectProps getDefaultProps() const noexcept override;
     const EffectVtable *getEffectVtable() const noexcept override { return &Pshifter_vtable; }
+    ALuint getInputOrder() const noexcept override { return 0; }
 };
 
 EffectState *PshifterStateFactory::create()
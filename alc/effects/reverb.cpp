@@ -32,10 +32,13 @@
 #include "al/auxeffectslot.h"
 #include "al/listener.h"
 #include "alcmain.h"
+#include "alconfig.h"
 #include "alcontext.h"
+#include "alstring.h"
 #include "alu.h"
 #include "bformatdec.h"
 #include "filters/biquad.h"
+#include "logging.h"
 #include "vector.h"
 #include "vecmat.h"
 
@@ -229,6 +232,14 @@ constexpr std::array<float,NUM_LINES> LATE_LINE_LENGTHS{{
 
 using ReverbUpdateLine = std::array<float,MAX_UPDATE_SAMPLES>;
 
+/* The delay network can optionally run at a reduced rate (a divisor of the
+ * device rate) for cheaper, lower fidelity reverb. The reduced-rate output
+ * lines hold a full update's worth of samples at half rate, plus two history
+ * samples used to interpolate back to the device rate.
+ */
+constexpr ALuint MAX_RATE_DIVISOR{4u};
+using ReverbReducedLine = std::array<float,BUFFERSIZE/2 + 2>;
+
 struct DelayLineI {
     /* The delay lines use interleaved samples, with the lengths being powers
      * of 2 to allow the use of bit-masking instead of a modulus for wrapping.
@@ -298,10 +309,6 @@ struct T60Filter {
 
     void calcCoeffs(const float length, const float lfDecayTime, const float mfDecayTime,
         const float hfDecayTime, const float lf0norm, const float hf0norm);
-
-    /* Applies the two T60 damping filter sections. */
-    void process(const al::span<float> samples)
-    { DualBiquad{HFFilter, LFFilter}.process(samples, samples.data()); }
 };
 
 struct EarlyReflections {
@@ -368,6 +375,19 @@ struct LateReverb {
     void updateLines(const float density_mult, const float diffusion, const float lfDecayTime,
         const float mfDecayTime, const float hfDecayTime, const float lf0norm,
         const float hf0norm, const float frequency);
+
+    /* Applies the two T60 damping filter sections to all lines at once. */
+    void processT60(const al::span<ReverbUpdateLine,NUM_LINES> samples, const size_t todo)
+    {
+        BiquadBank<2>::FilterLine filters[NUM_LINES];
+        float *lines[NUM_LINES];
+        for(size_t j{0u};j < NUM_LINES;j++)
+        {
+            filters[j] = {&T60[j].HFFilter, &T60[j].LFFilter};
+            lines[j] = samples[j].data();
+        }
+        BiquadBank<2>{{filters, NUM_LINES}}.process(lines, lines, todo);
+    }
 };
 
 struct ReverbState final : public EffectState {
@@ -418,6 +438,25 @@ struct ReverbState final : public EffectState {
 
     bool mDoFading{};
 
+    /* The device rate divisor the delay network runs with, and the offset of
+     * the next device-rate sample to decimate.
+     */
+    ALuint mRateDiv{1u};
+    size_t mRatePhase{0u};
+
+    /* Anti-aliasing filters applied before decimating the input, and anti-
+     * imaging filters applied after interpolating the early and late output,
+     * when running at a reduced rate.
+     */
+    struct {
+        BiquadFilter Lp0;
+        BiquadFilter Lp1;
+    } mDecimFilter[NUM_LINES];
+    BiquadFilter mInterpFilter[2][NUM_LINES];
+
+    /* Early and late output accumulated at the reduced rate. */
+    al::vector<std::array<ReverbReducedLine,NUM_LINES>,16> mReducedSamples;
+
     /* Maximum number of samples to process at once. */
     size_t mMaxUpdate[2]{MAX_UPDATE_SAMPLES, MAX_UPDATE_SAMPLES};
 
@@ -513,6 +552,24 @@ struct ReverbState final : public EffectState {
         }
     }
 
+    /* Stores the early reflections and late reverb generated at a reduced
+     * rate, to be interpolated and mixed once the full update is done.
+     */
+    void StoreReduced(const al::span<FloatBufferLine>, const size_t, const size_t offset,
+        const size_t todo)
+    {
+        ASSUME(todo > 0);
+
+        for(size_t c{0u};c < NUM_LINES;c++)
+        {
+            std::copy_n(mEarlySamples[c].cbegin(), todo, mReducedSamples[0][c].begin()+2+offset);
+            std::copy_n(mLateSamples[c].cbegin(), todo, mReducedSamples[1][c].begin()+2+offset);
+        }
+    }
+
+    size_t decimateLines(const size_t todo);
+    void interpolateLines(const size_t first, const size_t offset, const size_t todo);
+
     void allocLines(const float frequency);
 
     void updateDelayLine(const float earlyDelay, const float lateDelay, const float density_mult,
@@ -560,12 +617,12 @@ void ReverbState::allocLines(const float frequency)
     /* The main delay length includes the maximum early reflection delay, the
      * largest early tap width, the maximum late reverb delay, and the
      * largest late tap width.  Finally, it must also be extended by the
-     * update size (BUFFERSIZE) for block processing.
+     * update size (BUFFERSIZE, at the network's rate) for block processing.
      */
     float length{AL_EAXREVERB_MAX_REFLECTIONS_DELAY + EARLY_TAP_LENGTHS.back()*multiplier +
         AL_EAXREVERB_MAX_LATE_REVERB_DELAY +
         (LATE_LINE_LENGTHS.back() - LATE_LINE_LENGTHS.front())/float{NUM_LINES}*multiplier};
-    totalSamples += mDelay.calcLineLength(length, totalSamples, frequency, BUFFERSIZE);
+    totalSamples += mDelay.calcLineLength(length, totalSamples, frequency, BUFFERSIZE/mRateDiv);
 
     /* The early vector all-pass line. */
     length = EARLY_ALLPASS_LENGTHS.back() * multiplier;
@@ -608,11 +665,48 @@ void ReverbState::allocLines(const float frequency)
 
 void ReverbState::deviceUpdate(const ALCdevice *device)
 {
-    const auto frequency = static_cast<float>(device->Frequency);
+    mRateDiv = 1;
+    if(auto qualopt = ConfigValueStr(device->DeviceName.c_str(), "reverb", "quality"))
+    {
+        const char *qual{qualopt->c_str()};
+        if(al::strcasecmp(qual, "medium") == 0)
+            mRateDiv = 2;
+        else if(al::strcasecmp(qual, "low") == 0)
+            mRateDiv = MAX_RATE_DIVISOR;
+        else if(al::strcasecmp(qual, "high") != 0)
+            ERR("Unexpected reverb quality: %s\n", qual);
+    }
+
+    /* The delay network's rate, which may be reduced from the device rate. */
+    const float frequency{static_cast<float>(device->Frequency) / static_cast<float>(mRateDiv)};
 
     /* Allocate the delay lines. */
     allocLines(frequency);
 
+    /* Set up the decimation and interpolation filters, which cut off a bit
+     * below the reduced rate's nyquist frequency.
+     */
+    mRatePhase = 0;
+    if(mRateDiv > 1)
+    {
+        const float f0norm{0.4f / static_cast<float>(mRateDiv)};
+        mDecimFilter[0].Lp0.setParamsFromSlope(BiquadType::LowPass, f0norm, 1.0f, 1.0f);
+        mDecimFilter[0].Lp0.clear();
+        mDecimFilter[0].Lp1.copyParamsFrom(mDecimFilter[0].Lp0);
+        mDecimFilter[0].Lp1.clear();
+        std::fill(std::begin(mDecimFilter)+1, std::end(mDecimFilter), mDecimFilter[0]);
+        std::fill(std::begin(mInterpFilter[0]), std::end(mInterpFilter[0]),
+            mDecimFilter[0].Lp0);
+        std::fill(std::begin(mInterpFilter[1]), std::end(mInterpFilter[1]),
+            mDecimFilter[0].Lp0);
+
+        mReducedSamples.resize(2);
+        for(auto &lines : mReducedSamples)
+            std::fill(lines.begin(), lines.end(), ReverbReducedLine{});
+    }
+    else
+        decltype(mReducedSamples){}.swap(mReducedSamples);
+
     const float multiplier{CalcDelayLengthMult(AL_EAXREVERB_MAX_DENSITY)};
 
     /* The late feed taps are set a fixed position past the latest delay tap. */
@@ -671,7 +765,7 @@ void ReverbState::deviceUpdate(const ALCdevice *device)
         mMixOut = &ReverbState::MixOutPlain;
         mOrderScales.fill(1.0f);
     }
-    mAmbiSplitter[0][0].init(400.0f / frequency);
+    mAmbiSplitter[0][0].init(400.0f / static_cast<float>(device->Frequency));
     std::fill(mAmbiSplitter[0].begin()+1, mAmbiSplitter[0].end(), mAmbiSplitter[0][0]);
     std::fill(mAmbiSplitter[1].begin(), mAmbiSplitter[1].end(), mAmbiSplitter[0][0]);
 }
@@ -1000,15 +1094,23 @@ void ReverbState::update(const ALCcontext *Context, const ALeffectslot *Slot, co
         mFilter[i].Hp.copyParamsFrom(mFilter[0].Hp);
     }
 
+    /* The delay network may run at a reduced rate, so everything past the
+     * master filters needs its own reference frequencies.
+     */
+    const float netFrequency{frequency / static_cast<float>(mRateDiv)};
+    hf0norm = minf(props->Reverb.HFReference/netFrequency, 0.49f);
+    lf0norm = minf(props->Reverb.LFReference/netFrequency, 0.49f);
+
     /* The density-based room size (delay length) multiplier. */
     const float density_mult{CalcDelayLengthMult(props->Reverb.Density)};
 
     /* Update the main effect delay and associated taps. */
     updateDelayLine(props->Reverb.ReflectionsDelay, props->Reverb.LateReverbDelay,
-        density_mult, props->Reverb.DecayTime, frequency);
+        density_mult, props->Reverb.DecayTime, netFrequency);
 
     /* Update the early lines. */
-    mEarly.updateLines(density_mult, props->Reverb.Diffusion, props->Reverb.DecayTime, frequency);
+    mEarly.updateLines(density_mult, props->Reverb.Diffusion, props->Reverb.DecayTime,
+        netFrequency);
 
     /* Get the mixing matrix coefficients. */
     CalcMatrixCoeffs(props->Reverb.Diffusion, &mMixX, &mMixY);
@@ -1029,11 +1131,11 @@ void ReverbState::update(const ALCcontext *Context, const ALeffectslot *Slot, co
 
     /* Update the modulator rate and depth. */
     mLate.Mod.updateModulator(props->Reverb.ModulationTime, props->Reverb.ModulationDepth,
-        frequency);
+        netFrequency);
 
     /* Update the late lines. */
     mLate.updateLines(density_mult, props->Reverb.Diffusion, lfDecayTime,
-        props->Reverb.DecayTime, hfDecayTime, lf0norm, hf0norm, frequency);
+        props->Reverb.DecayTime, hfDecayTime, lf0norm, hf0norm, netFrequency);
 
     /* Update early and late 3D panning. */
     const float gain{props->Reverb.Gain * Slot->Params.Gain * ReverbBoost};
@@ -1501,8 +1603,8 @@ void ReverbState::lateUnfaded(const size_t offset, const size_t todo)
                 ++i;
             } while(--td);
         }
-        mLate.T60[j].process({mTempSamples[j].data(), todo});
     }
+    mLate.processT60(mTempSamples, todo);
 
     /* Apply a vector all-pass to improve micro-surface diffusion, and write
      * out the results for mixing.
@@ -1572,8 +1674,8 @@ void ReverbState::lateFaded(const size_t offset, const size_t todo, const float
                 ++i;
             } while(--td);
         }
-        mLate.T60[j].process({mTempSamples[j].data(), todo});
     }
+    mLate.processT60(mTempSamples, todo);
 
     mLate.VecAp.processFaded(mTempSamples, offset, mixX, mixY, fade, fadeStep, todo);
     for(size_t j{0u};j < NUM_LINES;j++)
@@ -1582,46 +1684,151 @@ void ReverbState::lateFaded(const size_t offset, const size_t todo, const float
     VectorScatterRevDelayIn(late_delay, offset, mixX, mixY, mTempSamples, todo);
 }
 
+/* Low-pass filters and decimates the A-Format lines in mTempSamples in-place
+ * for the reduced-rate delay network, leaving the results at the start of each
+ * line. Returns the number of reduced-rate samples.
+ */
+size_t ReverbState::decimateLines(const size_t todo)
+{
+    BiquadBank<2>::FilterLine filters[NUM_LINES];
+    float *lines[NUM_LINES];
+    for(size_t c{0u};c < NUM_LINES;c++)
+    {
+        filters[c] = {&mDecimFilter[c].Lp0, &mDecimFilter[c].Lp1};
+        lines[c] = mTempSamples[c].data();
+    }
+    BiquadBank<2>{{filters, NUM_LINES}}.process(lines, lines, todo);
+
+    size_t count{0u};
+    for(float *line : lines)
+    {
+        count = 0;
+        for(size_t i{mRatePhase};i < todo;i += mRateDiv)
+            line[count++] = line[i];
+    }
+    mRatePhase = mRatePhase + count*mRateDiv - todo;
+    return count;
+}
+
+/* Linearly interpolates the reduced-rate early and late lines back up to the
+ * device rate, for the given range of the update. The first decimated sample
+ * was taken at device-rate offset 'first', and the output trails the input by
+ * one reduced-rate sample to have each interpolation's end point available.
+ */
+void ReverbState::interpolateLines(const size_t first, const size_t offset, const size_t todo)
+{
+    ASSUME(todo > 0);
+
+    const float scale{1.0f / static_cast<float>(mRateDiv)};
+    const size_t pos{offset + mRateDiv - first};
+    for(size_t c{0u};c < NUM_LINES;c++)
+    {
+        auto do_interp = [this,scale,pos,todo](const ReverbReducedLine &src, float *RESTRICT dst)
+        {
+            size_t idx{pos / mRateDiv};
+            size_t frac{pos % mRateDiv};
+            for(size_t i{0u};i < todo;++i)
+            {
+                dst[i] = lerp(src[idx], src[idx+1], static_cast<float>(frac)*scale);
+                if(++frac == mRateDiv)
+                {
+                    frac = 0;
+                    ++idx;
+                }
+            }
+        };
+        do_interp(mReducedSamples[0][c], mEarlySamples[c].data());
+        do_interp(mReducedSamples[1][c], mLateSamples[c].data());
+    }
+
+    BiquadBank<1>::FilterLine filters[NUM_LINES*2];
+    float *lines[NUM_LINES*2];
+    for(size_t c{0u};c < NUM_LINES;c++)
+    {
+        filters[c] = {&mInterpFilter[0][c]};
+        lines[c] = mEarlySamples[c].data();
+        filters[NUM_LINES+c] = {&mInterpFilter[1][c]};
+        lines[NUM_LINES+c] = mLateSamples[c].data();
+    }
+    BiquadBank<1>{{filters, NUM_LINES*2}}.process(lines, lines, todo);
+}
+
 void ReverbState::process(const size_t samplesToDo, const al::span<const FloatBufferLine> samplesIn, const al::span<FloatBufferLine> samplesOut)
 {
     size_t offset{mOffset};
 
     ASSUME(samplesToDo > 0);
 
-    /* Convert B-Format to A-Format for processing. */
-    const size_t numInput{minz(samplesIn.size(), NUM_LINES)};
-    const al::span<float> tmpspan{al::assume_aligned<16>(mTempLine.data()), samplesToDo};
+    /* Convert B-Format to A-Format for processing, then band-pass the
+     * incoming samples and feed the initial delay line, a block at a time.
+     */
+    BiquadBank<2>::FilterLine filters[NUM_LINES];
+    float *lines[NUM_LINES];
     for(size_t c{0u};c < NUM_LINES;c++)
     {
-        std::fill(tmpspan.begin(), tmpspan.end(), 0.0f);
-        for(size_t i{0};i < numInput;++i)
-        {
-            const float gain{B2A[c][i]};
-            const float *RESTRICT input{al::assume_aligned<16>(samplesIn[i].data())};
+        filters[c] = {&mFilter[c].Lp, &mFilter[c].Hp};
+        lines[c] = mTempSamples[c].data();
+    }
+
+    const size_t firstPhase{mRatePhase};
+    const size_t numInput{minz(samplesIn.size(), NUM_LINES)};
+    /* The number of samples the delay network processes this update. */
+    size_t netSamplesToDo{0u};
+    for(size_t base{0u};base < samplesToDo;)
+    {
+        const size_t todo{minz(samplesToDo - base, MAX_UPDATE_SAMPLES)};
 
-            for(float &sample : tmpspan)
+        for(size_t c{0u};c < NUM_LINES;c++)
+        {
+            const al::span<float> tmpspan{al::assume_aligned<16>(lines[c]), todo};
+            std::fill(tmpspan.begin(), tmpspan.end(), 0.0f);
+            for(size_t i{0};i < numInput;++i)
             {
-                sample += *input * gain;
-                ++input;
+                const float gain{B2A[c][i]};
+                const float *RESTRICT input{al::assume_aligned<16>(samplesIn[i].data()+base)};
+
+                for(float &sample : tmpspan)
+                {
+                    sample += *input * gain;
+                    ++input;
+                }
             }
         }
+        BiquadBank<2>{{filters, NUM_LINES}}.process(lines, lines, todo);
+
+        const size_t count{(mRateDiv > 1) ? decimateLines(todo) : todo};
+        if LIKELY(count > 0)
+        {
+            for(size_t c{0u};c < NUM_LINES;c++)
+                mDelay.write(offset+netSamplesToDo, c, lines[c], count);
+        }
 
-        /* Band-pass the incoming samples and feed the initial delay line. */
-        DualBiquad{mFilter[c].Lp, mFilter[c].Hp}.process(tmpspan, tmpspan.data());
-        mDelay.write(offset, c, tmpspan.cbegin(), samplesToDo);
+        netSamplesToDo += count;
+        base += todo;
     }
 
+    /* When running at a reduced rate, the early reflections and late reverb
+     * are stored and interpolated back to the device rate for mixing after.
+     */
+    const MixOutT mixOut{(mRateDiv > 1) ? &ReverbState::StoreReduced : mMixOut};
+
     /* Process reverb for these samples. */
-    if LIKELY(!mDoFading)
+    if UNLIKELY(netSamplesToDo == 0)
     {
-        for(size_t base{0};base < samplesToDo;)
+        /* Nothing for the delay network to do (only possible with a reduced
+         * rate and a tiny update).
+         */
+    }
+    else if LIKELY(!mDoFading)
+    {
+        for(size_t base{0};base < netSamplesToDo;)
         {
             /* Calculate the number of samples we can do this iteration. */
-            size_t todo{minz(samplesToDo - base, mMaxUpdate[0])};
+            size_t todo{minz(netSamplesToDo - base, mMaxUpdate[0])};
             /* Some mixers require maintaining a 4-sample alignment, so ensure
              * that if it's not the last iteration.
              */
-            if(base+todo < samplesToDo) todo &= ~size_t{3};
+            if(base+todo < netSamplesToDo) todo &= ~size_t{3};
             ASSUME(todo > 0);
 
             /* Generate non-faded early reflections and late reverb. */
@@ -1629,7 +1836,7 @@ void ReverbState::process(const size_t samplesToDo, const al::span<const FloatBu
             lateUnfaded(offset, todo);
 
             /* Finally, mix early reflections and late reverb. */
-            (this->*mMixOut)(samplesOut, samplesToDo-base, base, todo);
+            (this->*mixOut)(samplesOut, netSamplesToDo-base, base, todo);
 
             offset += todo;
             base += todo;
@@ -1637,11 +1844,11 @@ void ReverbState::process(const size_t samplesToDo, const al::span<const FloatBu
     }
     else
     {
-        const float fadeStep{1.0f / static_cast<float>(samplesToDo)};
-        for(size_t base{0};base < samplesToDo;)
+        const float fadeStep{1.0f / static_cast<float>(netSamplesToDo)};
+        for(size_t base{0};base < netSamplesToDo;)
         {
-            size_t todo{minz(samplesToDo - base, minz(mMaxUpdate[0], mMaxUpdate[1]))};
-            if(base+todo < samplesToDo) todo &= ~size_t{3};
+            size_t todo{minz(netSamplesToDo - base, minz(mMaxUpdate[0], mMaxUpdate[1]))};
+            if(base+todo < netSamplesToDo) todo &= ~size_t{3};
             ASSUME(todo > 0);
 
             /* Generate cross-faded early reflections and late reverb. */
@@ -1649,7 +1856,7 @@ void ReverbState::process(const size_t samplesToDo, const al::span<const FloatBu
             earlyFaded(offset, todo, fadeCount, fadeStep);
             lateFaded(offset, todo, fadeCount, fadeStep);
 
-            (this->*mMixOut)(samplesOut, samplesToDo-base, base, todo);
+            (this->*mixOut)(samplesOut, netSamplesToDo-base, base, todo);
 
             offset += todo;
             base += todo;
@@ -1674,6 +1881,31 @@ void ReverbState::process(const size_t samplesToDo, const al::span<const FloatBu
         mDoFading = false;
     }
     mOffset = offset;
+
+    if(mRateDiv > 1)
+    {
+        for(size_t base{0};base < samplesToDo;)
+        {
+            const size_t todo{minz(samplesToDo - base, MAX_UPDATE_SAMPLES)};
+
+            interpolateLines(firstPhase, base, todo);
+            (this->*mMixOut)(samplesOut, samplesToDo-base, base, todo);
+
+            base += todo;
+        }
+
+        /* Keep the last two reduced-rate samples as history for the next
+         * update's interpolation.
+         */
+        for(auto &reduced : mReducedSamples)
+        {
+            for(auto &line : reduced)
+            {
+                line[0] = line[netSamplesToDo];
+                line[1] = line[netSamplesToDo+1];
+            }
+        }
+    }
 }
 
 
@@ -1978,6 +2210,7 @@ struct ReverbStateFactory final : public EffectStateFactory {
     EffectState *create() override { return new ReverbState{}; }
     EffectProps getDefaultProps() const noexcept override;
     const EffectVtable *getEffectVtable() const noexcept override { return &EAXReverb_vtable; }
+    ALuint getInputOrder() const noexcept override { return 1; }
 };
 
 EffectProps ReverbStateFactory::getDefaultProps() const noexcept
@@ -2193,6 +2426,7 @@ struct StdReverbStateFactory final : public EffectStateFactory {
     EffectState *create() override { return new ReverbState{}; }
     EffectProps getDefaultProps() const noexcept override;
     const EffectVtable *getEffectVtable() const noexcept override { return &StdReverb_vtable; }
+    ALuint getInputOrder() const noexcept override { return 1; }
 };
 
 EffectProps StdReverbStateFactory::getDefaultProps() const noexcept
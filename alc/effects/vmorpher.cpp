@@ -29,6 +29,7 @@
 #include "alcmain.h"
 #include "alcontext.h"
 #include "alu.h"
+#include "oscillator.h"
 
 namespace {
 
@@ -40,15 +41,8 @@ namespace {
 #define VOWEL_A_INDEX      0
 #define VOWEL_B_INDEX      1
 
-#define WAVEFORM_FRACBITS  24
-#define WAVEFORM_FRACONE   (1<<WAVEFORM_FRACBITS)
-#define WAVEFORM_FRACMASK  (WAVEFORM_FRACONE-1)
-
 inline float Sin(ALuint index)
-{
-    constexpr float scale{al::MathDefs<float>::Tau() / WAVEFORM_FRACONE};
-    return std::sin(static_cast<float>(index) * scale)*0.5f + 0.5f;
-}
+{ return WaveSin(index)*0.5f + 0.5f; }
 
 inline float Saw(ALuint index)
 { return static_cast<float>(index) / float{WAVEFORM_FRACONE}; }
@@ -58,17 +52,6 @@ inline float Triangle(ALuint index)
 
 inline float Half(ALuint) { return 0.5f; }
 
-template<float (&func)(ALuint)>
-void Oscillate(float *RESTRICT dst, ALuint index, const ALuint step, size_t todo)
-{
-    for(size_t i{0u};i < todo;i++)
-    {
-        index += step;
-        index &= WAVEFORM_FRACMASK;
-        dst[i] = func(index);
-    }
-}
-
 struct FormantFilter
 {
     float mCoeff{0.0f};
@@ -214,13 +197,13 @@ void VmorpherState::update(const ALCcontext *context, const ALeffectslot *slot,
     mStep = fastf2u(clampf(step*WAVEFORM_FRACONE, 0.0f, float{WAVEFORM_FRACONE-1}));
 
     if(mStep == 0)
-        mGetSamples = Oscillate<Half>;
+        mGetSamples = GenerateWave<Half>;
     else if(props->Vmorpher.Waveform == AL_VOCAL_MORPHER_WAVEFORM_SINUSOID)
-        mGetSamples = Oscillate<Sin>;
+        mGetSamples = GenerateWave<Sin>;
     else if(props->Vmorpher.Waveform == AL_VOCAL_MORPHER_WAVEFORM_SAWTOOTH)
-        mGetSamples = Oscillate<Saw>;
+        mGetSamples = GenerateWave<Saw>;
     else /*if(props->Vmorpher.Waveform == AL_VOCAL_MORPHER_WAVEFORM_TRIANGLE)*/
-        mGetSamples = Oscillate<Triangle>;
+        mGetSamples = GenerateWave<Triangle>;
 
     const float pitchA{std::pow(2.0f,
         static_cast<float>(props->Vmorpher.PhonemeACoarseTuning) / 12.0f)};
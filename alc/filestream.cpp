@@ -0,0 +1,648 @@
+
+#include "config.h"
+
+#include "filestream.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <cstring>
+#include <ios>
+#include <limits>
+
+#include "alnumeric.h"
+#include "endiantest.h"
+#include "logging.h"
+
+
+namespace {
+
+/* The number of sample frames decoded at a time for PCM data. */
+constexpr size_t PcmReadFrames{1024};
+
+/* The Apple IMA4 packet size, per channel. */
+constexpr size_t AppleIMA4PacketSize{34};
+constexpr size_t AppleIMA4PacketFrames{64};
+
+constexpr size_t MaxAdpcmChannels{2};
+
+constexpr uint64_t UnknownDataSize{~uint64_t{0}};
+
+/* The tail of the KSDATAFORMAT_SUBTYPE GUIDs, following the format tag. */
+constexpr ALubyte SubtypeGuidTail[14]{
+    0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0xaa, 0x00, 0x38, 0x9b, 0x71
+};
+
+constexpr ALubyte Wave64RiffGuid[16]{
+    'r','i','f','f', 0x2e,0x91,0xcf,0x11, 0xa5,0xd6,0x28,0xdb,0x04,0xc1,0x00,0x00
+};
+constexpr ALubyte Wave64WaveGuid[16]{
+    'w','a','v','e', 0xf3,0xac,0xd3,0x11, 0x8c,0xd1,0x00,0xc0,0x4f,0x8e,0xdb,0x8a
+};
+constexpr ALubyte Wave64FmtGuid[16]{
+    'f','m','t',' ', 0xf3,0xac,0xd3,0x11, 0x8c,0xd1,0x00,0xc0,0x4f,0x8e,0xdb,0x8a
+};
+constexpr ALubyte Wave64DataGuid[16]{
+    'd','a','t','a', 0xf3,0xac,0xd3,0x11, 0x8c,0xd1,0x00,0xc0,0x4f,0x8e,0xdb,0x8a
+};
+
+
+template<size_t N>
+inline bool matches(const al::byte *data, const ALubyte (&tag)[N]) noexcept
+{ return std::memcmp(data, tag, N) == 0; }
+inline bool matches(const al::byte *data, const char *tag) noexcept
+{ return std::memcmp(data, tag, 4) == 0; }
+
+inline uint32_t read_le16(const al::byte *b) noexcept
+{ return al::to_integer<uint32_t>(b[0]) | (al::to_integer<uint32_t>(b[1])<<8); }
+inline uint32_t read_le32(const al::byte *b) noexcept
+{ return read_le16(b) | (read_le16(b+2)<<16); }
+inline uint64_t read_le64(const al::byte *b) noexcept
+{ return read_le32(b) | (uint64_t{read_le32(b+4)}<<32); }
+
+inline uint32_t read_be32(const al::byte *b) noexcept
+{
+    return (al::to_integer<uint32_t>(b[0])<<24) | (al::to_integer<uint32_t>(b[1])<<16) |
+        (al::to_integer<uint32_t>(b[2])<<8) | al::to_integer<uint32_t>(b[3]);
+}
+inline uint64_t read_be64(const al::byte *b) noexcept
+{ return (uint64_t{read_be32(b)}<<32) | read_be32(b+4); }
+
+/* Reverses the bytes of each sample in place. */
+void swap_samples(al::byte *data, size_t count, size_t samplesize)
+{
+    for(size_t i{0};i < count;++i)
+    {
+        std::reverse(data, data+samplesize);
+        data += samplesize;
+    }
+}
+
+/* Reads a signed integer sample of 'size' bytes, as a float. */
+inline float read_int_sample(const al::byte *src, size_t size, bool bigendian) noexcept
+{
+    uint32_t val{0u};
+    if(bigendian)
+    {
+        for(size_t i{0};i < size;++i)
+            val |= al::to_integer<uint32_t>(src[i]) << (24 - i*8);
+    }
+    else
+    {
+        for(size_t i{0};i < size;++i)
+            val |= al::to_integer<uint32_t>(src[i]) << ((4-size+i)*8);
+    }
+    return static_cast<float>(static_cast<int32_t>(val)) * (1.0f/2147483648.0f);
+}
+
+} // namespace
+
+
+FileStream::FileStream(const char *fname) : mFile{fname, std::ios::binary}
+{ }
+
+bool FileStream::setWaveFormat(const al::byte *fmt, size_t size)
+{
+    if(size < 16)
+    {
+        ERR("Format chunk too small (%zu bytes)\n", size);
+        return false;
+    }
+
+    uint32_t tag{read_le16(fmt)};
+    mNumChannels = read_le16(fmt+2);
+    mSampleRate = read_le32(fmt+4);
+    mBlockAlign = read_le16(fmt+12);
+    mChannelMask = 0;
+    if(tag == 0xfffe)
+    {
+        if(size < 40)
+        {
+            ERR("Extensible format chunk too small (%zu bytes)\n", size);
+            return false;
+        }
+        mChannelMask = read_le32(fmt+20);
+        tag = read_le16(fmt+24);
+        if(!matches(fmt+26, SubtypeGuidTail))
+        {
+            ERR("Unsupported extensible format subtype\n");
+            return false;
+        }
+    }
+    if(mNumChannels == 0 || mBlockAlign == 0 || (mBlockAlign%mNumChannels) != 0)
+    {
+        ERR("Invalid block alignment (%u channels, %u bytes)\n", mNumChannels, mBlockAlign);
+        return false;
+    }
+
+    const ALuint samplesize{mBlockAlign / mNumChannels};
+    mBigEndian = false;
+    mBlockFrames = 1;
+    switch(tag)
+    {
+    case 0x0001: /* PCM */
+        if(samplesize == 1) mEncoding = Encoding::UByte;
+        else if(samplesize == 2) mEncoding = Encoding::Short;
+        else if(samplesize == 3) mEncoding = Encoding::Int24;
+        else if(samplesize == 4) mEncoding = Encoding::Int32;
+        else break;
+        return true;
+    case 0x0003: /* IEEE float */
+        if(samplesize == 4) mEncoding = Encoding::Float;
+        else if(samplesize == 8) mEncoding = Encoding::Double;
+        else break;
+        return true;
+    case 0x0006: /* A-law */
+        if(samplesize != 1) break;
+        mEncoding = Encoding::Alaw;
+        return true;
+    case 0x0007: /* Mu-law */
+        if(samplesize != 1) break;
+        mEncoding = Encoding::Mulaw;
+        return true;
+    case 0x0011: /* IMA ADPCM */
+        if(mNumChannels > MaxAdpcmChannels || samplesize < 8 || (samplesize&3) != 0)
+            break;
+        mEncoding = Encoding::IMA4;
+        mBlockFrames = (samplesize-4)*2 + 1;
+        return true;
+    case 0x0002: /* MS ADPCM */
+        if(mNumChannels > MaxAdpcmChannels || samplesize < 8)
+            break;
+        mEncoding = Encoding::MSADPCM;
+        mBlockFrames = (samplesize-7)*2 + 2;
+        return true;
+    }
+    ERR("Unsupported format 0x%04x (%u channels, %u byte alignment)\n", tag, mNumChannels,
+        mBlockAlign);
+    return false;
+}
+
+bool FileStream::loadWave(bool rf64)
+{
+    uint64_t ds64datasize{UnknownDataSize};
+    bool gotfmt{false};
+
+    al::byte hdr[8];
+    while(mFile.read(reinterpret_cast<char*>(hdr), sizeof(hdr)))
+    {
+        const uint32_t size{read_le32(hdr+4)};
+        if(matches(hdr, "fmt ") || (rf64 && matches(hdr, "ds64")))
+        {
+            if(size > std::numeric_limits<uint16_t>::max())
+                break;
+            al::vector<al::byte> chunk(size);
+            if(!mFile.read(reinterpret_cast<char*>(chunk.data()), size))
+                break;
+            if(matches(hdr, "ds64"))
+            {
+                if(size >= 16)
+                    ds64datasize = read_le64(chunk.data()+8);
+            }
+            else
+            {
+                if(!setWaveFormat(chunk.data(), size))
+                    return false;
+                gotfmt = true;
+            }
+            mFile.ignore(size&1);
+        }
+        else if(matches(hdr, "data"))
+        {
+            if(!gotfmt)
+            {
+                ERR("Data chunk before format chunk\n");
+                return false;
+            }
+            if(rf64 && size == 0xffffffff)
+                mDataRemaining = ds64datasize;
+            else if(size != 0xffffffff)
+                mDataRemaining = size;
+            return true;
+        }
+        else
+            mFile.ignore(std::streamsize{size} + (size&1));
+    }
+    ERR("No data chunk found\n");
+    return false;
+}
+
+bool FileStream::loadWave64()
+{
+    bool gotfmt{false};
+
+    al::byte hdr[24];
+    while(mFile.read(reinterpret_cast<char*>(hdr), sizeof(hdr)))
+    {
+        const uint64_t size{read_le64(hdr+16)};
+        if(size < sizeof(hdr))
+            break;
+        const uint64_t body{size - sizeof(hdr)};
+        const uint64_t padding{(8 - (size&7)) & 7};
+
+        if(matches(hdr, Wave64FmtGuid))
+        {
+            if(body > std::numeric_limits<uint16_t>::max())
+                break;
+            al::vector<al::byte> chunk(static_cast<size_t>(body));
+            if(!mFile.read(reinterpret_cast<char*>(chunk.data()),
+                static_cast<std::streamsize>(body)))
+                break;
+            if(!setWaveFormat(chunk.data(), chunk.size()))
+                return false;
+            gotfmt = true;
+            mFile.ignore(static_cast<std::streamsize>(padding));
+        }
+        else if(matches(hdr, Wave64DataGuid))
+        {
+            if(!gotfmt)
+            {
+                ERR("Data chunk before format chunk\n");
+                return false;
+            }
+            mDataRemaining = body;
+            return true;
+        }
+        else
+            mFile.seekg(static_cast<std::streamoff>(body + padding), std::ios::cur);
+    }
+    ERR("No data chunk found\n");
+    return false;
+}
+
+bool FileStream::loadCaf()
+{
+    bool gotdesc{false};
+
+    al::byte hdr[12];
+    while(mFile.read(reinterpret_cast<char*>(hdr), sizeof(hdr)))
+    {
+        const uint64_t size{read_be64(hdr+4)};
+        if(matches(hdr, "desc"))
+        {
+            al::byte desc[32];
+            if(size < sizeof(desc) || !mFile.read(reinterpret_cast<char*>(desc), sizeof(desc)))
+                break;
+            mFile.seekg(static_cast<std::streamoff>(size - sizeof(desc)), std::ios::cur);
+
+            const uint64_t ratebits{read_be64(desc)};
+            double rate;
+            std::memcpy(&rate, &ratebits, sizeof(rate));
+            const uint32_t flags{read_be32(desc+12)};
+            const uint32_t packetsize{read_be32(desc+16)};
+            const uint32_t packetframes{read_be32(desc+20)};
+            mNumChannels = read_be32(desc+24);
+            mSampleRate = static_cast<ALuint>(clampd(std::round(rate), 0.0, 1000000.0));
+            mBlockAlign = packetsize;
+            mBlockFrames = packetframes;
+            mBigEndian = !(flags&2);
+
+            bool ok{mNumChannels > 0 && packetsize > 0 && (packetsize%mNumChannels) == 0};
+            const uint32_t samplesize{ok ? packetsize/mNumChannels : 0};
+            if(!ok)
+            { }
+            else if(matches(desc+8, "lpcm") && packetframes == 1)
+            {
+                if((flags&1))
+                {
+                    if(samplesize == 4) mEncoding = Encoding::Float;
+                    else if(samplesize == 8) mEncoding = Encoding::Double;
+                    else ok = false;
+                }
+                else if(samplesize == 1) mEncoding = Encoding::Byte;
+                else if(samplesize == 2) mEncoding = Encoding::Short;
+                else if(samplesize == 3) mEncoding = Encoding::Int24;
+                else if(samplesize == 4) mEncoding = Encoding::Int32;
+                else ok = false;
+            }
+            else if(matches(desc+8, "ulaw") && packetframes == 1 && samplesize == 1)
+                mEncoding = Encoding::Mulaw;
+            else if(matches(desc+8, "alaw") && packetframes == 1 && samplesize == 1)
+                mEncoding = Encoding::Alaw;
+            else if(matches(desc+8, "ima4") && packetframes == AppleIMA4PacketFrames
+                && samplesize == AppleIMA4PacketSize && mNumChannels <= MaxAdpcmChannels)
+                mEncoding = Encoding::AppleIMA4;
+            else
+                ok = false;
+            if(!ok)
+            {
+                ERR("Unsupported format '%.4s' (%u channels, %u bytes per %u frames)\n",
+                    reinterpret_cast<const char*>(desc+8), mNumChannels, packetsize,
+                    packetframes);
+                return false;
+            }
+            gotdesc = true;
+        }
+        else if(matches(hdr, "data"))
+        {
+            if(!gotdesc)
+            {
+                ERR("Data chunk before description chunk\n");
+                return false;
+            }
+            /* Skip the edit count. A size of -1 means the data runs to the
+             * end of the file.
+             */
+            mFile.ignore(4);
+            if(size != UnknownDataSize)
+                mDataRemaining = (size > 4) ? size-4 : 0;
+            return true;
+        }
+        else
+            mFile.seekg(static_cast<std::streamoff>(size), std::ios::cur);
+    }
+    ERR("No data chunk found\n");
+    return false;
+}
+
+bool FileStream::setOutputFormat()
+{
+    /* WAVE speaker masks for each of the supported layouts. */
+    constexpr uint32_t MaskMono{0x4}, MaskStereo{0x3}, MaskRear{0x30}, MaskQuad{0x33},
+        MaskX51{0x60f}, MaskX51Rear{0x3f}, MaskX61{0x70f}, MaskX71{0x63f};
+
+    const uint32_t mask{mChannelMask};
+    bool ok{false};
+    switch(mNumChannels)
+    {
+    case 1:
+        mChannels = FmtMono;
+        ok = (mask == 0 || mask == MaskMono);
+        break;
+    case 2:
+        mChannels = (mask == MaskRear) ? FmtRear : FmtStereo;
+        ok = (mask == 0 || mask == MaskStereo || mask == MaskRear);
+        break;
+    case 4:
+        mChannels = FmtQuad;
+        ok = (mask == 0 || mask == MaskQuad);
+        break;
+    case 6:
+        mChannels = FmtX51;
+        ok = (mask == 0 || mask == MaskX51 || mask == MaskX51Rear);
+        break;
+    case 7:
+        mChannels = FmtX61;
+        ok = (mask == 0 || mask == MaskX61);
+        break;
+    case 8:
+        mChannels = FmtX71;
+        ok = (mask == 0 || mask == MaskX71);
+        break;
+    }
+    if(!ok)
+    {
+        ERR("Unsupported channel layout (%u channels, mask 0x%x)\n", mNumChannels, mask);
+        return false;
+    }
+    if(mSampleRate < 1)
+    {
+        ERR("Invalid sample rate %u\n", mSampleRate);
+        return false;
+    }
+
+    switch(mEncoding)
+    {
+    case Encoding::UByte:
+    case Encoding::Byte: mType = FmtUByte; break;
+    case Encoding::Short:
+    case Encoding::IMA4:
+    case Encoding::AppleIMA4:
+    case Encoding::MSADPCM: mType = FmtShort; break;
+    case Encoding::Int24:
+    case Encoding::Int32:
+    case Encoding::Float: mType = FmtFloat; break;
+    case Encoding::Double: mType = FmtDouble; break;
+    case Encoding::Mulaw: mType = FmtMulaw; break;
+    case Encoding::Alaw: mType = FmtAlaw; break;
+    }
+    mFrameSize = FrameSizeFromFmt(mChannels, mType, 0);
+
+    /* PCM is decoded a number of frames at a time, while ADPCM is decoded one
+     * block at a time. Apple IMA4 packets are decoded as IMA4 blocks with the
+     * packet header as an extra leading sample.
+     */
+    if(mBlockFrames == 1)
+    {
+        mRawData.resize(PcmReadFrames * mBlockAlign);
+        mDecoded.resize(PcmReadFrames * mFrameSize);
+    }
+    else
+    {
+        mRawData.resize(mBlockAlign);
+        mDecoded.resize((mBlockFrames+1) * mFrameSize);
+    }
+    return true;
+}
+
+bool FileStream::decodeBlocks()
+{
+    mDecodedPos = 0;
+    mDecodedEnd = 0;
+
+    size_t toread{mRawData.size()};
+    if(mDataRemaining != UnknownDataSize)
+        toread = static_cast<size_t>(std::min<uint64_t>(toread, mDataRemaining));
+    if(toread == 0)
+        return false;
+
+    mFile.read(reinterpret_cast<char*>(mRawData.data()), static_cast<std::streamsize>(toread));
+    const size_t got{static_cast<size_t>(mFile.gcount())};
+    if(mDataRemaining != UnknownDataSize)
+        mDataRemaining -= got;
+
+    const size_t blocks{got / mBlockAlign};
+    if(blocks == 0)
+    {
+        /* A partial block at the end of the data can't be decoded. */
+        mDataRemaining = 0;
+        return false;
+    }
+
+    const size_t samples{blocks * mBlockFrames * mNumChannels};
+    const al::byte *src{mRawData.data()};
+    al::byte *dst{mDecoded.data()};
+    switch(mEncoding)
+    {
+    case Encoding::UByte:
+    case Encoding::Mulaw:
+    case Encoding::Alaw:
+        std::copy_n(src, samples, dst);
+        break;
+    case Encoding::Byte:
+        std::transform(src, src+samples, dst, [](al::byte b) { return b ^ 0x80; });
+        break;
+    case Encoding::Short:
+    case Encoding::Float:
+    case Encoding::Double:
+    {
+        const size_t samplesize{mBlockAlign / mNumChannels};
+        std::copy_n(src, samples*samplesize, dst);
+        if(mBigEndian == IS_LITTLE_ENDIAN)
+            swap_samples(dst, samples, samplesize);
+        break;
+    }
+    case Encoding::Int24:
+    case Encoding::Int32:
+    {
+        const size_t samplesize{mBlockAlign / mNumChannels};
+        auto *out = reinterpret_cast<float*>(dst);
+        for(size_t i{0};i < samples;++i)
+            out[i] = read_int_sample(src + i*samplesize, samplesize, mBigEndian);
+        break;
+    }
+    case Encoding::IMA4:
+        DecodeIMA4Block(reinterpret_cast<int16_t*>(dst), src, mNumChannels, mBlockFrames);
+        break;
+    case Encoding::MSADPCM:
+        DecodeMSADPCMBlock(reinterpret_cast<int16_t*>(dst), src, mNumChannels, mBlockFrames);
+        break;
+    case Encoding::AppleIMA4:
+    {
+        /* Each channel's packet has a 2-byte big-endian header, holding the
+         * predictor in the top 9 bits and the step index in the low 7, with
+         * 32 bytes of nibbles following. Rearrange them into an IMA4 block,
+         * which has a 4-byte header per channel followed by interleaved
+         * 4-byte groups of nibbles, in the same nibble order.
+         */
+        al::byte block[AppleIMA4PacketSize*MaxAdpcmChannels + 2*MaxAdpcmChannels];
+        al::byte *out{block};
+        for(size_t c{0};c < mNumChannels;++c)
+        {
+            const al::byte *packet{src + c*AppleIMA4PacketSize};
+            const uint32_t header{(al::to_integer<uint32_t>(packet[0])<<8) |
+                al::to_integer<uint32_t>(packet[1])};
+            const uint32_t predictor{header & 0xff80};
+            *(out++) = static_cast<al::byte>(predictor&0xff);
+            *(out++) = static_cast<al::byte>(predictor>>8);
+            *(out++) = static_cast<al::byte>(header&0x7f);
+            *(out++) = static_cast<al::byte>(0);
+        }
+        for(size_t g{0};g < (AppleIMA4PacketSize-2)/4;++g)
+        {
+            for(size_t c{0};c < mNumChannels;++c)
+                out = std::copy_n(src + c*AppleIMA4PacketSize + 2 + g*4, 4, out);
+        }
+
+        /* The decoded block starts with the predictor, which isn't part of
+         * the packet's output.
+         */
+        DecodeIMA4Block(reinterpret_cast<int16_t*>(dst), block, mNumChannels,
+            AppleIMA4PacketFrames+1);
+        mDecodedPos = mFrameSize;
+        mDecodedEnd = mFrameSize;
+        break;
+    }
+    }
+    mDecodedEnd += blocks * mBlockFrames * mFrameSize;
+    return true;
+}
+
+size_t FileStream::read(al::byte *dst, size_t frames)
+{
+    size_t total{0};
+    while(total < frames)
+    {
+        if(mDecodedPos == mDecodedEnd && !decodeBlocks())
+            break;
+
+        const size_t todo{std::min((frames-total)*mFrameSize, mDecodedEnd-mDecodedPos)};
+        dst = std::copy_n(mDecoded.begin()+static_cast<ptrdiff_t>(mDecodedPos), todo, dst);
+        mDecodedPos += todo;
+        total += todo / mFrameSize;
+    }
+    return total;
+}
+
+bool FileStream::seek(uint64_t frame)
+{
+    if(frame > mLength)
+        return false;
+
+    /* Seek to the block containing the frame, and skip the frames before it
+     * once decoded.
+     */
+    const uint64_t offset{frame / mBlockFrames * mBlockAlign};
+    mFile.clear();
+    if(!mFile.seekg(static_cast<std::streamoff>(mDataStart + offset)))
+        return false;
+    mDataRemaining = mDataSize - offset;
+    mDecodedPos = 0;
+    mDecodedEnd = 0;
+
+    const auto skip = static_cast<size_t>(frame % mBlockFrames);
+    if(skip > 0)
+    {
+        if(!decodeBlocks())
+            return false;
+        mDecodedPos += skip * mFrameSize;
+    }
+    return true;
+}
+
+
+std::unique_ptr<FileStream> FileStream::Open(const char *fname)
+{
+    std::unique_ptr<FileStream> stream{new FileStream{fname}};
+    if(!stream->mFile.is_open())
+    {
+        ERR("Could not open file %s\n", fname);
+        return nullptr;
+    }
+
+    al::byte hdr[40];
+    auto read_header = [&stream,&hdr](size_t offset, size_t len) -> bool
+    {
+        return !!stream->mFile.read(reinterpret_cast<char*>(hdr+offset),
+            static_cast<std::streamsize>(len));
+    };
+
+    bool loaded{false};
+    if(!read_header(0, 4))
+        ERR("Could not read file %s\n", fname);
+    else if(matches(hdr, "RIFF") || matches(hdr, "RF64"))
+    {
+        if(read_header(4, 8) && matches(hdr+8, "WAVE"))
+            loaded = stream->loadWave(matches(hdr, "RF64"));
+        else
+            ERR("%s is not a WAVE file\n", fname);
+    }
+    else if(matches(hdr, "riff"))
+    {
+        if(read_header(4, 36) && matches(hdr, Wave64RiffGuid) && matches(hdr+24, Wave64WaveGuid))
+            loaded = stream->loadWave64();
+        else
+            ERR("%s is not a Wave64 file\n", fname);
+    }
+    else if(matches(hdr, "caff"))
+    {
+        if(read_header(4, 4))
+            loaded = stream->loadCaf();
+    }
+    else
+        ERR("Unsupported file type for %s\n", fname);
+
+    if(!loaded || !stream->setOutputFormat())
+        return nullptr;
+
+    /* Find where the data starts and how long it is, for seeking. A data size
+     * that runs past the end of the file is cut short.
+     */
+    const std::streamoff start{stream->mFile.tellg()};
+    stream->mFile.seekg(0, std::ios::end);
+    const std::streamoff end{stream->mFile.tellg()};
+    if(start < 0 || end < start || !stream->mFile.seekg(start))
+    {
+        ERR("Could not find the data size of %s\n", fname);
+        return nullptr;
+    }
+    stream->mDataStart = static_cast<uint64_t>(start);
+    stream->mDataSize = std::min(stream->mDataRemaining, static_cast<uint64_t>(end - start));
+    stream->mDataRemaining = stream->mDataSize;
+    stream->mLength = stream->mDataSize / stream->mBlockAlign * stream->mBlockFrames;
+
+    TRACE("Streaming %s: %u channel%s, %uhz, %u frames per block, %" PRIu64 " frames\n",
+        fname, stream->mNumChannels, (stream->mNumChannels==1)?"":"s", stream->mSampleRate,
+        stream->mBlockFrames, stream->mLength);
+    return stream;
+}
@@ -0,0 +1,92 @@
+#ifndef ALC_FILESTREAM_H
+#define ALC_FILESTREAM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "AL/al.h"
+
+#include "al/buffer.h"
+#include "albyte.h"
+#include "alfstream.h"
+#include "almalloc.h"
+#include "vector.h"
+
+
+/* Decodes sample frames from a WAV, RF64, W64 or CAF file as they're read, for
+ * buffers that stream from disk. PCM, float, mu-law and a-law samples are
+ * passed through or converted to a storable format, while IMA4 and MSADPCM
+ * blocks are decoded to 16-bit samples.
+ */
+class FileStream {
+public:
+    enum class Encoding : unsigned char {
+        UByte,
+        Byte,
+        Short,
+        Int24,
+        Int32,
+        Float,
+        Double,
+        Mulaw,
+        Alaw,
+        IMA4,
+        AppleIMA4,
+        MSADPCM,
+    };
+
+private:
+    al::ifstream mFile;
+
+    Encoding mEncoding{Encoding::UByte};
+    bool mBigEndian{false};
+    ALuint mNumChannels{0u};
+    /* The WAVE speaker mask, or 0 for the default layout. */
+    uint32_t mChannelMask{0u};
+    /* Bytes and sample frames in each block (a single frame for PCM). */
+    ALuint mBlockAlign{0u};
+    ALuint mBlockFrames{1u};
+    /* Bytes left in the data chunk, or ~0 when it runs to the end of file
+     * (only while loading). The data chunk's offset and size are kept for
+     * seeking.
+     */
+    uint64_t mDataRemaining{~uint64_t{0}};
+    uint64_t mDataStart{0u};
+    uint64_t mDataSize{0u};
+
+    al::vector<al::byte> mRawData;
+    al::vector<al::byte,16> mDecoded;
+    size_t mDecodedPos{0u};
+    size_t mDecodedEnd{0u};
+
+    bool loadWave(bool rf64);
+    bool loadWave64();
+    bool loadCaf();
+    bool setWaveFormat(const al::byte *fmt, size_t size);
+    bool setOutputFormat();
+    bool decodeBlocks();
+
+public:
+    FmtChannels mChannels{FmtMono};
+    FmtType mType{FmtUByte};
+    ALuint mSampleRate{0u};
+    ALuint mFrameSize{0u};
+    /* The total number of sample frames. */
+    uint64_t mLength{0u};
+
+    FileStream(const char *fname);
+
+    /** Reads up to 'frames' sample frames, returning how many were read. */
+    size_t read(al::byte *dst, size_t frames);
+
+    /** Sets the next sample frame to read. */
+    bool seek(uint64_t frame);
+    bool rewind() { return seek(0); }
+
+    static std::unique_ptr<FileStream> Open(const char *fname);
+
+    DEF_NEWDEL(FileStream)
+};
+
+#endif /* ALC_FILESTREAM_H */
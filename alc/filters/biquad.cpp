@@ -3,6 +3,10 @@
 
 #include "biquad.h"
 
+#ifdef HAVE_SSE_INTRINSICS
+#include <xmmintrin.h>
+#endif
+
 #include <algorithm>
 #include <cassert>
 #include <cmath>
@@ -161,3 +165,168 @@ void BiquadFilterR<Real>::dualProcess(BiquadFilterR &other, const al::span<const
 
 template class BiquadFilterR<float>;
 template class BiquadFilterR<double>;
+
+
+template<size_t NumStages>
+void BiquadBank<NumStages>::process(const float *const *src, float *const *dst,
+    const size_t count)
+{
+    for(size_t base{0};base < lines.size();base += sLanes)
+    {
+        const size_t numlanes{std::min(lines.size()-base, sLanes)};
+        const FilterLine *RESTRICT group{&lines[base]};
+        const float *const *RESTRICT gsrc{src + base};
+        float *const *RESTRICT gdst{dst + base};
+
+        if(numlanes == 1)
+        {
+            /* A lone line doesn't benefit from the lanes, so just run the
+             * filters directly, two at a time where possible.
+             */
+            const float *input{gsrc[0]};
+            size_t s{0};
+            for(;s+1 < NumStages;s += 2)
+            {
+                group[0][s]->dualProcess(*group[0][s+1], {input, count}, gdst[0]);
+                input = gdst[0];
+            }
+            if(s < NumStages)
+                group[0][s]->process({input, count}, gdst[0]);
+            continue;
+        }
+
+        /* Load the group's coefficients and state. Unused lanes get a pass-
+         * through filter.
+         */
+        alignas(16) float b0[NumStages][sLanes], b1[NumStages][sLanes], b2[NumStages][sLanes];
+        alignas(16) float a1[NumStages][sLanes], a2[NumStages][sLanes];
+        alignas(16) float z1[NumStages][sLanes], z2[NumStages][sLanes];
+        for(size_t s{0};s < NumStages;++s)
+        {
+            for(size_t l{0};l < sLanes;++l)
+            {
+                if(l < numlanes)
+                {
+                    const BiquadFilter &filter = *group[l][s];
+                    b0[s][l] = filter.mB0;
+                    b1[s][l] = filter.mB1;
+                    b2[s][l] = filter.mB2;
+                    a1[s][l] = filter.mA1;
+                    a2[s][l] = filter.mA2;
+                    z1[s][l] = filter.mZ1;
+                    z2[s][l] = filter.mZ2;
+                }
+                else
+                {
+                    b0[s][l] = 1.0f;
+                    b1[s][l] = b2[s][l] = a1[s][l] = a2[s][l] = 0.0f;
+                    z1[s][l] = z2[s][l] = 0.0f;
+                }
+            }
+        }
+
+#ifdef HAVE_SSE_INTRINSICS
+        __m128 vb0[NumStages], vb1[NumStages], vb2[NumStages], va1[NumStages], va2[NumStages];
+        __m128 vz1[NumStages], vz2[NumStages];
+        for(size_t s{0};s < NumStages;++s)
+        {
+            vb0[s] = _mm_load_ps(b0[s]);
+            vb1[s] = _mm_load_ps(b1[s]);
+            vb2[s] = _mm_load_ps(b2[s]);
+            va1[s] = _mm_load_ps(a1[s]);
+            va2[s] = _mm_load_ps(a2[s]);
+            vz1[s] = _mm_load_ps(z1[s]);
+            vz2[s] = _mm_load_ps(z2[s]);
+        }
+
+        /* Each vector holds one sample of every line in the group. */
+        auto proc_sample = [&vb0,&vb1,&vb2,&va1,&va2,&vz1,&vz2](__m128 input) noexcept -> __m128
+        {
+            for(size_t s{0};s < NumStages;++s)
+            {
+                const __m128 output{_mm_add_ps(_mm_mul_ps(input, vb0[s]), vz1[s])};
+                vz1[s] = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(input, vb1[s]),
+                    _mm_mul_ps(output, va1[s])), vz2[s]);
+                vz2[s] = _mm_sub_ps(_mm_mul_ps(input, vb2[s]), _mm_mul_ps(output, va2[s]));
+                input = output;
+            }
+            return input;
+        };
+        auto load_lane = [gsrc,numlanes](size_t l, size_t i) noexcept -> __m128
+        { return (l < numlanes) ? _mm_loadu_ps(&gsrc[l][i]) : _mm_setzero_ps(); };
+
+        /* Transpose blocks of four samples of each line, so the lanes can be
+         * processed a sample at a time, then transpose them back for output.
+         */
+        size_t i{0};
+        for(;count-i >= 4;i += 4)
+        {
+            __m128 s0{load_lane(0, i)}, s1{load_lane(1, i)};
+            __m128 s2{load_lane(2, i)}, s3{load_lane(3, i)};
+            _MM_TRANSPOSE4_PS(s0, s1, s2, s3);
+
+            s0 = proc_sample(s0);
+            s1 = proc_sample(s1);
+            s2 = proc_sample(s2);
+            s3 = proc_sample(s3);
+
+            _MM_TRANSPOSE4_PS(s0, s1, s2, s3);
+            _mm_storeu_ps(&gdst[0][i], s0);
+            _mm_storeu_ps(&gdst[1][i], s1);
+            if(numlanes > 2) _mm_storeu_ps(&gdst[2][i], s2);
+            if(numlanes > 3) _mm_storeu_ps(&gdst[3][i], s3);
+        }
+        for(;i < count;++i)
+        {
+            alignas(16) float samples[sLanes]{};
+            for(size_t l{0};l < numlanes;++l)
+                samples[l] = gsrc[l][i];
+            _mm_store_ps(samples, proc_sample(_mm_load_ps(samples)));
+            for(size_t l{0};l < numlanes;++l)
+                gdst[l][i] = samples[l];
+        }
+
+        for(size_t s{0};s < NumStages;++s)
+        {
+            _mm_store_ps(z1[s], vz1[s]);
+            _mm_store_ps(z2[s], vz2[s]);
+        }
+
+#else
+
+        for(size_t i{0};i < count;++i)
+        {
+            float samples[sLanes]{};
+            for(size_t l{0};l < numlanes;++l)
+                samples[l] = gsrc[l][i];
+            for(size_t s{0};s < NumStages;++s)
+            {
+                for(size_t l{0};l < sLanes;++l)
+                {
+                    const float input{samples[l]};
+                    const float output{input*b0[s][l] + z1[s][l]};
+                    z1[s][l] = input*b1[s][l] - output*a1[s][l] + z2[s][l];
+                    z2[s][l] = input*b2[s][l] - output*a2[s][l];
+                    samples[l] = output;
+                }
+            }
+            for(size_t l{0};l < numlanes;++l)
+                gdst[l][i] = samples[l];
+        }
+#endif
+
+        for(size_t s{0};s < NumStages;++s)
+        {
+            for(size_t l{0};l < numlanes;++l)
+            {
+                BiquadFilter &filter = *group[l][s];
+                filter.mZ1 = z1[s][l];
+                filter.mZ2 = z2[s][l];
+            }
+        }
+    }
+}
+
+template struct BiquadBank<1>;
+template struct BiquadBank<2>;
+template struct BiquadBank<4>;
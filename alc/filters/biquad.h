@@ -2,6 +2,7 @@
 #define FILTERS_BIQUAD_H
 
 #include <algorithm>
+#include <array>
 #include <cmath>
 #include <cstddef>
 #include <utility>
@@ -37,6 +38,9 @@ enum class BiquadType {
     BandPass,
 };
 
+template<size_t NumStages>
+struct BiquadBank;
+
 template<typename Real>
 class BiquadFilterR {
     /* Last two delayed components for direct form II. */
@@ -128,6 +132,9 @@ public:
         z2 = in*mB2 - out*mA2;
         return out;
     }
+
+    template<size_t NumStages>
+    friend struct BiquadBank;
 };
 
 template<typename Real>
@@ -141,4 +148,25 @@ struct DualBiquadR {
 using BiquadFilter = BiquadFilterR<float>;
 using DualBiquad = DualBiquadR<float>;
 
+/**
+ * Processes a number of independent lines, each through its own cascade of
+ * NumStages biquad filters (applied in order). The coefficients and state of
+ * each group of sLanes lines are loaded into a structure of arrays, so the
+ * group is filtered together with each line in its own (SIMD) lane. A lone
+ * line is filtered with the scalar cascade instead.
+ *
+ * A line's destination may be the same as its source, but must not overlap
+ * any other line's source.
+ */
+template<size_t NumStages>
+struct BiquadBank {
+    static constexpr size_t sLanes{4};
+
+    using FilterLine = std::array<BiquadFilter*,NumStages>;
+
+    const al::span<const FilterLine> lines;
+
+    void process(const float *const *src, float *const *dst, const size_t count);
+};
+
 #endif /* FILTERS_BIQUAD_H */
@@ -0,0 +1,46 @@
+
+#include "config.h"
+
+#include "phasesplit.h"
+
+#include <algorithm>
+
+
+void PhaseSplitter::process(const al::span<const float> input, float *inphase,
+    float *quadrature)
+{
+    std::copy(input.cbegin(), input.cend(), inphase);
+    std::copy(input.cbegin(), input.cend(), quadrature);
+
+    const size_t count{input.size()};
+    for(size_t s{0};s < PhaseSplitSections;++s)
+    {
+        /* The two chains are independent, so run them together. */
+        const float ra{PhaseSplitRefCoeffs[s]};
+        const float sa{PhaseSplitShiftCoeffs[s]};
+        Section ref{mRef[s]};
+        Section shift{mShift[s]};
+        for(size_t i{0};i < count;++i)
+        {
+            const float rx{inphase[i]};
+            const float ry{ra*(rx + ref.y2) - ref.x2};
+            ref.x2 = ref.x1; ref.x1 = rx;
+            ref.y2 = ref.y1; ref.y1 = ry;
+            inphase[i] = ry;
+
+            const float sx{quadrature[i]};
+            const float sy{sa*(sx + shift.y2) - shift.x2};
+            shift.x2 = shift.x1; shift.x1 = sx;
+            shift.y2 = shift.y1; shift.y1 = sy;
+            quadrature[i] = sy;
+        }
+        mRef[s] = ref;
+        mShift[s] = shift;
+    }
+
+    /* Apply the reference chain's 1-sample delay. */
+    float last{mRefDelay};
+    for(size_t i{0};i < count;++i)
+        std::swap(inphase[i], last);
+    mRefDelay = last;
+}
@@ -0,0 +1,50 @@
+#ifndef FILTER_PHASESPLIT_H
+#define FILTER_PHASESPLIT_H
+
+#include <array>
+#include <cstddef>
+
+#include "alspan.h"
+
+
+/* IIR phase splitter, as designed by Olli Niemitalo. The input is run through
+ * two chains of 2nd order all-pass sections in z^-2, where each section is
+ *
+ * y[n] = a^2*(x[n] + y[n-2]) - x[n-2]
+ *
+ * The output of the shifted chain leads the (1-sample delayed) output of the
+ * reference chain by 90 +/- 0.7 degrees from 20hz to 20khz, given a 44.1khz
+ * sample rate (the range scales with the sample rate). The two outputs keep
+ * the input's magnitude, but have a frequency-dependent phase.
+ */
+constexpr size_t PhaseSplitSections{4};
+
+/* The squared coefficients of each chain's sections. */
+constexpr std::array<float,PhaseSplitSections> PhaseSplitRefCoeffs{{
+    0.6923878f*0.6923878f, 0.9360654322959f*0.9360654322959f,
+    0.9882295226860f*0.9882295226860f, 0.9987488452737f*0.9987488452737f
+}};
+constexpr std::array<float,PhaseSplitSections> PhaseSplitShiftCoeffs{{
+    0.4021921162426f*0.4021921162426f, 0.8561710882420f*0.8561710882420f,
+    0.9722909545651f*0.9722909545651f, 0.9952884791278f*0.9952884791278f
+}};
+
+class PhaseSplitter {
+    struct Section {
+        float x1, x2, y1, y2;
+    };
+    std::array<Section,PhaseSplitSections> mRef{};
+    std::array<Section,PhaseSplitSections> mShift{};
+    float mRefDelay{0.0f};
+
+public:
+    void clear() noexcept { *this = PhaseSplitter{}; }
+
+    /**
+     * Splits the input into an in-phase output (the reference chain) and a
+     * quadrature output, shifted +90 degrees relative to the in-phase one.
+     */
+    void process(const al::span<const float> input, float *inphase, float *quadrature);
+};
+
+#endif /* FILTER_PHASESPLIT_H */
@@ -49,12 +49,17 @@
 #include "alnumeric.h"
 #include "aloptional.h"
 #include "alspan.h"
+#include "alstring.h"
 #include "filters/splitter.h"
 #include "logging.h"
 #include "math_defs.h"
 #include "opthelpers.h"
 #include "polyphase_resampler.h"
 
+#ifdef HAVE_LIBMYSOFA
+#include "sofahrtf.h"
+#endif
+
 
 namespace {
 
@@ -179,6 +184,38 @@ public:
 };
 
 
+/* Converts to and from IEEE half-precision floats, for compact HRIR storage.
+ * Values too small for a normalized half are flushed to 0 (they're below
+ * -84dB), and too large values are clamped, so the conversion back doesn't
+ * need to handle denormals, infinities, or NaNs.
+ */
+ALushort FloatToHalf(float value)
+{
+    const ALushort sign{static_cast<ALushort>(std::signbit(value) ? 0x8000u : 0u)};
+    value = std::abs(value);
+    if(!(value >= 6.103515625e-05f/*2^-14*/))
+        return sign;
+    if(value >= 65504.0f)
+        return static_cast<ALushort>(sign | 0x7bffu);
+
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    /* Rebias the exponent, and round the mantissa to nearest-even. */
+    bits -= 112u << 23;
+    bits += 0x0fffu + ((bits>>13)&1u);
+    return static_cast<ALushort>(sign | (bits>>13));
+}
+
+inline float HalfToFloat(const ALushort value) noexcept
+{
+    /* Shift the half's bits into place, then scale to rebias the exponent. */
+    const uint32_t bits{((value&0x8000u) << 16) | ((value&0x7fffu) << 13)};
+    float ret;
+    std::memcpy(&ret, &bits, sizeof(ret));
+    return ret * 5.192296858534828e+33f/*2^112*/;
+}
+
+
 struct IdxBlend { ALuint idx; float blend; };
 /* Calculate the elevation index given the polar elevation in radians. This
  * will return an index between 0 and (evcount - 1).
@@ -204,6 +241,23 @@ IdxBlend CalcAzIndex(ALuint azcount, float az)
     return IdxBlend{idx%azcount, az-static_cast<float>(idx)};
 }
 
+/* Unpacks the given stored HRIR into a full-length array. */
+void LoadHrir(const HrtfStore *Hrtf, const size_t idx, HrirArray &hrir)
+{
+    const size_t irstride{Hrtf->irStride};
+    auto hrir_end = hrir.begin();
+    if(const half2 *halfcoeffs{Hrtf->halfCoeffs})
+    {
+        auto to_float2 = [](const half2 &in) noexcept -> float2
+        { return float2{{HalfToFloat(in[0]), HalfToFloat(in[1])}}; };
+        hrir_end = std::transform(halfcoeffs + idx*irstride, halfcoeffs + (idx+1)*irstride,
+            hrir.begin(), to_float2);
+    }
+    else
+        hrir_end = std::copy_n(Hrtf->coeffs + idx*irstride, irstride, hrir.begin());
+    std::fill(hrir_end, hrir.end(), float2{});
+}
+
 } // namespace
 
 
@@ -265,16 +319,107 @@ void GetHrtfCoeffs(const HrtfStore *Hrtf, float elevation, float azimuth, float
     coeffout[0] = PassthruCoeff * (1.0f-dirfact);
     coeffout[1] = PassthruCoeff * (1.0f-dirfact);
     std::fill_n(coeffout+2, size_t{HRIR_LENGTH-1}*2, 0.0f);
-    for(size_t c{0};c < 4;c++)
+    const size_t irstride{Hrtf->irStride};
+    if(const half2 *halfcoeffs{Hrtf->halfCoeffs})
+    {
+        for(size_t c{0};c < 4;c++)
+        {
+            const ALushort *srccoeffs{halfcoeffs[idx[c]*irstride].data()};
+            const float mult{blend[c]};
+            auto blend_coeffs = [mult](const ALushort src, const float coeff) noexcept -> float
+            { return HalfToFloat(src)*mult + coeff; };
+            std::transform(srccoeffs, srccoeffs + irstride*2, coeffout, coeffout, blend_coeffs);
+        }
+    }
+    else
     {
-        const float *srccoeffs{al::assume_aligned<16>(Hrtf->coeffs[idx[c]][0].data())};
-        const float mult{blend[c]};
-        auto blend_coeffs = [mult](const float src, const float coeff) noexcept -> float
-        { return src*mult + coeff; };
-        std::transform(srccoeffs, srccoeffs + HRIR_LENGTH*2, coeffout, coeffout, blend_coeffs);
+        for(size_t c{0};c < 4;c++)
+        {
+            const float *srccoeffs{al::assume_aligned<16>(Hrtf->coeffs[idx[c]*irstride].data())};
+            const float mult{blend[c]};
+            auto blend_coeffs = [mult](const float src, const float coeff) noexcept -> float
+            { return src*mult + coeff; };
+            std::transform(srccoeffs, srccoeffs + irstride*2, coeffout, coeffout, blend_coeffs);
+        }
+    }
+}
+
+
+HrtfCoeffCache::HrtfCoeffCache(size_t numentries, float resolution)
+{
+    /* Round up to a power of two number of sets. */
+    size_t numsets{1u};
+    while(numsets*SetSize < numentries)
+    {
+        numsets <<= 1;
+        ++mSetBits;
+    }
+    mEntries.resize(numsets * SetSize);
+    for(Entry &entry : mEntries)
+    {
+        entry.mKey = ~uint64_t{0};
+        entry.mLastUse = 0u;
     }
+
+    mResolution = Deg2Rad(resolution);
+    mInvResolution = 1.0f / mResolution;
 }
 
+void HrtfCoeffCache::get(const HrtfStore *Hrtf, float elevation, float azimuth, float distance,
+    float spread, HrirArray &coeffs, const al::span<ALuint,2> delays)
+{
+    /* The field is part of the key instead of the distance, since that's all
+     * the distance selects.
+     */
+    ALuint fdidx{0u};
+    while(fdidx < Hrtf->fdCount-1 && distance < Hrtf->field[fdidx].distance)
+        ++fdidx;
+
+    const ALuint ev{fastf2u((elevation + al::MathDefs<float>::Pi()*0.5f)*mInvResolution + 0.5f)};
+    const ALuint az{fastf2u((azimuth + al::MathDefs<float>::Pi())*mInvResolution + 0.5f)};
+    const ALuint sp{fastf2u(spread*mInvResolution + 0.5f)};
+    const uint64_t key{uint64_t{ev&0xffff} | (uint64_t{az&0xffff}<<16) |
+        (uint64_t{sp&0xffff}<<32) | (uint64_t{fdidx}<<48)};
+
+    const ALuint usecount{++mUseCount};
+    const size_t set{mSetBits ? static_cast<size_t>((key*0x9e3779b97f4a7c15_u64) >> (64-mSetBits))
+        : size_t{0u}};
+    Entry *entries{&mEntries[set*SetSize]};
+
+    Entry *oldest{entries};
+    for(size_t i{0};i < SetSize;++i)
+    {
+        Entry &entry = entries[i];
+        if(entry.mKey == key)
+        {
+            entry.mLastUse = usecount;
+            coeffs = entry.mCoeffs;
+            delays[0] = entry.mDelay[0];
+            delays[1] = entry.mDelay[1];
+            return;
+        }
+        /* Compare ages rather than use counts, in case the count wrapped. */
+        if(usecount-entry.mLastUse > usecount-oldest->mLastUse)
+            oldest = &entry;
+    }
+
+    /* Calculate the HRIR for the quantized direction, so every source in the
+     * same bin gets the same result regardless of which filled it.
+     */
+    GetHrtfCoeffs(Hrtf, static_cast<float>(ev)*mResolution - al::MathDefs<float>::Pi()*0.5f,
+        static_cast<float>(az)*mResolution - al::MathDefs<float>::Pi(),
+        distance, static_cast<float>(sp)*mResolution, oldest->mCoeffs, oldest->mDelay);
+    oldest->mKey = key;
+    oldest->mLastUse = usecount;
+
+    coeffs = oldest->mCoeffs;
+    delays[0] = oldest->mDelay[0];
+    delays[1] = oldest->mDelay[1];
+}
+
+std::unique_ptr<HrtfCoeffCache> HrtfCoeffCache::Create(size_t numentries, float resolution)
+{ return std::unique_ptr<HrtfCoeffCache>{new HrtfCoeffCache{numentries, resolution}}; }
+
 
 std::unique_ptr<DirectHrtfState> DirectHrtfState::Create(size_t num_chans)
 { return std::unique_ptr<DirectHrtfState>{new(FamCount(num_chans)) DirectHrtfState{num_chans}}; }
@@ -285,7 +430,7 @@ void DirectHrtfState::build(const HrtfStore *Hrtf, const al::span<const AngularP
 {
     using double2 = std::array<double,2>;
     struct ImpulseResponse {
-        const HrirArray &hrir;
+        size_t irIdx;
         ALuint ldelay, rdelay;
     };
 
@@ -326,8 +471,7 @@ void DirectHrtfState::build(const HrtfStore *Hrtf, const al::span<const AngularP
 
         /* The largest blend factor serves as the closest HRIR. */
         const size_t irOffset{idx[std::max_element(blend.begin(), blend.end()) - blend.begin()]};
-        ImpulseResponse res{Hrtf->coeffs[irOffset],
-            Hrtf->delays[irOffset][0], Hrtf->delays[irOffset][1]};
+        ImpulseResponse res{irOffset, Hrtf->delays[irOffset][0], Hrtf->delays[irOffset][1]};
 
         min_delay = minu(min_delay, minu(res.ldelay, res.rdelay));
         max_delay = maxu(max_delay, maxu(res.ldelay, res.rdelay));
@@ -339,16 +483,17 @@ void DirectHrtfState::build(const HrtfStore *Hrtf, const al::span<const AngularP
     { return (d+HRIR_DELAY_FRACHALF) >> HRIR_DELAY_FRACBITS; };
 
     auto tmpres = al::vector<std::array<double2,HRIR_LENGTH>>(mChannels.size());
+    HrirArray hrir;
     for(size_t c{0u};c < AmbiPoints.size();++c)
     {
-        const HrirArray &hrir{impres[c].hrir};
+        LoadHrir(Hrtf, impres[c].irIdx, hrir);
         const ALuint ldelay{hrir_delay_round(impres[c].ldelay - min_delay)};
         const ALuint rdelay{hrir_delay_round(impres[c].rdelay - min_delay)};
 
         for(size_t i{0u};i < mChannels.size();++i)
         {
             const double mult{AmbiMatrix[c][i]};
-            const size_t numirs{HRIR_LENGTH - maxz(ldelay, rdelay)};
+            const size_t numirs{minz(Hrtf->irStride, HRIR_LENGTH - maxz(ldelay, rdelay))};
             size_t lidx{ldelay}, ridx{rdelay};
             for(size_t j{0};j < numirs;++j)
             {
@@ -380,21 +525,27 @@ void DirectHrtfState::build(const HrtfStore *Hrtf, const al::span<const AngularP
 
 namespace {
 
-std::unique_ptr<HrtfStore> CreateHrtfStore(ALuint rate, ALushort irSize,
+/* Creates a HRTF store with the given data, with each HRIR taking coeffStride
+ * taps from coeffs. The store keeps irStride taps of each, in half-precision if
+ * requested.
+ */
+std::unique_ptr<HrtfStore> CreateHrtfStore(ALuint rate, ALuint irSize,
     const al::span<const HrtfStore::Field> fields,
-    const al::span<const HrtfStore::Elevation> elevs, const HrirArray *coeffs,
+    const al::span<const HrtfStore::Elevation> elevs, const float2 *coeffs,
+    const size_t coeffStride, const ALuint irStride, const bool halfPrecision,
     const ubyte2 *delays, const char *filename)
 {
     std::unique_ptr<HrtfStore> Hrtf;
 
     const size_t irCount{size_t{elevs.back().azCount} + elevs.back().irOffset};
+    const size_t coeffSize{halfPrecision ? sizeof(half2) : sizeof(float2)};
     size_t total{sizeof(HrtfStore)};
     total  = RoundUp(total, alignof(HrtfStore::Field)); /* Align for field infos */
     total += sizeof(HrtfStore::Field)*fields.size();
     total  = RoundUp(total, alignof(HrtfStore::Elevation)); /* Align for elevation infos */
     total += sizeof(Hrtf->elev[0])*elevs.size();
     total  = RoundUp(total, 16); /* Align for coefficients using SIMD */
-    total += sizeof(Hrtf->coeffs[0])*irCount;
+    total += coeffSize*irStride*irCount;
     total += sizeof(Hrtf->delays[0])*irCount;
 
     Hrtf.reset(new (al_calloc(16, total)) HrtfStore{});
@@ -405,6 +556,7 @@ std::unique_ptr<HrtfStore> CreateHrtfStore(ALuint rate, ALushort irSize,
         InitRef(Hrtf->mRef, 1u);
         Hrtf->sampleRate = rate;
         Hrtf->irSize = irSize;
+        Hrtf->irStride = irStride;
         Hrtf->fdCount = static_cast<ALuint>(fields.size());
 
         /* Set up pointers to storage following the main HRTF struct. */
@@ -420,30 +572,73 @@ std::unique_ptr<HrtfStore> CreateHrtfStore(ALuint rate, ALushort irSize,
         offset += sizeof(elev_[0])*elevs.size();
 
         offset = RoundUp(offset, 16); /* Align for coefficients using SIMD */
-        auto coeffs_ = reinterpret_cast<HrirArray*>(base + offset);
-        offset += sizeof(coeffs_[0])*irCount;
+        void *coeffs_{base + offset};
+        offset += coeffSize*irStride*irCount;
 
         auto delays_ = reinterpret_cast<ubyte2*>(base + offset);
         offset += sizeof(delays_[0])*irCount;
 
         assert(offset == total);
 
-        /* Copy input data to storage. */
+        /* Copy input data to storage. Any taps past the input stride are left
+         * as 0 from the allocation.
+         */
         std::copy(fields.cbegin(), fields.cend(), field_);
         std::copy(elevs.cbegin(), elevs.cend(), elev_);
-        std::copy_n(coeffs, irCount, coeffs_);
+        const size_t numtaps{minz(coeffStride, irStride)};
+        if(halfPrecision)
+        {
+            auto halfcoeffs = static_cast<half2*>(coeffs_);
+            auto to_half2 = [](const float2 &in) -> half2
+            { return half2{{FloatToHalf(in[0]), FloatToHalf(in[1])}}; };
+            for(size_t i{0};i < irCount;++i)
+                std::transform(coeffs + i*coeffStride, coeffs + i*coeffStride + numtaps,
+                    halfcoeffs + i*irStride, to_half2);
+            Hrtf->halfCoeffs = halfcoeffs;
+        }
+        else
+        {
+            auto floatcoeffs = static_cast<float2*>(coeffs_);
+            for(size_t i{0};i < irCount;++i)
+                std::copy_n(coeffs + i*coeffStride, numtaps, floatcoeffs + i*irStride);
+            Hrtf->coeffs = floatcoeffs;
+        }
         std::copy_n(delays, irCount, delays_);
 
         /* Finally, assign the storage pointers. */
         Hrtf->field = field_;
         Hrtf->elev = elev_;
-        Hrtf->coeffs = coeffs_;
         Hrtf->delays = delays_;
     }
 
     return Hrtf;
 }
 
+std::unique_ptr<HrtfStore> CreateHrtfStore(ALuint rate, ALushort irSize,
+    const al::span<const HrtfStore::Field> fields,
+    const al::span<const HrtfStore::Elevation> elevs, const HrirArray *coeffs,
+    const ubyte2 *delays, const char *filename)
+{
+    return CreateHrtfStore(rate, irSize, fields, elevs, coeffs[0].data(), HRIR_LENGTH,
+        HRIR_LENGTH, false, delays, filename);
+}
+
+/* Repacks a loaded HRTF store to only hold as many taps of each HRIR as it
+ * uses, rounded up to keep them aligned for SIMD.
+ */
+std::unique_ptr<HrtfStore> CompactHrtfStore(const HrtfStore &hrtf, const bool halfPrecision,
+    const char *filename)
+{
+    const size_t evTotal{std::accumulate(hrtf.field, hrtf.field+hrtf.fdCount, size_t{0},
+        [](const size_t curval, const HrtfStore::Field &field) noexcept -> size_t
+        { return curval + field.evCount; })};
+    const ALuint irStride{minu(static_cast<ALuint>(RoundUp(hrtf.irSize, 4)), HRIR_LENGTH)};
+
+    return CreateHrtfStore(hrtf.sampleRate, hrtf.irSize, {hrtf.field, hrtf.fdCount},
+        {hrtf.elev, evTotal}, hrtf.coeffs, hrtf.irStride, irStride, halfPrecision, hrtf.delays,
+        filename);
+}
+
 void MirrorLeftHrirs(const al::span<const HrtfStore::Elevation> elevs, HrirArray *coeffs,
     ubyte2 *delays)
 {
@@ -1247,6 +1442,10 @@ al::vector<std::string> EnumerateHrtf(const char *devname)
                 const std::string pname{pathlist, end};
                 for(const auto &fname : SearchDataFiles(".mhr", pname.c_str()))
                     AddFileEntry(fname);
+#ifdef HAVE_LIBMYSOFA
+                for(const auto &fname : SearchDataFiles(".sofa", pname.c_str()))
+                    AddFileEntry(fname);
+#endif
             }
 
             pathlist = next;
@@ -1257,6 +1456,10 @@ al::vector<std::string> EnumerateHrtf(const char *devname)
     {
         for(const auto &fname : SearchDataFiles(".mhr", "openal/hrtf"))
             AddFileEntry(fname);
+#ifdef HAVE_LIBMYSOFA
+        for(const auto &fname : SearchDataFiles(".sofa", "openal/hrtf"))
+            AddFileEntry(fname);
+#endif
 
         if(!GetResource(IDR_DEFAULT_HRTF_MHR).empty())
             AddBuiltInEntry("Built-In HRTF", IDR_DEFAULT_HRTF_MHR);
@@ -1289,6 +1492,8 @@ HrtfStorePtr GetLoadedHrtf(const std::string &name, const char *devname, const A
         return nullptr;
     const std::string &fname = entry_iter->mFilename;
 
+    const bool halfPrecision{!!GetConfigValueBool(devname, nullptr, "hrtf-half-precision", false)};
+
     std::lock_guard<std::mutex> __{LoadedHrtfLock};
     auto hrtf_lt_fname = [](LoadedHrtf &hrtf, const std::string &filename) -> bool
     { return hrtf.mFilename < filename; };
@@ -1296,7 +1501,7 @@ HrtfStorePtr GetLoadedHrtf(const std::string &name, const char *devname, const A
     while(handle != LoadedHrtfs.end() && handle->mFilename == fname)
     {
         HrtfStore *hrtf{handle->mEntry.get()};
-        if(hrtf && hrtf->sampleRate == devrate)
+        if(hrtf && hrtf->sampleRate == devrate && (hrtf->halfCoeffs != nullptr) == halfPrecision)
         {
             hrtf->add_ref();
             return HrtfStorePtr{hrtf};
@@ -1318,6 +1523,19 @@ HrtfStorePtr GetLoadedHrtf(const std::string &name, const char *devname, const A
         }
         stream = std::make_unique<idstream>(res.begin(), res.end());
     }
+#ifdef HAVE_LIBMYSOFA
+    else if(fname.size() > 5 && al::strcasecmp(fname.c_str()+fname.size()-5, ".sofa") == 0)
+    {
+        /* SOFA data sets are converted to the device rate when loaded. */
+        TRACE("Loading %s...\n", fname.c_str());
+        stream = OpenSofaHrtf(fname, devname, devrate);
+        if(!stream)
+        {
+            ERR("Could not convert %s\n", fname.c_str());
+            return nullptr;
+        }
+    }
+#endif
     else
     {
         TRACE("Loading %s...\n", fname.c_str());
@@ -1382,10 +1600,10 @@ HrtfStorePtr GetLoadedHrtf(const std::string &name, const char *devname, const A
         rs.init(hrtf->sampleRate, devrate);
         for(size_t i{0};i < irCount;++i)
         {
-            HrirArray &coeffs = const_cast<HrirArray&>(hrtf->coeffs[i]);
+            float2 *coeffs{const_cast<float2*>(hrtf->coeffs + i*hrtf->irStride)};
             for(size_t j{0};j < 2;++j)
             {
-                std::transform(coeffs.cbegin(), coeffs.cend(), inout[0].begin(),
+                std::transform(coeffs, coeffs+HRIR_LENGTH, inout[0].begin(),
                     [j](const float2 &in) noexcept -> double { return in[j]; });
                 rs.process(HRIR_LENGTH, inout[0].data(), HRIR_LENGTH, inout[1].data());
                 for(size_t k{0};k < HRIR_LENGTH;++k)
@@ -1435,14 +1653,22 @@ HrtfStorePtr GetLoadedHrtf(const std::string &name, const char *devname, const A
         hrtf->sampleRate = devrate;
     }
 
+    /* Only keep as much of each HRIR as is used. */
+    hrtf = CompactHrtfStore(*hrtf, halfPrecision, name.c_str());
+    if(!hrtf)
+    {
+        ERR("Failed to load %s\n", name.c_str());
+        return nullptr;
+    }
+
     if(auto hrtfsizeopt = ConfigValueUInt(devname, nullptr, "hrtf-size"))
     {
         if(*hrtfsizeopt > 0 && *hrtfsizeopt < hrtf->irSize)
             hrtf->irSize = maxu(*hrtfsizeopt, MIN_IR_LENGTH);
     }
 
-    TRACE("Loaded HRTF %s for sample rate %uhz, %u-sample filter\n", name.c_str(),
-        hrtf->sampleRate, hrtf->irSize);
+    TRACE("Loaded HRTF %s for sample rate %uhz, %u-sample filter, %s-precision storage\n",
+        name.c_str(), hrtf->sampleRate, hrtf->irSize, halfPrecision ? "half" : "single");
     handle = LoadedHrtfs.emplace(handle, LoadedHrtf{fname, std::move(hrtf)});
 
     return HrtfStorePtr{handle->mEntry.get()};
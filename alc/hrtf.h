@@ -3,6 +3,7 @@
 
 #include <array>
 #include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <string>
 
@@ -31,6 +32,7 @@
 using float2 = std::array<float,2>;
 using HrirArray = std::array<float2,HRIR_LENGTH>;
 using ubyte2 = std::array<ALubyte,2>;
+using half2 = std::array<ALushort,2>;
 
 
 struct HrtfStore {
@@ -54,7 +56,12 @@ struct HrtfStore {
         ALushort irOffset;
     };
     Elevation *elev;
-    const HrirArray *coeffs;
+    /* Each HRIR has irStride taps (irSize rounded up for SIMD), stored in
+     * coeffs, or as half-precision floats in halfCoeffs if set.
+     */
+    ALuint irStride;
+    const float2 *coeffs;
+    const half2 *halfCoeffs;
     const ubyte2 *delays;
 
     void add_ref();
@@ -111,6 +118,46 @@ struct DirectHrtfState {
 };
 
 
+/* Caches HRIRs blended by GetHrtfCoeffs for quantized directions, so sources
+ * at about the same direction only need to look up and copy them. Each entry
+ * is keyed by the quantized elevation, azimuth, and spread, along with the
+ * field the distance selects, and the entries are held in small sets that
+ * evict the least recently used one. It's only used by the device's mixer
+ * thread, so needs no locking.
+ */
+class HrtfCoeffCache {
+    static constexpr size_t SetSize{4};
+
+    struct Entry {
+        alignas(16) HrirArray mCoeffs;
+        std::array<ALuint,2> mDelay;
+        uint64_t mKey;
+        ALuint mLastUse;
+    };
+    al::vector<Entry,16> mEntries;
+    size_t mSetBits{0u};
+    ALuint mUseCount{0u};
+
+    /* The quantization step, in radians. */
+    float mResolution{0.0f};
+    float mInvResolution{0.0f};
+
+public:
+    HrtfCoeffCache(size_t numentries, float resolution);
+
+    void get(const HrtfStore *Hrtf, float elevation, float azimuth, float distance,
+        float spread, HrirArray &coeffs, const al::span<ALuint,2> delays);
+
+    /**
+     * Creates a cache of at least the given number of entries, quantizing
+     * directions to the given resolution in degrees.
+     */
+    static std::unique_ptr<HrtfCoeffCache> Create(size_t numentries, float resolution);
+
+    DEF_NEWDEL(HrtfCoeffCache)
+};
+
+
 al::vector<std::string> EnumerateHrtf(const char *devname);
 HrtfStorePtr GetLoadedHrtf(const std::string &name, const char *devname, const ALuint devrate);
 
@@ -81,6 +81,8 @@ AL_API void AL_APIENTRY alGetPointervSOFT(ALenum pname, void **values);
 #define AL_SOFT_callback_buffer
 #define AL_BUFFER_CALLBACK_FUNCTION_SOFT         0x19A0
 #define AL_BUFFER_CALLBACK_USER_PARAM_SOFT       0x19A1
+#define AL_BUFFER_CALLBACK_PREFETCH_SOFT         0x19A2
+#define AL_BUFFER_RESAMPLE_CACHE_SOFT            0x19A3
 typedef ALsizei (AL_APIENTRY*LPALBUFFERCALLBACKTYPESOFT)(ALvoid *userptr, ALvoid *sampledata, ALsizei numsamples);
 typedef void (AL_APIENTRY*LPALBUFFERCALLBACKSOFT)(ALuint buffer, ALenum format, ALsizei freq, LPALBUFFERCALLBACKTYPESOFT callback, ALvoid *userptr, ALbitfieldSOFT flags);
 typedef void (AL_APIENTRY*LPALGETBUFFERPTRSOFT)(ALuint buffer, ALenum param, ALvoid **value);
@@ -94,11 +96,41 @@ AL_API void AL_APIENTRY alGetBufferPtrvSOFT(ALuint buffer, ALenum param, ALvoid
 #endif
 #endif
 
+#ifndef AL_SOFT_file_buffer
+#define AL_SOFT_file_buffer
+typedef void (AL_APIENTRY*LPALBUFFERFILESOFT)(ALuint buffer, const ALchar *filename);
+#ifdef AL_ALEXT_PROTOTYPES
+AL_API void AL_APIENTRY alBufferFileSOFT(ALuint buffer, const ALchar *filename);
+#endif
+#endif
+
 #ifndef AL_SOFT_bformat_hoa
 #define AL_SOFT_bformat_hoa
 #define AL_UNPACK_AMBISONIC_ORDER_SOFT           0x199D
 #endif
 
+#ifndef AL_SOFT_submix_bus
+#define AL_SOFT_submix_bus
+#define AL_SUBMIX_FORMAT_SOFT                    0x19A4
+#define AL_SUBMIX_BUS_SOFT                       0x19A5
+#endif
+
+#ifndef AL_SOFT_source_clusters
+#define AL_SOFT_source_clusters
+#define AL_CLUSTERED_SOURCES_SOFT                0x19A6
+#define AL_ACTIVE_CLUSTERS_SOFT                  0x19A7
+#endif
+
+#ifndef AL_SOFT_source_priority
+#define AL_SOFT_source_priority
+#define AL_SOURCE_PRIORITY_SOFT                  0x19A8
+#endif
+
+#ifndef AL_SOFT_load_governor
+#define AL_SOFT_load_governor
+#define AL_LOAD_GOVERNOR_LEVEL_SOFT              0x19A9
+#endif
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
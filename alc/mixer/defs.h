@@ -1,10 +1,16 @@
 #ifndef MIXER_DEFS_H
 #define MIXER_DEFS_H
 
+#include <cmath>
+#include <cstddef>
+#include <limits>
+
 #include "AL/al.h"
 
 #include "alcmain.h"
 #include "alspan.h"
+#include "alu.h"
+#include "ambidefs.h"
 #include "hrtf.h"
 
 union InterpState;
@@ -19,6 +25,20 @@ template<typename InstTag>
 void Mix_(const al::span<const float> InSamples, const al::span<FloatBufferLine> OutBuffer,
     float *CurrentGains, const float *TargetGains, const size_t Counter, const size_t OutPos);
 
+/* A target for MixMulti_, with the (aligned) input samples to mix into each
+ * line of OutBuffer, and the lines' current and target gains.
+ */
+struct MixTarget {
+    const float *InSamples;
+    al::span<FloatBufferLine> OutBuffer;
+    float *CurrentGains;
+    const float *TargetGains;
+};
+
+template<typename InstTag>
+void MixMulti_(const al::span<const MixTarget> Targets, const size_t BufferSize,
+    const size_t Counter, const size_t OutPos);
+
 template<typename InstTag>
 void MixHrtf_(const float *InSamples, float2 *AccumSamples, const ALuint IrSize,
     const MixHrtfFilter *hrtfparams, const size_t BufferSize);
@@ -44,4 +64,50 @@ inline void InitPosArrays(ALuint frac, ALuint increment, ALuint *frac_arr, ALuin
     }
 }
 
+/* Multi-target mixer helpers */
+struct MixLine {
+    const float *src;
+    float *dst;
+    float gain;
+};
+
+/* The most lines a set of targets can have: the dry output, plus each send's
+ * effect slot output.
+ */
+constexpr size_t MaxMixLines{MAX_OUTPUT_CHANNELS + MAX_SENDS*MAX_AMBI_CHANNELS};
+
+/* Mixes the target lines that are fading gains with the given single-target
+ * mixer, and collects the ones with a steady and audible gain into 'lines'
+ * to be mixed together. Returns the number of lines collected.
+ */
+template<typename InstTag>
+inline size_t PrepareMixLines(const al::span<const MixTarget> Targets, const size_t BufferSize,
+    const size_t Counter, const size_t OutPos, MixLine *lines)
+{
+    const float delta{(Counter > 0) ? 1.0f / static_cast<float>(Counter) : 0.0f};
+    size_t count{0};
+    for(const MixTarget &target : Targets)
+    {
+        float *CurrentGains{target.CurrentGains};
+        const float *TargetGains{target.TargetGains};
+        for(FloatBufferLine &output : target.OutBuffer)
+        {
+            const float step{(*TargetGains - *CurrentGains) * delta};
+            if(std::fabs(step) > std::numeric_limits<float>::epsilon())
+                Mix_<InstTag>({target.InSamples, BufferSize}, {&output, 1}, CurrentGains,
+                    TargetGains, Counter, OutPos);
+            else
+            {
+                const float gain{*TargetGains};
+                *CurrentGains = gain;
+                if(std::fabs(gain) > GAIN_SILENCE_THRESHOLD)
+                    lines[count++] = MixLine{target.InSamples, output.data()+OutPos, gain};
+            }
+            ++CurrentGains;
+            ++TargetGains;
+        }
+    }
+    return count;
+}
+
 #endif /* MIXER_DEFS_H */
@@ -17,6 +17,7 @@ struct LerpTag;
 struct CubicTag;
 struct BSincTag;
 struct FastBSincTag;
+struct PolyBSincTag;
 
 
 namespace {
@@ -66,6 +67,19 @@ inline float do_fastbsinc(const InterpState &istate, const float *RESTRICT vals,
         r += (fil[j_f] + pf*phd[j_f]) * vals[j_f];
     return r;
 }
+inline float do_polybsinc(const InterpState &istate, const float *RESTRICT vals,
+    const ALuint frac)
+{
+    const size_t m{istate.bsinc.m};
+
+    const float *fil{istate.bsinc.polyfilter + (frac>>istate.bsinc.pshift)*istate.bsinc.pstride};
+
+    // Apply the phase-aligned filter.
+    float r{0.0f};
+    for(size_t j_f{0};j_f < m;j_f++)
+        r += fil[j_f] * vals[j_f];
+    return r;
+}
 
 using SamplerT = float(&)(const InterpState&, const float*RESTRICT, const ALuint);
 template<SamplerT Sampler>
@@ -135,6 +149,24 @@ const float *Resample_<FastBSincTag,CTag>(const InterpState *state, const float
     ALuint frac, ALuint increment, const al::span<float> dst)
 { return DoResample<do_fastbsinc>(state, src-state->bsinc.l, frac, increment, dst); }
 
+template<>
+const float *Resample_<PolyBSincTag,CTag>(const InterpState *state, const float *RESTRICT src,
+    ALuint frac, ALuint increment, const al::span<float> dst)
+{
+    /* The step keeps an aligned position aligned, but a voice may still
+     * start between phases (e.g. after a pitch change), so fall back to the
+     * interpolating resampler the filter came from. Filters taken straight
+     * from the table are only used without scale interpolation.
+     */
+    if UNLIKELY((frac&((1u<<state->bsinc.pshift)-1)) != 0)
+    {
+        if(state->bsinc.pshift == FRAC_PHASE_BITDIFF)
+            return Resample_<FastBSincTag,CTag>(state, src, frac, increment, dst);
+        return Resample_<BSincTag,CTag>(state, src, frac, increment, dst);
+    }
+    return DoResample<do_polybsinc>(state, src-state->bsinc.l, frac, increment, dst);
+}
+
 
 template<>
 void MixHrtf_<CTag>(const float *InSamples, float2 *AccumSamples, const ALuint IrSize,
@@ -194,3 +226,24 @@ void Mix_<CTag>(const al::span<const float> InSamples, const al::span<FloatBuffe
             dst[pos] += InSamples[pos] * gain;
     }
 }
+
+template<>
+void MixMulti_<CTag>(const al::span<const MixTarget> Targets, const size_t BufferSize,
+    const size_t Counter, const size_t OutPos)
+{
+    MixLine lines[MaxMixLines];
+    const size_t numlines{PrepareMixLines<CTag>(Targets, BufferSize, Counter, OutPos, lines)};
+
+    /* Mix the steady lines one after another. Interleaving the lines' samples
+     * is slower, since the output lines are all BUFFERSIZE apart and their
+     * loads and stores alias.
+     */
+    for(size_t i{0};i < numlines;++i)
+    {
+        const float *RESTRICT src{lines[i].src};
+        float *RESTRICT dst{lines[i].dst};
+        const float gain{lines[i].gain};
+        for(size_t pos{0};pos < BufferSize;++pos)
+            dst[pos] += src[pos] * gain;
+    }
+}
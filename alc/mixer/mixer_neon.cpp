@@ -17,6 +17,7 @@ struct NEONTag;
 struct LerpTag;
 struct BSincTag;
 struct FastBSincTag;
+struct PolyBSincTag;
 
 
 namespace {
@@ -192,6 +193,49 @@ const float *Resample_<FastBSincTag,NEONTag>(const InterpState *state,
 }
 
 
+template<>
+const float *Resample_<PolyBSincTag,NEONTag>(const InterpState *state,
+    const float *RESTRICT src, ALuint frac, ALuint increment, const al::span<float> dst)
+{
+    const ALuint pshift{state->bsinc.pshift};
+    if UNLIKELY((frac&((1u<<pshift)-1)) != 0)
+    {
+        if(pshift == FRAC_PHASE_BITDIFF)
+            return Resample_<FastBSincTag,NEONTag>(state, src, frac, increment, dst);
+        return Resample_<BSincTag,NEONTag>(state, src, frac, increment, dst);
+    }
+
+    const float *const filter{state->bsinc.polyfilter};
+    const size_t pstride{state->bsinc.pstride};
+    const size_t m{state->bsinc.m};
+
+    src -= state->bsinc.l;
+    for(float &out_sample : dst)
+    {
+        // Apply the phase-aligned filter.
+        float32x4_t r4{vdupq_n_f32(0.0f)};
+        {
+            const float *fil{filter + (frac>>pshift)*pstride};
+            size_t td{m >> 2};
+            size_t j{0u};
+
+            do {
+                /* r += fil*src */
+                r4 = vmlaq_f32(r4, vld1q_f32(&fil[j]), vld1q_f32(&src[j]));
+                j += 4;
+            } while(--td);
+        }
+        r4 = vaddq_f32(r4, vrev64q_f32(r4));
+        out_sample = vget_lane_f32(vadd_f32(vget_low_f32(r4), vget_high_f32(r4)), 0);
+
+        frac += increment;
+        src  += frac>>FRACTIONBITS;
+        frac &= FRACTIONMASK;
+    }
+    return dst.data();
+}
+
+
 template<>
 void MixHrtf_<NEONTag>(const float *InSamples, float2 *AccumSamples, const ALuint IrSize,
     const MixHrtfFilter *hrtfparams, const size_t BufferSize)
@@ -293,3 +337,37 @@ void Mix_<NEONTag>(const al::span<const float> InSamples, const al::span<FloatBu
             dst[pos] += InSamples[pos] * gain;
     }
 }
+
+template<>
+void MixMulti_<NEONTag>(const al::span<const MixTarget> Targets, const size_t BufferSize,
+    const size_t Counter, const size_t OutPos)
+{
+    MixLine lines[MaxMixLines];
+    const size_t numlines{PrepareMixLines<NEONTag>(Targets, BufferSize, Counter, OutPos, lines)};
+
+    /* Mix the steady lines one after another. Interleaving the lines' samples
+     * to share the input loads is slower, since the output lines are all
+     * BUFFERSIZE apart and their loads and stores alias.
+     */
+    for(size_t i{0};i < numlines;++i)
+    {
+        const float *RESTRICT src{lines[i].src};
+        float *RESTRICT dst{lines[i].dst};
+        const float gain{lines[i].gain};
+
+        size_t pos{0};
+        if(size_t todo{BufferSize >> 2})
+        {
+            const float32x4_t gain4{vdupq_n_f32(gain)};
+            do {
+                const float32x4_t val4 = vld1q_f32(&src[pos]);
+                float32x4_t dry4 = vld1q_f32(&dst[pos]);
+                dry4 = vmlaq_f32(dry4, val4, gain4);
+                vst1q_f32(&dst[pos], dry4);
+                pos += 4;
+            } while(--todo);
+        }
+        for(size_t leftover{BufferSize&3};leftover;++pos,--leftover)
+            dst[pos] += src[pos] * gain;
+    }
+}
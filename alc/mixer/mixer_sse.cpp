@@ -16,6 +16,7 @@
 struct SSETag;
 struct BSincTag;
 struct FastBSincTag;
+struct PolyBSincTag;
 
 
 namespace {
@@ -166,6 +167,50 @@ const float *Resample_<FastBSincTag,SSETag>(const InterpState *state, const floa
 }
 
 
+template<>
+const float *Resample_<PolyBSincTag,SSETag>(const InterpState *state, const float *RESTRICT src,
+    ALuint frac, ALuint increment, const al::span<float> dst)
+{
+    const ALuint pshift{state->bsinc.pshift};
+    if UNLIKELY((frac&((1u<<pshift)-1)) != 0)
+    {
+        if(pshift == FRAC_PHASE_BITDIFF)
+            return Resample_<FastBSincTag,SSETag>(state, src, frac, increment, dst);
+        return Resample_<BSincTag,SSETag>(state, src, frac, increment, dst);
+    }
+
+    const float *const filter{state->bsinc.polyfilter};
+    const size_t pstride{state->bsinc.pstride};
+    const size_t m{state->bsinc.m};
+
+    src -= state->bsinc.l;
+    for(float &out_sample : dst)
+    {
+        // Apply the phase-aligned filter.
+        __m128 r4{_mm_setzero_ps()};
+        {
+            const float *fil{filter + (frac>>pshift)*pstride};
+            size_t td{m >> 2};
+            size_t j{0u};
+
+            do {
+                /* r += fil*src */
+                r4 = MLA4(r4, _mm_load_ps(&fil[j]), _mm_loadu_ps(&src[j]));
+                j += 4;
+            } while(--td);
+        }
+        r4 = _mm_add_ps(r4, _mm_shuffle_ps(r4, r4, _MM_SHUFFLE(0, 1, 2, 3)));
+        r4 = _mm_add_ps(r4, _mm_movehl_ps(r4, r4));
+        out_sample = _mm_cvtss_f32(r4);
+
+        frac += increment;
+        src  += frac>>FRACTIONBITS;
+        frac &= FRACTIONMASK;
+    }
+    return dst.data();
+}
+
+
 template<>
 void MixHrtf_<SSETag>(const float *InSamples, float2 *AccumSamples, const ALuint IrSize,
     const MixHrtfFilter *hrtfparams, const size_t BufferSize)
@@ -266,3 +311,37 @@ void Mix_<SSETag>(const al::span<const float> InSamples, const al::span<FloatBuf
             dst[pos] += InSamples[pos] * gain;
     }
 }
+
+template<>
+void MixMulti_<SSETag>(const al::span<const MixTarget> Targets, const size_t BufferSize,
+    const size_t Counter, const size_t OutPos)
+{
+    MixLine lines[MaxMixLines];
+    const size_t numlines{PrepareMixLines<SSETag>(Targets, BufferSize, Counter, OutPos, lines)};
+
+    /* Mix the steady lines one after another. Interleaving the lines' samples
+     * to share the input loads is slower, since the output lines are all
+     * BUFFERSIZE apart and their loads and stores alias.
+     */
+    for(size_t i{0};i < numlines;++i)
+    {
+        const float *RESTRICT src{al::assume_aligned<16>(lines[i].src)};
+        float *RESTRICT dst{al::assume_aligned<16>(lines[i].dst)};
+        const float gain{lines[i].gain};
+
+        size_t pos{0};
+        if(size_t todo{BufferSize >> 2})
+        {
+            const __m128 gain4{_mm_set1_ps(gain)};
+            do {
+                const __m128 val4{_mm_load_ps(&src[pos])};
+                __m128 dry4{_mm_load_ps(&dst[pos])};
+                dry4 = _mm_add_ps(dry4, _mm_mul_ps(val4, gain4));
+                _mm_store_ps(&dst[pos], dry4);
+                pos += 4;
+            } while(--todo);
+        }
+        for(size_t leftover{BufferSize&3};leftover;++pos,--leftover)
+            dst[pos] += src[pos] * gain;
+    }
+}
@@ -0,0 +1,26 @@
+
+#include "config.h"
+
+#include "oscillator.h"
+
+#include <cmath>
+
+#include "math_defs.h"
+
+
+namespace {
+
+std::array<float,SINETABLE_SIZE+1> GenerateSineTable()
+{
+    std::array<float,SINETABLE_SIZE+1> ret{};
+    for(size_t i{0};i < ret.size();++i)
+    {
+        const double phase{static_cast<double>(i) / double{SINETABLE_SIZE}};
+        ret[i] = static_cast<float>(std::sin(phase * al::MathDefs<double>::Tau()));
+    }
+    return ret;
+}
+
+} // namespace
+
+const std::array<float,SINETABLE_SIZE+1> gSineTable{GenerateSineTable()};
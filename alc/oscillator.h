@@ -0,0 +1,94 @@
+#ifndef OSCILLATOR_H
+#define OSCILLATOR_H
+
+#include <array>
+#include <cstddef>
+
+#include "AL/al.h"
+
+#include "alnumeric.h"
+#include "alu.h"
+#include "math_defs.h"
+#include "opthelpers.h"
+
+
+/* Phase accumulators for the effect LFOs hold a fractional cycle, with
+ * WAVEFORM_FRACONE being one full cycle.
+ */
+#define WAVEFORM_FRACBITS  24
+#define WAVEFORM_FRACONE   (1<<WAVEFORM_FRACBITS)
+#define WAVEFORM_FRACMASK  (WAVEFORM_FRACONE-1)
+
+/* One cycle of a sine wave, with an extra point at the end so lookups can
+ * interpolate across the wrap-around. The table is small enough to stay in
+ * cache, and linear interpolation keeps the error under 5e-6.
+ */
+#define SINETABLE_BITS  10
+#define SINETABLE_SIZE  (1<<SINETABLE_BITS)
+
+extern const std::array<float,SINETABLE_SIZE+1> gSineTable;
+
+
+/** Returns sin(2*pi*phase), for a phase given in cycles, 0 <= phase <= 1. */
+inline float SinCycle(float phase) noexcept
+{
+    const float pos{phase * float{SINETABLE_SIZE}};
+    const ALuint idx{minu(float2uint(pos), SINETABLE_SIZE-1)};
+    return lerp(gSineTable[idx], gSineTable[idx+1], pos - static_cast<float>(idx));
+}
+
+/**
+ * Calculates sin(2*pi*phase) and cos(2*pi*phase) together, for a phase given
+ * in cycles, 0 <= phase <= 1. This uses polynomials over a quarter-cycle
+ * centered on 0, which keeps it accurate to float precision (including cos
+ * close to 1, which filter coefficients are sensitive to).
+ */
+inline void SinCosCycle(float phase, float &sinout, float &cosout) noexcept
+{
+    const ALuint quadrant{float2uint(phase*4.0f + 0.5f)};
+    const float x{(phase - static_cast<float>(quadrant)*0.25f) * al::MathDefs<float>::Tau()};
+    const float x2{x*x};
+
+    const float s{x*(1.0f - x2*(1.0f/6.0f - x2*(1.0f/120.0f - x2*(1.0f/5040.0f))))};
+    const float c{1.0f - x2*(0.5f - x2*(1.0f/24.0f - x2*(1.0f/720.0f - x2*(1.0f/40320.0f))))};
+    switch(quadrant&3)
+    {
+    case 0: sinout =  s; cosout =  c; break;
+    case 1: sinout =  c; cosout = -s; break;
+    case 2: sinout = -s; cosout = -c; break;
+    case 3: sinout = -c; cosout =  s; break;
+    }
+}
+
+/* Bipolar waveforms for a WAVEFORM_FRACBITS fixed-point phase index. */
+inline float WaveSin(ALuint index) noexcept
+{
+    constexpr ALuint fracbits{WAVEFORM_FRACBITS - SINETABLE_BITS};
+    constexpr float fracscale{1.0f / float{1<<fracbits}};
+    const ALuint idx{index >> fracbits};
+    const float frac{static_cast<float>(index & ((1u<<fracbits)-1)) * fracscale};
+    return lerp(gSineTable[idx], gSineTable[idx+1], frac);
+}
+
+inline float WaveSaw(ALuint index) noexcept
+{ return static_cast<float>(index)*(2.0f/WAVEFORM_FRACONE) - 1.0f; }
+
+inline float WaveSquare(ALuint index) noexcept
+{ return static_cast<float>(static_cast<int>((index>>(WAVEFORM_FRACBITS-2))&2) - 1); }
+
+/**
+ * Fills dst with todo samples of the given waveform, advancing the phase
+ * index by step before each sample.
+ */
+template<float (&func)(ALuint)>
+void GenerateWave(float *RESTRICT dst, ALuint index, const ALuint step, const size_t todo)
+{
+    for(size_t i{0u};i < todo;i++)
+    {
+        index += step;
+        index &= WAVEFORM_FRACMASK;
+        dst[i] = func(index);
+    }
+}
+
+#endif /* OSCILLATOR_H */
@@ -791,6 +791,34 @@ void InitHrtfPanning(ALCdevice *device)
             ambi_order = iter->order;
         }
     }
+    device->mHrtfInterpolate = false;
+    if(auto transopt = ConfigValueStr(device->DeviceName.c_str(), nullptr, "hrtf-transition"))
+    {
+        const char *transition{transopt->c_str()};
+        if(al::strcasecmp(transition, "interpolate") == 0)
+            device->mHrtfInterpolate = true;
+        else if(al::strcasecmp(transition, "blend") != 0)
+            ERR("Unexpected hrtf-transition: %s\n", transition);
+    }
+    if(device->mRenderMode == HrtfRender)
+    {
+        const char *devname{device->DeviceName.c_str()};
+        const ALuint cachesize{minu(65536u,
+            ConfigValueUInt(devname, nullptr, "hrtf-cache-size").value_or(0u))};
+        if(cachesize > 0)
+        {
+            float resolution{ConfigValueFloat(devname, nullptr, "hrtf-cache-resolution")
+                .value_or(1.0f)};
+            if(!(resolution >= 0.1f && resolution <= 10.0f))
+            {
+                ERR("Invalid hrtf-cache-resolution: %f\n", resolution);
+                resolution = 1.0f;
+            }
+            device->mHrtfCache = HrtfCoeffCache::Create(cachesize, resolution);
+            TRACE("HRTF coefficient cache enabled, %u entries at %.2f degrees\n", cachesize,
+                resolution);
+        }
+    }
     TRACE("%u%s order %sHRTF rendering enabled, using \"%s\"\n", ambi_order,
         (((ambi_order%100)/10) == 1) ? "th" :
         ((ambi_order%10) == 1) ? "st" :
@@ -849,6 +877,7 @@ void aluInitRenderer(ALCdevice *device, int hrtf_id, HrtfRequestMode hrtf_appreq
     HrtfStorePtr old_hrtf{std::move(device->mHrtf)};
 
     device->mHrtfState = nullptr;
+    device->mHrtfCache = nullptr;
     device->mHrtf = nullptr;
     device->HrtfName.clear();
     device->mRenderMode = NormalRender;
@@ -1021,8 +1050,20 @@ no_hrtf:
     }
     if(device->mRenderMode == NormalRender)
     {
-        device->Uhj_Encoder = std::make_unique<Uhj2Encoder>();
-        TRACE("UHJ enabled\n");
+        bool use_iir{false};
+        if(auto filteropt = ConfigValueStr(device->DeviceName.c_str(), "uhj", "encode-filter"))
+        {
+            const char *filter{filteropt->c_str()};
+            if(al::strcasecmp(filter, "iir") == 0)
+                use_iir = true;
+            else if(al::strcasecmp(filter, "fir") != 0)
+                ERR("Unexpected uhj encode-filter: %s\n", filter);
+        }
+        if(use_iir)
+            device->Uhj_Encoder = std::make_unique<Uhj2EncoderIIR>();
+        else
+            device->Uhj_Encoder = std::make_unique<Uhj2Encoder>();
+        TRACE("UHJ enabled (%s filter)\n", use_iir ? "IIR" : "FIR");
         InitUhjPanning(device);
         device->PostProcess = &ALCdevice::ProcessUhj;
         return;
@@ -1046,7 +1087,8 @@ void aluInitEffectPanning(ALeffectslot *slot, ALCdevice *device)
         { return BFChannelConfig{1.0f, acn}; }
     );
     std::fill(iter, slot->Wet.AmbiMap.end(), BFChannelConfig{});
-    slot->Wet.Buffer = {slot->MixBuffer.data(), slot->MixBuffer.size()};
+    const size_t numwet{minz(AmbiChannelsFromOrder(slot->Params.InputOrder), count)};
+    slot->Wet.Buffer = {slot->MixBuffer.data(), numwet};
 }
 
 
@@ -1148,7 +1190,7 @@ std::array<float,MAX_AMBI_CHANNELS> CalcAmbiCoeffs(const float y, const float z,
 }
 
 void ComputePanGains(const MixParams *mix, const float*RESTRICT coeffs, const float ingain,
-    const al::span<float,MAX_OUTPUT_CHANNELS> gains)
+    const al::span<float> gains)
 {
     auto ambimap = mix->AmbiMap.cbegin();
 
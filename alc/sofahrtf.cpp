@@ -0,0 +1,865 @@
+/**
+ * OpenAL cross platform audio library
+ * Copyright (C) 2020 by authors.
+ * This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ *  License along with this library; if not, write to the
+ *  Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ * Or go to http://www.gnu.org/copyleft/lgpl.html
+ */
+
+#include "config.h"
+
+#include "sofahrtf.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <sstream>
+#include <system_error>
+#include <thread>
+#include <utility>
+
+#include "AL/al.h"
+
+#include "mysofa.h"
+
+#include "alcomplex.h"
+#include "alconfig.h"
+#include "alfstream.h"
+#include "almalloc.h"
+#include "alnumeric.h"
+#include "aloptional.h"
+#include "alspan.h"
+#include "hrtf.h"
+#include "logging.h"
+#include "math_defs.h"
+#include "polyphase_resampler.h"
+#include "strutils.h"
+#include "vector.h"
+
+#ifdef _WIN32
+#include <direct.h>
+#include <shlobj.h>
+#endif
+#include <sys/types.h>
+#include <sys/stat.h>
+
+
+namespace {
+
+using double3 = std::array<double,3>;
+
+/* These must be within the limits accepted by the v3 loader. */
+#define MAX_FD_COUNT                 (16)
+
+#define MIN_FD_DISTANCE              (50)
+#define MAX_FD_DISTANCE              (2500)
+
+#define MIN_EV_COUNT                 (5)
+#define MAX_EV_COUNT                 (181)
+
+#define MAX_AZ_COUNT                 (255)
+
+#define MAX_HRIR_DELAY               (HRTF_HISTORY_LENGTH-1)
+#define HRIR_DELAY_FRACONE           (4)
+
+/* Bump this when the conversion changes, so older cache files get replaced. */
+constexpr ALubyte ConversionVersion{1};
+
+/* The truncated minimum-phase response length at 44.1khz, which is scaled
+ * for other rates.
+ */
+constexpr ALuint BaseIrSize{32};
+
+/* The response onsets are measured at 10x the sample rate. */
+constexpr ALuint OnsetRateMultiple{10};
+
+constexpr ALuint MinFftSize{8192};
+constexpr double Epsilon{1e-9};
+
+/* Angles within this many degrees are considered the same. */
+constexpr double AngleEpsilon{0.1};
+
+constexpr char MagicMarker[8]{'M','i','n','P','H','R','0','3'};
+
+constexpr double DegToRad(double x) noexcept { return x * (al::MathDefs<double>::Pi()/180.0); }
+constexpr double RadToDeg(double x) noexcept { return x * (180.0/al::MathDefs<double>::Pi()); }
+
+
+struct MySofaDeleter {
+    void operator()(MYSOFA_HRTF *sofa) { mysofa_free(sofa); }
+};
+using MySofaHrtfPtr = std::unique_ptr<MYSOFA_HRTF,MySofaDeleter>;
+
+/* A measurement's direction as a unit vector (+X front, +Y left, +Z up), and
+ * its elevation and clockwise azimuth in degrees.
+ */
+struct Measurement {
+    double3 mDir;
+    double mElev;
+    double mAzim;
+};
+
+struct SofaField {
+    ALushort mDistance; /* In millimeters. */
+    al::vector<ALuint> mMeasures;
+    al::vector<ALubyte> mAzCounts;
+};
+
+
+/* Returns the smallest number of steps that uniformly divides the given range
+ * and has every value on a step, or 0 if there's none between mincount and
+ * maxcount.
+ */
+ALuint GetUniformCount(const al::vector<double> &values, const double range, const ALuint mincount,
+    const ALuint maxcount)
+{
+    for(ALuint count{mincount};count <= maxcount;++count)
+    {
+        const double step{range / count};
+        auto off_step = [step](const double value) -> bool
+        { return std::abs(value - std::round(value/step)*step) > AngleEpsilon; };
+        if(std::none_of(values.cbegin(), values.cend(), off_step))
+            return count;
+    }
+    return 0;
+}
+
+/* Works out an elevation and azimuth layout for the field's measurements. If
+ * the measurements are on a uniform grid, that grid is used as is. Otherwise
+ * the step size is picked to roughly match the measurement density. Directions
+ * without a measurement are later filled in using the nearest one.
+ */
+void CalcFieldLayout(const al::vector<Measurement> &measures, SofaField &field)
+{
+    al::vector<double> values;
+    values.reserve(field.mMeasures.size());
+    for(ALuint mi : field.mMeasures)
+        values.emplace_back(measures[mi].mElev + 90.0);
+
+    ALuint evCount{GetUniformCount(values, 180.0, MIN_EV_COUNT-1, MAX_EV_COUNT-1)};
+    if(evCount == 0)
+    {
+        /* A sphere's surface is about 41253 square degrees. */
+        const double spacing{std::sqrt(41253.0 / static_cast<double>(field.mMeasures.size()))};
+        evCount = static_cast<ALuint>(clampd(std::round(180.0/spacing), MIN_EV_COUNT-1,
+            MAX_EV_COUNT-1));
+    }
+    const double evStep{180.0 / evCount};
+    ++evCount;
+
+    field.mAzCounts.resize(evCount);
+    field.mAzCounts.front() = 1;
+    field.mAzCounts.back() = 1;
+    for(ALuint ei{1};ei < evCount-1;++ei)
+    {
+        const double elev{-90.0 + ei*evStep};
+
+        values.clear();
+        for(ALuint mi : field.mMeasures)
+        {
+            if(std::abs(measures[mi].mElev - elev) <= AngleEpsilon)
+                values.emplace_back(measures[mi].mAzim);
+        }
+
+        ALuint azCount{values.empty() ? 0u : GetUniformCount(values, 360.0, 1, MAX_AZ_COUNT)};
+        if(azCount == 0)
+        {
+            const double ringSize{360.0 * std::cos(DegToRad(elev))};
+            azCount = static_cast<ALuint>(clampd(std::round(ringSize/evStep), 1.0, MAX_AZ_COUNT));
+        }
+        field.mAzCounts[ei] = static_cast<ALubyte>(azCount);
+    }
+}
+
+/* Finds the field measurement nearest each of its layout's directions. */
+void MapFieldResponses(const al::vector<Measurement> &measures, const SofaField &field,
+    al::vector<ALuint> &irMeasures)
+{
+    const size_t evCount{field.mAzCounts.size()};
+    const double evStep{180.0 / static_cast<double>(evCount-1)};
+    for(size_t ei{0};ei < evCount;++ei)
+    {
+        const double elev{DegToRad(-90.0 + static_cast<double>(ei)*evStep)};
+        const ALuint azCount{field.mAzCounts[ei]};
+        for(ALuint ai{0};ai < azCount;++ai)
+        {
+            /* Layout azimuths go clockwise, while the vector's Y goes left. */
+            const double azim{DegToRad(360.0 * ai / azCount)};
+            const double3 dir{{std::cos(elev)*std::cos(azim), -std::cos(elev)*std::sin(azim),
+                std::sin(elev)}};
+
+            ALuint nearest{field.mMeasures.front()};
+            double nearestDot{-2.0};
+            for(ALuint mi : field.mMeasures)
+            {
+                const double3 &mdir = measures[mi].mDir;
+                const double dot{dir[0]*mdir[0] + dir[1]*mdir[1] + dir[2]*mdir[2]};
+                if(dot > nearestDot)
+                {
+                    nearest = mi;
+                    nearestDot = dot;
+                }
+            }
+            irMeasures.emplace_back(nearest);
+        }
+    }
+}
+
+
+/* The per-thread state for converting responses. */
+class ResponseProcessor {
+    const MYSOFA_HRTF *mSofa;
+    const ALuint mSrcRate;
+    const ALuint mRate;
+    const ALuint mIrSize;
+
+    ALuint mPoints;
+    PPhaseResampler mResampler;
+    PPhaseResampler mUpsampler;
+    al::vector<double> mInput;
+    al::vector<double> mResampled;
+    al::vector<double> mUpsampled;
+    al::vector<double> mMags;
+    al::vector<std::complex<double>> mFftBuffer;
+
+    double calcOnset(const double *ir);
+    void calcMinimumPhase(const double *ir, double *out);
+
+public:
+    ResponseProcessor(const MYSOFA_HRTF *sofa, const ALuint srcrate, const ALuint rate,
+        const ALuint irsize);
+
+    /* Writes the minimum-phase response of the measurement's receiver to out,
+     * and returns the onset in samples (at the output rate).
+     */
+    double process(const ALuint measure, const ALuint receiver, double *out);
+};
+
+ResponseProcessor::ResponseProcessor(const MYSOFA_HRTF *sofa, const ALuint srcrate,
+    const ALuint rate, const ALuint irsize)
+  : mSofa{sofa}, mSrcRate{srcrate}, mRate{rate}, mIrSize{irsize}
+{
+    mPoints = mSofa->N;
+    if(mSrcRate != mRate)
+    {
+        mPoints = static_cast<ALuint>((uint64_t{mSofa->N}*mRate + mSrcRate-1) / mSrcRate);
+        mResampler.init(mSrcRate, mRate);
+        mInput.resize(mSofa->N);
+    }
+    mUpsampler.init(mRate, mRate*OnsetRateMultiple);
+
+    const ALuint fftsize{maxu(MinFftSize, NextPowerOf2(mPoints*4))};
+    mResampled.resize(mPoints);
+    mUpsampled.resize(size_t{mPoints}*OnsetRateMultiple);
+    mMags.resize(fftsize);
+    mFftBuffer.resize(fftsize);
+}
+
+double ResponseProcessor::calcOnset(const double *ir)
+{
+    mUpsampler.process(mPoints, ir, static_cast<ALuint>(mUpsampled.size()), mUpsampled.data());
+    auto peak = std::max_element(mUpsampled.cbegin(), mUpsampled.cend(),
+        [](const double a, const double b) -> bool { return std::abs(a) < std::abs(b); });
+    return static_cast<double>(std::distance(mUpsampled.cbegin(), peak)) / OnsetRateMultiple;
+}
+
+/* Reconstructs the response with the same magnitude response and a minimum
+ * phase, using the Hilbert transform of the log magnitudes, so its delay is
+ * left to be applied separately.
+ */
+void ResponseProcessor::calcMinimumPhase(const double *ir, double *out)
+{
+    const size_t n{mFftBuffer.size()};
+    const size_t m{n/2 + 1};
+
+    auto iter = std::transform(ir, ir+mPoints, mFftBuffer.begin(),
+        [](const double s) noexcept -> std::complex<double> { return {s, 0.0}; });
+    std::fill(iter, mFftBuffer.end(), std::complex<double>{});
+    complex_fft(mFftBuffer, -1.0);
+
+    size_t i{0};
+    for(;i < m;++i)
+    {
+        mMags[i] = maxd(std::abs(mFftBuffer[i]), Epsilon);
+        mFftBuffer[i] = std::complex<double>{std::log(mMags[i]), 0.0};
+    }
+    for(;i < n;++i)
+    {
+        mMags[i] = mMags[n - i];
+        mFftBuffer[i] = mFftBuffer[n - i];
+    }
+    complex_hilbert(mFftBuffer);
+
+    /* Remove any DC offset the filter has. */
+    mMags[0] = Epsilon;
+    for(i = 0;i < n;++i)
+        mFftBuffer[i] = std::polar(mMags[i], mFftBuffer[i].imag());
+    complex_fft(mFftBuffer, 1.0);
+
+    const double scale{1.0 / static_cast<double>(n)};
+    for(i = 0;i < mIrSize;++i)
+        out[i] = mFftBuffer[i].real() * scale;
+}
+
+double ResponseProcessor::process(const ALuint measure, const ALuint receiver, double *out)
+{
+    const ALuint channel{measure*mSofa->R + receiver};
+    const float *ir{&mSofa->DataIR.values[size_t{channel}*mSofa->N]};
+    if(mSrcRate == mRate)
+        std::copy_n(ir, mPoints, mResampled.begin());
+    else
+    {
+        std::copy_n(ir, mSofa->N, mInput.begin());
+        mResampler.process(mSofa->N, mInput.data(), mPoints, mResampled.data());
+    }
+
+    double onset{calcOnset(mResampled.data())};
+    calcMinimumPhase(mResampled.data(), out);
+
+    /* Include any delay that was removed from the measured response. */
+    const MYSOFA_ARRAY &delays = mSofa->DataDelay;
+    if(delays.elements >= size_t{mSofa->M}*mSofa->R)
+        onset += double{delays.values[channel]} * mRate / mSrcRate;
+    else if(delays.elements >= mSofa->R)
+        onset += double{delays.values[receiver]} * mRate / mSrcRate;
+    return onset;
+}
+
+
+/* Converts the SOFA data set to v3 HRTF data at the given rate. Returns an
+ * empty string on failure.
+ */
+std::string ConvertSofa(const std::string &filename, const ALuint rate)
+{
+    int err{MYSOFA_OK};
+    MySofaHrtfPtr sofa{mysofa_load(filename.c_str(), &err)};
+    if(!sofa)
+    {
+        ERR("Failed to load %s: error %d\n", filename.c_str(), err);
+        return {};
+    }
+    if((err=mysofa_check(sofa.get())) != MYSOFA_OK)
+    {
+        ERR("Invalid SOFA data in %s: error %d\n", filename.c_str(), err);
+        return {};
+    }
+    mysofa_tocartesian(sofa.get());
+
+    if(sofa->E != 1)
+    {
+        ERR("Unsupported emitter count in %s: %u\n", filename.c_str(), sofa->E);
+        return {};
+    }
+    if(sofa->R < 1 || sofa->R > 2)
+    {
+        ERR("Unsupported receiver count in %s: %u\n", filename.c_str(), sofa->R);
+        return {};
+    }
+    if(sofa->M < 1 || sofa->N < 1)
+    {
+        ERR("No responses in %s\n", filename.c_str());
+        return {};
+    }
+    if(sofa->DataSamplingRate.elements < 1 || !(sofa->DataSamplingRate.values[0] >= 1000.0f)
+        || !(sofa->DataSamplingRate.values[0] <= 384000.0f))
+    {
+        ERR("Unsupported sample rate in %s\n", filename.c_str());
+        return {};
+    }
+    const auto srcRate = static_cast<ALuint>(std::round(sofa->DataSamplingRate.values[0]));
+    const ALuint channels{sofa->R};
+
+    /* Group the measurements into fields, by distance in millimeters. */
+    auto measures = al::vector<Measurement>(sofa->M);
+    auto distances = al::vector<ALushort>(sofa->M);
+    for(ALuint mi{0};mi < sofa->M;++mi)
+    {
+        const float *xyz{&sofa->SourcePosition.values[mi*3]};
+        const double dist{std::sqrt(double{xyz[0]}*xyz[0] + double{xyz[1]}*xyz[1] +
+            double{xyz[2]}*xyz[2])};
+        if(!(dist > 0.0))
+        {
+            ERR("Invalid source position in %s\n", filename.c_str());
+            return {};
+        }
+
+        Measurement &measure = measures[mi];
+        measure.mDir = {{xyz[0]/dist, xyz[1]/dist, xyz[2]/dist}};
+        measure.mElev = RadToDeg(std::asin(clampd(measure.mDir[2], -1.0, 1.0)));
+        measure.mAzim = std::fmod(360.0 - RadToDeg(std::atan2(measure.mDir[1], measure.mDir[0])),
+            360.0);
+        if(std::abs(measure.mElev) >= 90.0-AngleEpsilon)
+            measure.mAzim = 0.0;
+        distances[mi] = static_cast<ALushort>(clampd(std::round(dist*1000.0), MIN_FD_DISTANCE,
+            MAX_FD_DISTANCE));
+    }
+
+    al::vector<SofaField> fields;
+    for(ALuint mi{0};mi < sofa->M;++mi)
+    {
+        auto field = std::find_if(fields.begin(), fields.end(),
+            [dist=distances[mi]](const SofaField &fd) noexcept -> bool
+            { return fd.mDistance == dist; });
+        if(field == fields.end())
+        {
+            fields.emplace_back();
+            field = fields.end() - 1;
+            field->mDistance = distances[mi];
+        }
+        field->mMeasures.emplace_back(mi);
+    }
+    if(fields.size() > MAX_FD_COUNT)
+    {
+        WARN("Too many field distances in %s (%zu), keeping the %d largest\n", filename.c_str(),
+            fields.size(), MAX_FD_COUNT);
+        std::stable_sort(fields.begin(), fields.end(),
+            [](const SofaField &lhs, const SofaField &rhs) noexcept -> bool
+            { return lhs.mMeasures.size() > rhs.mMeasures.size(); });
+        fields.resize(MAX_FD_COUNT);
+    }
+    /* Fields are stored farthest first. */
+    std::sort(fields.begin(), fields.end(),
+        [](const SofaField &lhs, const SofaField &rhs) noexcept -> bool
+        { return lhs.mDistance > rhs.mDistance; });
+
+    al::vector<ALuint> irMeasures;
+    for(SofaField &field : fields)
+    {
+        CalcFieldLayout(measures, field);
+        MapFieldResponses(measures, field, irMeasures);
+    }
+    if(irMeasures.size() > std::numeric_limits<ALushort>::max())
+    {
+        ERR("Too many responses in %s layout (%zu)\n", filename.c_str(), irMeasures.size());
+        return {};
+    }
+
+    /* Only convert the measurements that are actually used. */
+    al::vector<ALuint> todo{irMeasures};
+    std::sort(todo.begin(), todo.end());
+    todo.erase(std::unique(todo.begin(), todo.end()), todo.end());
+
+    const ALuint irSize{clampu(static_cast<ALuint>(RoundUp(BaseIrSize*rate/44100u, 8)),
+        MIN_IR_LENGTH, HRIR_LENGTH)};
+    auto coeffs = al::vector<double>(todo.size()*channels*irSize);
+    auto onsets = al::vector<double>(todo.size()*channels);
+
+    TRACE("Converting %zu SOFA responses (%uhz -> %uhz, %u points -> %u)...\n", todo.size(),
+        srcRate, rate, sofa->N, irSize);
+
+    /* Each thread gets its own resamplers and FFT buffers, and takes the next
+     * response to convert until all are done.
+     */
+    std::atomic<size_t> nextTodo{0u};
+    auto converter = [&sofa,srcRate,rate,irSize,channels,&todo,&nextTodo,&coeffs,&onsets]()
+    {
+        ResponseProcessor proc{sofa.get(), srcRate, rate, irSize};
+        size_t idx;
+        while((idx=nextTodo.fetch_add(1u, std::memory_order_relaxed)) < todo.size())
+        {
+            for(ALuint c{0};c < channels;++c)
+            {
+                const size_t ch{idx*channels + c};
+                onsets[ch] = proc.process(todo[idx], c, &coeffs[ch*irSize]);
+            }
+        }
+    };
+
+    const size_t numThreads{minz(maxu(std::thread::hardware_concurrency(), 1u), todo.size())};
+    al::vector<std::thread> threads;
+    threads.reserve(numThreads-1);
+    try {
+        while(threads.size() < numThreads-1)
+            threads.emplace_back(converter);
+    }
+    catch(std::system_error &e) {
+        WARN("Failed to start conversion thread: %s\n", e.what());
+    }
+    converter();
+    for(auto &thrd : threads)
+        thrd.join();
+
+    /* Normalize using the maximum RMS of the responses, relative to an impulse
+     * of the same length, while making sure none of them clip.
+     */
+    double maxAmp{0.0}, maxRms{0.0};
+    for(size_t ch{0};ch < onsets.size();++ch)
+    {
+        const double *ir{&coeffs[ch*irSize]};
+        double sum{0.0};
+        for(ALuint i{0};i < irSize;++i)
+        {
+            maxAmp = maxd(maxAmp, std::abs(ir[i]));
+            sum += ir[i]*ir[i];
+        }
+        maxRms = maxd(maxRms, std::sqrt(sum / irSize));
+    }
+    double normScale{1.0};
+    if(maxRms > 0.0)
+        normScale = mind(std::sqrt(1.0 / irSize) / maxRms, 0.99 / maxAmp);
+
+    auto slot_of = [&todo](const ALuint measure) -> size_t
+    {
+        return static_cast<size_t>(std::distance(todo.cbegin(),
+            std::lower_bound(todo.cbegin(), todo.cend(), measure)));
+    };
+
+    /* Get each field's delays relative to its earliest onset, and scale them
+     * down if the largest doesn't fit.
+     */
+    auto delays = al::vector<double>(irMeasures.size()*channels);
+    double maxDelay{0.0};
+    size_t irBase{0};
+    for(const SofaField &field : fields)
+    {
+        const size_t irCount{std::accumulate(field.mAzCounts.cbegin(), field.mAzCounts.cend(),
+            size_t{0})};
+
+        double minOnset{std::numeric_limits<double>::infinity()};
+        for(size_t i{irBase};i < irBase+irCount;++i)
+        {
+            const size_t slot{slot_of(irMeasures[i])};
+            for(ALuint c{0};c < channels;++c)
+                minOnset = mind(minOnset, onsets[slot*channels + c]);
+        }
+        for(size_t i{irBase};i < irBase+irCount;++i)
+        {
+            const size_t slot{slot_of(irMeasures[i])};
+            for(ALuint c{0};c < channels;++c)
+            {
+                const double delay{onsets[slot*channels + c] - minOnset};
+                delays[i*channels + c] = delay;
+                maxDelay = maxd(maxDelay, delay);
+            }
+        }
+        irBase += irCount;
+    }
+    double delayScale{HRIR_DELAY_FRACONE};
+    if(maxDelay > MAX_HRIR_DELAY)
+    {
+        WARN("Delay exceeds max (%.2f > %d), scaling to fit\n", maxDelay, MAX_HRIR_DELAY);
+        delayScale *= MAX_HRIR_DELAY / maxDelay;
+    }
+
+    /* Write the data set. */
+    std::string output;
+    output.reserve(16 + fields.size()*(3+MAX_EV_COUNT) + irMeasures.size()*channels*(irSize*3+1));
+    auto write_le = [&output](ALuint value, ALuint bytes) -> void
+    {
+        for(;bytes > 0;--bytes)
+        {
+            output += static_cast<char>(value&0xff);
+            value >>= 8;
+        }
+    };
+
+    output.append(MagicMarker, sizeof(MagicMarker));
+    write_le(rate, 4);
+    write_le(channels-1, 1);
+    write_le(irSize, 1);
+    write_le(static_cast<ALuint>(fields.size()), 1);
+    for(const SofaField &field : fields)
+    {
+        write_le(field.mDistance, 2);
+        write_le(static_cast<ALuint>(field.mAzCounts.size()), 1);
+        for(ALubyte azCount : field.mAzCounts)
+            write_le(azCount, 1);
+    }
+    for(ALuint measure : irMeasures)
+    {
+        const double *ir{&coeffs[slot_of(measure)*channels*irSize]};
+        for(ALuint i{0};i < irSize;++i)
+        {
+            for(ALuint c{0};c < channels;++c)
+            {
+                const double sample{std::round(ir[c*irSize + i]*normScale * 8388608.0)};
+                const auto value = static_cast<int>(clampd(sample, -8388608.0, 8388607.0));
+                write_le(static_cast<ALuint>(value), 3);
+            }
+        }
+    }
+    for(double delay : delays)
+        write_le(static_cast<ALuint>(double2int(delay*delayScale + 0.5)), 1);
+
+    return output;
+}
+
+
+/* Adds the bytes to an FNV-1a hash. */
+uint64_t HashBytes(uint64_t hash, const char *data, const size_t len)
+{
+    for(size_t i{0};i < len;++i)
+        hash = (hash ^ static_cast<unsigned char>(data[i])) * 0x100000001b3_u64;
+    return hash;
+}
+
+/* Hashes the file contents, for identifying cached conversions. */
+al::optional<uint64_t> HashFile(const std::string &filename)
+{
+    al::ifstream file{filename.c_str(), std::ios::binary};
+    if(!file.is_open())
+        return al::nullopt;
+
+    uint64_t hash{0xcbf29ce484222325_u64 ^ ConversionVersion};
+    std::array<char,65536> buffer;
+    do {
+        file.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        hash = HashBytes(hash, buffer.data(), static_cast<size_t>(file.gcount()));
+    } while(file);
+    return al::make_optional(hash);
+}
+
+/* Hashes the file's path, size, and modification time. This is much cheaper
+ * than hashing the contents, and is used to look up the contents hash of a
+ * file that was converted before.
+ */
+al::optional<uint64_t> GetFileKey(const std::string &filename)
+{
+#ifdef _WIN32
+    struct _stat64 st{};
+    if(_wstat64(utf8_to_wstr(filename.c_str()).c_str(), &st) != 0)
+        return al::nullopt;
+#else
+    struct stat st{};
+    if(stat(filename.c_str(), &st) != 0)
+        return al::nullopt;
+#endif
+    const uint64_t vals[2]{static_cast<uint64_t>(st.st_size), static_cast<uint64_t>(st.st_mtime)};
+
+    uint64_t hash{0xcbf29ce484222325_u64 ^ ConversionVersion};
+    hash = HashBytes(hash, filename.data(), filename.size());
+    hash = HashBytes(hash, reinterpret_cast<const char*>(vals), sizeof(vals));
+    return al::make_optional(hash);
+}
+
+/* Gets the cache directory, creating it as needed. Returns an empty string if
+ * there's no usable cache directory.
+ */
+std::string GetCacheDir(const char *devname)
+{
+#ifdef _WIN32
+    constexpr char slash{'\\'};
+#else
+    constexpr char slash{'/'};
+#endif
+
+    std::string path;
+    if(auto pathopt = ConfigValueStr(devname, nullptr, "hrtf-sofa-cache"))
+        path = std::move(*pathopt);
+    else
+    {
+#ifdef _WIN32
+        WCHAR buffer[MAX_PATH];
+        if(SHGetSpecialFolderPathW(nullptr, buffer, CSIDL_LOCAL_APPDATA, FALSE) == FALSE)
+            return std::string{};
+        path = wstr_to_utf8(buffer);
+        path += "\\openal\\hrtf-cache";
+#else
+        if(auto cachepath = al::getenv("XDG_CACHE_HOME"))
+            path = std::move(*cachepath);
+        else if(auto homepath = al::getenv("HOME"))
+        {
+            path = std::move(*homepath);
+            if(!path.empty() && path.back() != '/')
+                path += '/';
+            path += ".cache";
+        }
+        else
+            return std::string{};
+        if(!path.empty() && path.back() != '/')
+            path += '/';
+        path += "openal/hrtf";
+#endif
+    }
+#ifdef _WIN32
+    std::replace(path.begin(), path.end(), '/', '\\');
+#endif
+    while(!path.empty() && path.back() == slash)
+        path.pop_back();
+    if(path.empty())
+        return path;
+
+    /* Create each missing directory along the path. */
+    size_t pos{0};
+    do {
+        pos = path.find(slash, pos+1);
+        const std::string dir{path.substr(0, pos)};
+#ifdef _WIN32
+        if(dir.size() == 2 && dir[1] == ':')
+            continue;
+        const int ret{_wmkdir(utf8_to_wstr(dir.c_str()).c_str())};
+#else
+        const int ret{mkdir(dir.c_str(), 0777)};
+#endif
+        if(ret != 0 && errno != EEXIST)
+        {
+            WARN("Failed to create HRTF cache directory %s: %s\n", dir.c_str(),
+                std::strerror(errno));
+            return std::string{};
+        }
+    } while(pos != std::string::npos);
+
+    path += slash;
+    return path;
+}
+
+FILE *OpenFile(const std::string &filename, const char *mode)
+{
+#ifdef _WIN32
+    return _wfopen(utf8_to_wstr(filename.c_str()).c_str(), utf8_to_wstr(mode).c_str());
+#else
+    return fopen(filename.c_str(), mode);
+#endif
+}
+
+/* Writes a cache file. It's written to a temporary file first, so another
+ * process won't see a partial file.
+ */
+bool WriteCacheFile(const std::string &filename, const char *data, const size_t len)
+{
+    const std::string tmpname{filename + ".tmp"};
+    FILE *file{OpenFile(tmpname, "wb")};
+    if(!file)
+    {
+        WARN("Failed to create %s: %s\n", tmpname.c_str(), std::strerror(errno));
+        return false;
+    }
+
+    const bool ok{fwrite(data, 1, len, file) == len};
+    if(fclose(file) == 0 && ok && std::rename(tmpname.c_str(), filename.c_str()) == 0)
+    {
+        TRACE("Wrote cache file %s\n", filename.c_str());
+        return true;
+    }
+    WARN("Failed to write cache file %s\n", filename.c_str());
+    std::remove(tmpname.c_str());
+    return false;
+}
+
+/* Writes the contents hash to a key file. */
+void WriteKeyFile(const std::string &filename, const uint64_t hash)
+{
+    char text[17];
+    snprintf(text, sizeof(text), "%016llx", static_cast<unsigned long long>(hash));
+    WriteCacheFile(filename, text, 16);
+}
+
+/* Reads the contents hash stored in a key file. */
+al::optional<uint64_t> ReadKeyFile(const std::string &filename)
+{
+    al::ifstream file{filename.c_str(), std::ios::binary};
+    if(!file.is_open())
+        return al::nullopt;
+
+    char text[17]{};
+    file.read(text, 16);
+    if(file.gcount() != 16)
+        return al::nullopt;
+
+    char *end{};
+    const unsigned long long hash{std::strtoull(text, &end, 16)};
+    if(end != text+16)
+        return al::nullopt;
+    return al::make_optional(static_cast<uint64_t>(hash));
+}
+
+} // namespace
+
+
+std::unique_ptr<std::istream> OpenSofaHrtf(const std::string &filename, const char *devname,
+    const ALuint rate)
+{
+    /* Cached conversions are named for a hash of the file contents and the
+     * rate. Hashing the contents means reading the whole file though, so a
+     * small key file, named for the file's path, size, and modification time,
+     * stores the contents hash of files that were converted before.
+     */
+    std::string cachebase{GetCacheDir(devname)};
+    if(!cachebase.empty())
+    {
+        size_t namepos{filename.find_last_of('/')+1};
+        if(!namepos) namepos = filename.find_last_of('\\')+1;
+        const size_t extpos{filename.find_last_of('.')};
+        cachebase += filename.substr(namepos, (extpos > namepos) ? extpos-namepos :
+            std::string::npos);
+    }
+    auto get_cache_name = [&cachebase,rate](const uint64_t hash, const char *ext) -> std::string
+    {
+        char suffix[48];
+        snprintf(suffix, sizeof(suffix), "-%016llx-%u.%s", static_cast<unsigned long long>(hash),
+            rate, ext);
+        return cachebase + suffix;
+    };
+
+    std::string keyname;
+    if(!cachebase.empty())
+    {
+        if(auto key = GetFileKey(filename))
+        {
+            keyname = get_cache_name(*key, "key");
+            if(auto hash = ReadKeyFile(keyname))
+            {
+                const std::string cachename{get_cache_name(*hash, "mhr")};
+                auto cached = std::make_unique<al::ifstream>(cachename.c_str(), std::ios::binary);
+                if(cached->is_open())
+                {
+                    TRACE("Using cached conversion %s\n", cachename.c_str());
+                    return cached;
+                }
+            }
+        }
+    }
+
+    auto hash = HashFile(filename);
+    if(!hash)
+    {
+        ERR("Could not open %s\n", filename.c_str());
+        return nullptr;
+    }
+
+    std::string cachename;
+    if(!cachebase.empty())
+    {
+        /* The same contents may have been converted from another path. */
+        cachename = get_cache_name(*hash, "mhr");
+        auto cached = std::make_unique<al::ifstream>(cachename.c_str(), std::ios::binary);
+        if(cached->is_open())
+        {
+            TRACE("Using cached conversion %s\n", cachename.c_str());
+            if(!keyname.empty())
+                WriteKeyFile(keyname, *hash);
+            return cached;
+        }
+    }
+
+    std::string data{ConvertSofa(filename, rate)};
+    if(data.empty())
+        return nullptr;
+
+    if(!cachename.empty() && WriteCacheFile(cachename, data.data(), data.size())
+        && !keyname.empty())
+        WriteKeyFile(keyname, *hash);
+
+    return std::make_unique<std::istringstream>(std::move(data));
+}
@@ -0,0 +1,19 @@
+#ifndef ALC_SOFAHRTF_H
+#define ALC_SOFAHRTF_H
+
+#include <istream>
+#include <memory>
+#include <string>
+
+#include "AL/al.h"
+
+
+/* Opens a SOFA file as a stream of v3 HRTF data (as read by the .mhr loader)
+ * at the given sample rate. The conversion is done at most once for a given
+ * file and rate, with the result stored in an on-disk cache to be reused by
+ * later loads. Returns null on failure.
+ */
+std::unique_ptr<std::istream> OpenSofaHrtf(const std::string &filename, const char *devname,
+    const ALuint rate);
+
+#endif /* ALC_SOFAHRTF_H */
@@ -137,6 +137,79 @@ void allpass_process(al::span<float> dst, const float *RESTRICT src)
 #endif
 }
 
+
+/* Lane coefficients for the interleaved mid, side, and shift signals (the
+ * last lane is unused).
+ */
+alignas(16) const auto LaneCoeffs = []
+{
+    std::array<Uhj2EncoderIIR::Frame,Uhj2EncoderIIR::sNumSections> ret{};
+    for(size_t s{0};s < ret.size();++s)
+        ret[s] = {{PhaseSplitRefCoeffs[s], PhaseSplitRefCoeffs[s], PhaseSplitShiftCoeffs[s],
+            0.0f}};
+    return ret;
+}();
+
+void allpass_frames_process(const al::span<Uhj2EncoderIIR::Frame> frames,
+    std::array<std::array<Uhj2EncoderIIR::Frame,4>,Uhj2EncoderIIR::sNumSections> &state)
+{
+    /* All sections are run on each frame before moving to the next, so the
+     * state stays in registers and the sections' recurrences can overlap.
+     */
+#ifdef HAVE_SSE_INTRINSICS
+    __m128 coeffs[Uhj2EncoderIIR::sNumSections];
+    __m128 x1[Uhj2EncoderIIR::sNumSections], x2[Uhj2EncoderIIR::sNumSections];
+    __m128 y1[Uhj2EncoderIIR::sNumSections], y2[Uhj2EncoderIIR::sNumSections];
+    for(size_t s{0};s < Uhj2EncoderIIR::sNumSections;++s)
+    {
+        coeffs[s] = _mm_load_ps(LaneCoeffs[s].data());
+        x1[s] = _mm_load_ps(state[s][0].data());
+        x2[s] = _mm_load_ps(state[s][1].data());
+        y1[s] = _mm_load_ps(state[s][2].data());
+        y2[s] = _mm_load_ps(state[s][3].data());
+    }
+    for(auto &frame : frames)
+    {
+        __m128 v{_mm_load_ps(frame.data())};
+        for(size_t s{0};s < Uhj2EncoderIIR::sNumSections;++s)
+        {
+            const __m128 y{_mm_sub_ps(_mm_mul_ps(coeffs[s], _mm_add_ps(v, y2[s])), x2[s])};
+            x2[s] = x1[s]; x1[s] = v;
+            y2[s] = y1[s]; y1[s] = y;
+            v = y;
+        }
+        _mm_store_ps(frame.data(), v);
+    }
+    for(size_t s{0};s < Uhj2EncoderIIR::sNumSections;++s)
+    {
+        _mm_store_ps(state[s][0].data(), x1[s]);
+        _mm_store_ps(state[s][1].data(), x2[s]);
+        _mm_store_ps(state[s][2].data(), y1[s]);
+        _mm_store_ps(state[s][3].data(), y2[s]);
+    }
+
+#else
+
+    for(auto &frame : frames)
+    {
+        for(size_t s{0};s < Uhj2EncoderIIR::sNumSections;++s)
+        {
+            auto &x1 = state[s][0];
+            auto &x2 = state[s][1];
+            auto &y1 = state[s][2];
+            auto &y2 = state[s][3];
+            for(size_t l{0};l < frame.size();++l)
+            {
+                const float y{LaneCoeffs[s][l]*(frame[l] + y2[l]) - x2[l]};
+                x2[l] = x1[l]; x1[l] = frame[l];
+                y2[l] = y1[l]; y1[l] = y;
+                frame[l] = y;
+            }
+        }
+    }
+#endif
+}
+
 } // namespace
 
 
@@ -212,3 +285,43 @@ void Uhj2Encoder::encode(FloatBufferLine &LeftOut, FloatBufferLine &RightOut,
     for(size_t i{0};i < SamplesToDo;i++)
         right[i] = (mMid[i] - mSide[i]) * 0.5f;
 }
+
+void Uhj2EncoderIIR::encode(FloatBufferLine &LeftOut, FloatBufferLine &RightOut,
+    const FloatBufferLine *InSamples, const size_t SamplesToDo)
+{
+    ASSUME(SamplesToDo > 0);
+
+    float *RESTRICT left{al::assume_aligned<16>(LeftOut.data())};
+    float *RESTRICT right{al::assume_aligned<16>(RightOut.data())};
+
+    const float *RESTRICT winput{al::assume_aligned<16>(InSamples[0].data())};
+    const float *RESTRICT xinput{al::assume_aligned<16>(InSamples[1].data())};
+    const float *RESTRICT yinput{al::assume_aligned<16>(InSamples[2].data())};
+
+    for(size_t i{0};i < SamplesToDo;++i)
+    {
+        Frame &frame = mFrames[i];
+        /* S = 0.9396926*W + 0.1855740*X, with any existing direct signal. */
+        frame[0] = 0.9396926f*winput[i] + 0.1855740f*xinput[i] + left[i] + right[i];
+        /* D = 0.6554516*Y, with any existing direct signal. */
+        frame[1] = 0.6554516f*yinput[i] + left[i] - right[i];
+        /* j(-0.3420201*W + 0.5098604*X) */
+        frame[2] = -0.3420201f*winput[i] + 0.5098604f*xinput[i];
+        frame[3] = 0.0f;
+    }
+    allpass_frames_process({mFrames.data(), SamplesToDo}, mState);
+
+    /* Left = (S + D)/2.0, and Right = (S - D)/2.0, with the reference chain's
+     * (mid and side) 1-sample delay.
+     */
+    float mid{mLastFrame[0]}, side{mLastFrame[1]};
+    for(size_t i{0};i < SamplesToDo;i++)
+    {
+        const Frame &frame = mFrames[i];
+        left[i] = (mid + side + frame[2]) * 0.5f;
+        right[i] = (mid - side - frame[2]) * 0.5f;
+        mid = frame[0];
+        side = frame[1];
+    }
+    mLastFrame = mFrames[SamplesToDo-1];
+}
@@ -5,6 +5,7 @@
 
 #include "alcmain.h"
 #include "almalloc.h"
+#include "filters/phasesplit.h"
 
 
 /* Encoding 2-channel UHJ from B-Format is done as:
@@ -17,11 +18,32 @@
  *
  * where j is a wide-band +90 degree phase shift.
  *
- * The phase shift is done using a FIR filter derived from an FFT'd impulse
- * with the desired shift.
+ * The phase shift can be done using a FIR filter derived from an FFT'd impulse
+ * with the desired shift, or with a pair of IIR all-pass filter chains whose
+ * outputs are 90 degrees apart.
+ *
+ * The FIR filter gives an exact phase shift over nearly the whole spectrum,
+ * with a linear phase (i.e. a fixed delay of sFilterSize samples) on both
+ * outputs. The IIR filters cost considerably less and have essentially no
+ * delay, but they only keep the shift within about a degree over the audible
+ * range, and both outputs get a frequency-dependent (non-linear) phase.
  */
 
-struct Uhj2Encoder {
+struct Uhj2EncoderBase {
+    virtual ~Uhj2EncoderBase() = default;
+
+    /** Returns the number of samples of delay added by the encoder. */
+    virtual size_t getDelay() noexcept = 0;
+
+    /**
+     * Encodes a 2-channel UHJ (stereo-compatible) signal from a B-Format input
+     * signal. The input must use FuMa channel ordering and scaling.
+     */
+    virtual void encode(FloatBufferLine &LeftOut, FloatBufferLine &RightOut,
+        const FloatBufferLine *InSamples, const size_t SamplesToDo) = 0;
+};
+
+struct Uhj2Encoder final : public Uhj2EncoderBase {
     /* A particular property of the filter allows it to cover nearly twice its
      * length, so the filter size is also the effective delay (despite being
      * center-aligned).
@@ -40,14 +62,40 @@ struct Uhj2Encoder {
 
     alignas(16) std::array<float,BUFFERSIZE + sFilterSize*2> mTemp{};
 
-    /**
-     * Encodes a 2-channel UHJ (stereo-compatible) signal from a B-Format input
-     * signal. The input must use FuMa channel ordering and scaling.
-     */
+    size_t getDelay() noexcept override { return sFilterSize; }
+
     void encode(FloatBufferLine &LeftOut, FloatBufferLine &RightOut,
-        const FloatBufferLine *InSamples, const size_t SamplesToDo);
+        const FloatBufferLine *InSamples, const size_t SamplesToDo) override;
 
     DEF_NEWDEL(Uhj2Encoder)
 };
 
+struct Uhj2EncoderIIR final : public Uhj2EncoderBase {
+    /* Each all-pass chain is made of four 2nd order sections in z^-2 (see
+     * PhaseSplitter).
+     */
+    constexpr static size_t sNumSections{PhaseSplitSections};
+
+    /* The mid and side signals go through the reference chain (followed by a
+     * 1-sample delay), while the signal to be phase shifted goes through the
+     * other chain, coming out +90 degrees relative to the reference. The three
+     * signals are filtered together, interleaved as lanes of a 4-float frame.
+     */
+    using Frame = std::array<float,4>;
+
+    /* x[n-1], x[n-2], y[n-1], y[n-2] of each section. */
+    alignas(16) std::array<std::array<Frame,4>,sNumSections> mState{};
+    /* The last filtered frame, for the reference chain's 1-sample delay. */
+    alignas(16) Frame mLastFrame{};
+
+    alignas(16) std::array<Frame,BUFFERSIZE> mFrames{};
+
+    size_t getDelay() noexcept override { return 1; }
+
+    void encode(FloatBufferLine &LeftOut, FloatBufferLine &RightOut,
+        const FloatBufferLine *InSamples, const size_t SamplesToDo) override;
+
+    DEF_NEWDEL(Uhj2EncoderIIR)
+};
+
 #endif /* UHJFILTER_H */
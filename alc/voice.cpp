@@ -27,6 +27,7 @@
 #include <atomic>
 #include <cassert>
 #include <climits>
+#include <cmath>
 #include <cstddef>
 #include <cstdint>
 #include <iterator>
@@ -49,6 +50,7 @@
 #include "alspan.h"
 #include "alstring.h"
 #include "alu.h"
+#include "ambidefs.h"
 #include "cpu_caps.h"
 #include "devformat.h"
 #include "filters/biquad.h"
@@ -90,8 +92,12 @@ using HrtfMixerBlendFunc = void(*)(const float *InSamples, float2 *AccumSamples,
     const ALuint IrSize, const HrtfFilter *oldparams, const MixHrtfFilter *newparams,
     const size_t BufferSize);
 
+using MixerMultiFunc = void(*)(const al::span<const MixTarget> Targets, const size_t BufferSize,
+    const size_t Counter, const size_t OutPos);
+
 HrtfMixerFunc MixHrtfSamples{MixHrtf_<CTag>};
 HrtfMixerBlendFunc MixHrtfBlendSamples{MixHrtfBlend_<CTag>};
+MixerMultiFunc MixMultiSamples{MixMulti_<CTag>};
 
 inline MixerFunc SelectMixer()
 {
@@ -106,6 +112,19 @@ inline MixerFunc SelectMixer()
     return Mix_<CTag>;
 }
 
+inline MixerMultiFunc SelectMultiMixer()
+{
+#ifdef HAVE_NEON
+    if((CPUCapFlags&CPU_CAP_NEON))
+        return MixMulti_<NEONTag>;
+#endif
+#ifdef HAVE_SSE
+    if((CPUCapFlags&CPU_CAP_SSE))
+        return MixMulti_<SSETag>;
+#endif
+    return MixMulti_<CTag>;
+}
+
 inline HrtfMixerFunc SelectHrtfMixer()
 {
 #ifdef HAVE_NEON
@@ -175,6 +194,7 @@ void aluInitMixer()
     }
 
     MixSamples = SelectMixer();
+    MixMultiSamples = SelectMultiMixer();
     MixHrtfBlendSamples = SelectHrtfBlendMixer();
     MixHrtfSamples = SelectHrtfMixer();
 }
@@ -309,33 +329,82 @@ void SendSourceStoppedEvent(ALCcontext *context, ALuint id)
 }
 
 
-const float *DoFilters(BiquadFilter &lpfilter, BiquadFilter &hpfilter, float *dst,
-    const al::span<const float> src, int type)
+/* Filters a group of resampled channel lines, writing the results to dst and
+ * returning the lines to mix from (the source lines if unfiltered).
+ */
+template<typename ParamsT>
+const float *const *DoFilters(const al::span<ParamsT*> parms, const float *const *src,
+    float *const *dst, const size_t count, int type)
 {
+    constexpr size_t NumLanes{BiquadBank<1>::sLanes};
+
     switch(type)
     {
     case AF_None:
-        lpfilter.clear();
-        hpfilter.clear();
+        for(ParamsT *p : parms)
+        {
+            p->LowPass.clear();
+            p->HighPass.clear();
+        }
         break;
 
     case AF_LowPass:
-        lpfilter.process(src, dst);
-        hpfilter.clear();
-        return dst;
     case AF_HighPass:
-        lpfilter.clear();
-        hpfilter.process(src, dst);
+        {
+            const bool lowpass{type == AF_LowPass};
+            BiquadBank<1>::FilterLine lines[NumLanes];
+            for(size_t i{0u};i < parms.size();++i)
+            {
+                lines[i] = {lowpass ? &parms[i]->LowPass : &parms[i]->HighPass};
+                (lowpass ? parms[i]->HighPass : parms[i]->LowPass).clear();
+            }
+            BiquadBank<1>{{lines, parms.size()}}.process(src, dst, count);
+        }
         return dst;
 
     case AF_BandPass:
-        DualBiquad{lpfilter, hpfilter}.process(src, dst);
+        {
+            BiquadBank<2>::FilterLine lines[NumLanes];
+            for(size_t i{0u};i < parms.size();++i)
+                lines[i] = {&parms[i]->LowPass, &parms[i]->HighPass};
+            BiquadBank<2>{{lines, parms.size()}}.process(src, dst, count);
+        }
         return dst;
     }
-    return src.data();
+    return src;
 }
 
 
+/* Checks if a plain target's gains for the given lines are silent and will
+ * stay silent, so it can skip being filtered and mixed. If so, the current
+ * gains are set to the target and the filters are cleared (as if it was
+ * unfiltered), ready for when it becomes audible again.
+ */
+template<typename ParamsT>
+bool SkipSilentTarget(const al::span<ParamsT*> parms, const size_t numgains, const bool stopping)
+{
+    auto is_silent = [](const float gain) noexcept -> bool
+    { return !(std::fabs(gain) > GAIN_SILENCE_THRESHOLD); };
+    for(ParamsT *p : parms)
+    {
+        if(!std::all_of(p->Gains.Current.begin(), p->Gains.Current.begin()+numgains, is_silent))
+            return false;
+        if(!stopping
+            && !std::all_of(p->Gains.Target.begin(), p->Gains.Target.begin()+numgains, is_silent))
+            return false;
+    }
+    for(ParamsT *p : parms)
+    {
+        if(stopping)
+            std::fill_n(p->Gains.Current.begin(), numgains, 0.0f);
+        else
+            std::copy_n(p->Gains.Target.begin(), numgains, p->Gains.Current.begin());
+        p->LowPass.clear();
+        p->HighPass.clear();
+    }
+    return true;
+}
+
 template<FmtType T>
 inline void LoadSampleArray(float *RESTRICT dst, const al::byte *src, const size_t srcstep,
     const size_t samples) noexcept
@@ -347,6 +416,8 @@ inline void LoadSampleArray(float *RESTRICT dst, const al::byte *src, const size
         dst[i] = FmtTypeTraits<T>::to_float(ssrc[i*srcstep]);
 }
 
+} // namespace
+
 void LoadSamples(float *RESTRICT dst, const al::byte *src, const size_t srcstep, FmtType srctype,
     const size_t samples) noexcept
 {
@@ -363,6 +434,8 @@ void LoadSamples(float *RESTRICT dst, const al::byte *src, const size_t srcstep,
 #undef HANDLE_FMT
 }
 
+namespace {
+
 float *LoadBufferStatic(ALbufferlistitem *BufferListItem, ALbufferlistitem *&BufferLoopItem,
     const size_t NumChannels, const size_t SampleSize, const size_t chan, size_t DataPosInt,
     al::span<float> SrcBuffer)
@@ -419,7 +492,24 @@ float *LoadBufferCallback(ALbufferlistitem *BufferListItem, const size_t NumChan
     const ALbuffer *Buffer{BufferListItem->mBuffer};
 
     /* Load what's left to play from the buffer */
-    const size_t DataRem{minz(SrcBuffer.size(), NumCallbackSamples)};
+    size_t DataRem{minz(SrcBuffer.size(), NumCallbackSamples)};
+
+    if(const RingBuffer *ring{Buffer->mCallbackRing.get()})
+    {
+        /* Prefetched samples are read in place from the ring, which may wrap
+         * around.
+         */
+        auto data = ring->getReadVector();
+        for(auto &seg : {data.first, data.second})
+        {
+            const size_t todo{minz(DataRem, seg.len)};
+            LoadSamples(SrcBuffer.data(), seg.buf + chan*SampleSize, NumChannels,
+                Buffer->mFmtType, todo);
+            SrcBuffer = SrcBuffer.subspan(todo);
+            DataRem -= todo;
+        }
+        return SrcBuffer.begin();
+    }
 
     const al::byte *Data{Buffer->mData.data() + chan*SampleSize};
 
@@ -463,6 +553,99 @@ float *LoadBufferQueue(ALbufferlistitem *BufferListItem, ALbufferlistitem *Buffe
 }
 
 
+/* Fades from the old HRIR to the new one with a single filter, stepping the
+ * coefficients interpolated between the two (weighted by their gains) every
+ * few samples while the gain itself fades smoothly. Differing delays are
+ * handled by offsetting each response from the shorter delay, with the mix
+ * starting early enough for each filter to see the same input samples as it
+ * would when blending. This approximates blending the outputs of both filters
+ * at about half the cost. Returns false if the offset responses don't fit in
+ * a HRIR, in which case the caller should blend instead.
+ */
+bool MixHrtfInterpolated(const float *InSamples, float2 *AccumSamples, const ALuint IrSize,
+    const HrtfFilter &oldparams, const HrtfFilter &newparams, const float newGain,
+    const ALuint BufferSize)
+{
+    static constexpr ALuint StepSize{16};
+
+    std::array<ALuint,2> delay, oldoffset, newoffset;
+    ALuint lead{0u};
+    for(size_t c{0};c < 2;++c)
+    {
+        delay[c] = minu(oldparams.Delay[c], newparams.Delay[c]);
+        oldoffset[c] = oldparams.Delay[c] - delay[c];
+        newoffset[c] = newparams.Delay[c] - delay[c];
+        lead = maxu(lead, maxu(oldoffset[c], newoffset[c]));
+    }
+    /* The SIMD mixers read the coefficients in pairs, and may read one pair
+     * past the end, which needs to be silent.
+     */
+    const ALuint numcoeffs{(IrSize+lead+1u) & ~1u};
+    if(numcoeffs+2u > HRIR_LENGTH || lead >= BufferSize)
+        return false;
+    for(size_t c{0};c < 2;++c)
+    {
+        delay[c] += lead;
+        if(delay[c] > HRTF_HISTORY_LENGTH)
+            return false;
+    }
+
+    alignas(16) HrirArray coeffs{};
+    MixHrtfFilter hrtfparams;
+    hrtfparams.Coeffs = &coeffs;
+    hrtfparams.Delay = delay;
+
+    const float oldGain{oldparams.Gain};
+    const float gainstep{(newGain - oldGain) / static_cast<float>(BufferSize)};
+    auto old_weight = [oldGain,BufferSize](const int i) noexcept -> float
+    {
+        if(i < 0 || i >= static_cast<int>(BufferSize)) return 0.0f;
+        return oldGain * static_cast<float>(BufferSize-static_cast<ALuint>(i)) /
+            static_cast<float>(BufferSize);
+    };
+    auto new_weight = [newGain,BufferSize](const int i) noexcept -> float
+    {
+        if(i < 0 || i >= static_cast<int>(BufferSize)) return 0.0f;
+        return newGain * static_cast<float>(i) / static_cast<float>(BufferSize);
+    };
+
+    /* Output position 'pos' maps to input position 'pos + offset' for each
+     * filter. Near the ends, where the filters' spans don't overlap, the
+     * coefficients are updated every sample.
+     */
+    const int start{-static_cast<int>(lead)};
+    const int end{static_cast<int>(BufferSize)};
+    const int edge{end - static_cast<int>(lead)};
+    for(int pos{start};pos < end;)
+    {
+        const int todo{(pos < 0 || pos >= edge) ? 1 : std::min(int{StepSize}, edge-pos)};
+        const int mid{pos + (todo-1)/2};
+
+        const float gain{oldGain + gainstep*static_cast<float>(mid)};
+        const bool normalize{std::abs(gain) > GAIN_SILENCE_THRESHOLD};
+        const float scale{normalize ? 1.0f/gain : 1.0f};
+
+        std::fill_n(coeffs.begin(), numcoeffs, float2{});
+        for(size_t c{0};c < 2;++c)
+        {
+            const float oldscale{old_weight(mid+static_cast<int>(oldoffset[c])) * scale};
+            const float newscale{new_weight(mid+static_cast<int>(newoffset[c])) * scale};
+            for(ALuint i{0u};i < IrSize;++i)
+            {
+                coeffs[oldoffset[c]+i][c] += oldparams.Coeffs[i][c] * oldscale;
+                coeffs[newoffset[c]+i][c] += newparams.Coeffs[i][c] * newscale;
+            }
+        }
+        hrtfparams.Gain = normalize ? oldGain + gainstep*static_cast<float>(pos) : 1.0f;
+        hrtfparams.GainStep = normalize ? gainstep : 0.0f;
+        MixHrtfSamples(InSamples+lead+pos, AccumSamples+pos, numcoeffs, &hrtfparams,
+            static_cast<ALuint>(todo));
+
+        pos += todo;
+    }
+    return true;
+}
+
 void DoHrtfMix(const float *samples, const ALuint DstBufferSize, DirectParams &parms,
     const float TargetGain, const ALuint Counter, ALuint OutPos, const ALuint IrSize,
     ALCdevice *Device)
@@ -474,12 +657,12 @@ void DoHrtfMix(const float *samples, const ALuint DstBufferSize, DirectParams &p
     float2 *AccumSamples{Device->HrtfAccumData + HRTF_DIRECT_DELAY};
 
     /* Copy the HRTF history and new input samples into a temp buffer. */
-    auto src_iter = std::copy(parms.Hrtf.History.begin(), parms.Hrtf.History.end(),
+    auto src_iter = std::copy(parms.Hrtf->History.begin(), parms.Hrtf->History.end(),
         std::begin(HrtfSamples));
     std::copy_n(samples, DstBufferSize, src_iter);
     /* Copy the last used samples back into the history buffer for later. */
-    std::copy_n(std::begin(HrtfSamples) + DstBufferSize, parms.Hrtf.History.size(),
-        parms.Hrtf.History.begin());
+    std::copy_n(std::begin(HrtfSamples) + DstBufferSize, parms.Hrtf->History.size(),
+        parms.Hrtf->History.begin());
 
     /* If fading and this is the first mixing pass, fade between the IRs. */
     ALuint fademix{0u};
@@ -497,19 +680,24 @@ void DoHrtfMix(const float *samples, const ALuint DstBufferSize, DirectParams &p
         if(Counter > fademix)
         {
             const float a{static_cast<float>(fademix) / static_cast<float>(Counter)};
-            gain = lerp(parms.Hrtf.Old.Gain, TargetGain, a);
+            gain = lerp(parms.Hrtf->Old.Gain, TargetGain, a);
+        }
+        if(!Device->mHrtfInterpolate
+            || !MixHrtfInterpolated(HrtfSamples, AccumSamples+OutPos, IrSize, parms.Hrtf->Old,
+                parms.Hrtf->Target, gain, fademix))
+        {
+            MixHrtfFilter hrtfparams;
+            hrtfparams.Coeffs = &parms.Hrtf->Target.Coeffs;
+            hrtfparams.Delay = parms.Hrtf->Target.Delay;
+            hrtfparams.Gain = 0.0f;
+            hrtfparams.GainStep = gain / static_cast<float>(fademix);
+
+            MixHrtfBlendSamples(HrtfSamples, AccumSamples+OutPos, IrSize, &parms.Hrtf->Old,
+                &hrtfparams, fademix);
         }
-        MixHrtfFilter hrtfparams;
-        hrtfparams.Coeffs = &parms.Hrtf.Target.Coeffs;
-        hrtfparams.Delay = parms.Hrtf.Target.Delay;
-        hrtfparams.Gain = 0.0f;
-        hrtfparams.GainStep = gain / static_cast<float>(fademix);
-
-        MixHrtfBlendSamples(HrtfSamples, AccumSamples+OutPos, IrSize, &parms.Hrtf.Old, &hrtfparams,
-            fademix);
         /* Update the old parameters with the result. */
-        parms.Hrtf.Old = parms.Hrtf.Target;
-        parms.Hrtf.Old.Gain = gain;
+        parms.Hrtf->Old = parms.Hrtf->Target;
+        parms.Hrtf->Old.Gain = gain;
         OutPos += fademix;
     }
 
@@ -524,22 +712,27 @@ void DoHrtfMix(const float *samples, const ALuint DstBufferSize, DirectParams &p
         if(Counter > DstBufferSize)
         {
             const float a{static_cast<float>(todo) / static_cast<float>(Counter-fademix)};
-            gain = lerp(parms.Hrtf.Old.Gain, TargetGain, a);
+            gain = lerp(parms.Hrtf->Old.Gain, TargetGain, a);
         }
 
         MixHrtfFilter hrtfparams;
-        hrtfparams.Coeffs = &parms.Hrtf.Target.Coeffs;
-        hrtfparams.Delay = parms.Hrtf.Target.Delay;
-        hrtfparams.Gain = parms.Hrtf.Old.Gain;
-        hrtfparams.GainStep = (gain - parms.Hrtf.Old.Gain) / static_cast<float>(todo);
+        hrtfparams.Coeffs = &parms.Hrtf->Target.Coeffs;
+        hrtfparams.Delay = parms.Hrtf->Target.Delay;
+        hrtfparams.Gain = parms.Hrtf->Old.Gain;
+        hrtfparams.GainStep = (gain - parms.Hrtf->Old.Gain) / static_cast<float>(todo);
         MixHrtfSamples(HrtfSamples+fademix, AccumSamples+OutPos, IrSize, &hrtfparams, todo);
         /* Store the now-current gain for next time. */
-        parms.Hrtf.Old.Gain = gain;
+        parms.Hrtf->Old.Gain = gain;
     }
 }
 
+/* Mixes the samples with near-field compensation. When the compensation is
+ * turning on or off, the filtered samples are crossfaded with the unfiltered
+ * ones over the gain fade, going from 'nfcfrom' to 'nfcto'.
+ */
 void DoNfcMix(const al::span<const float> samples, FloatBufferLine *OutBuffer, DirectParams &parms,
-    const float *TargetGains, const ALuint Counter, const ALuint OutPos, ALCdevice *Device)
+    const float *TargetGains, const ALuint Counter, const ALuint OutPos, const float nfcfrom,
+    const float nfcto, ALCdevice *Device)
 {
     using FilterProc = void (NfcFilter::*)(const al::span<const float>, float*);
     static constexpr FilterProc NfcProcess[MAX_AMBI_ORDER+1]{
@@ -556,6 +749,15 @@ void DoNfcMix(const al::span<const float> samples, FloatBufferLine *OutBuffer, D
     while(const size_t chancount{Device->NumChannelsPerOrder[order]})
     {
         (parms.NFCtrlFilter.*NfcProcess[order])(samples, nfcsamples.data());
+        if(nfcfrom != nfcto)
+        {
+            const auto fadelen = static_cast<float>(Counter + OutPos);
+            for(size_t i{0};i < nfcsamples.size();++i)
+            {
+                const float a{minf(static_cast<float>(OutPos+i+1) / fadelen, 1.0f)};
+                nfcsamples[i] = lerp(samples[i], nfcsamples[i], lerp(nfcfrom, nfcto, a));
+            }
+        }
         MixSamples(nfcsamples, {OutBuffer, chancount}, CurrentGains, TargetGains, Counter, OutPos);
         OutBuffer += chancount;
         CurrentGains += chancount;
@@ -565,8 +767,144 @@ void DoNfcMix(const al::span<const float> samples, FloatBufferLine *OutBuffer, D
     }
 }
 
+/* Resets the vector to 'count' default elements, first releasing its memory
+ * if it has more than needed and more than 'keep' elements' worth.
+ */
+template<typename T>
+void ResetStorage(T &vec, const size_t count, const size_t keep)
+{
+    if(vec.capacity() > keep && count < vec.capacity())
+        T{}.swap(vec);
+    vec.reserve(maxz(keep, count));
+    vec.assign(count, typename T::value_type{});
+}
+
 } // namespace
 
+void Voice::initMixState(const ALCdevice *device)
+{
+    const size_t num_chans{mChans.size()};
+    const size_t num_sends{device->NumAuxSends};
+    /* Bus members mix to the bus lines instead of the dry output, and the
+     * world-locked bus has a full set of ambisonic channels.
+     */
+    const size_t wet_chans{AmbiChannelsFromOrder(device->mAmbiOrder)};
+    const size_t dry_chans{maxz(maxz(device->Dry.Buffer.size(), device->RealOut.Buffer.size()),
+        maxz(SubmixBus::MaxLines, wet_chans))};
+    const bool use_hrtf{device->mRenderMode == HrtfRender};
+
+    /* Each channel has a current and target gain for each dry output, and for
+     * each output of each send.
+     */
+    const size_t chan_gains{(dry_chans + wet_chans*num_sends) * 2};
+    ResetStorage(mGainStorage, num_chans*chan_gains, 2*chan_gains);
+    ResetStorage(mSendStorage, num_chans*num_sends, 2*num_sends);
+    ResetStorage(mHrtfStorage, use_hrtf ? num_chans : 0, 2);
+
+    float *gains{mGainStorage.data()};
+    SendParams *sends{mSendStorage.data()};
+    for(size_t c{0};c < num_chans;++c)
+    {
+        ChannelData &chandata = mChans[c];
+
+        chandata.mDryParams = DirectParams{};
+        chandata.mDryParams.Hrtf = use_hrtf ? &mHrtfStorage[c] : nullptr;
+        chandata.mDryParams.Gains.Current = {gains, dry_chans};
+        chandata.mDryParams.Gains.Target = {gains+dry_chans, dry_chans};
+        gains += dry_chans*2;
+
+        chandata.mWetParams = sends;
+        for(size_t i{0};i < num_sends;++i)
+        {
+            sends->Gains.Current = {gains, wet_chans};
+            sends->Gains.Target = {gains+wet_chans, wet_chans};
+            gains += wet_chans*2;
+            ++sends;
+        }
+    }
+}
+
+SpatialCluster::~SpatialCluster() = default;
+
+void SpatialCluster::init(const ALCdevice *device)
+{
+    mVoice.mFrequency = device->Frequency;
+    mVoice.mFmtChannels = FmtMono;
+    mVoice.mSampleSize = sizeof(float);
+    mVoice.mAmbiLayout = AmbiLayout::ACN;
+    mVoice.mAmbiScaling = AmbiNorm::N3D;
+    mVoice.mAmbiOrder = 0;
+    mVoice.mFlags = VOICE_IS_BUS;
+    mVoice.mSubmixInput = &mBus;
+    mVoice.mStep = FRACTIONONE;
+    mVoice.mPosition.store(0u, std::memory_order_relaxed);
+    mVoice.mPositionFrac.store(0u, std::memory_order_relaxed);
+
+    mVoice.mChans.resize(1);
+    mVoice.initMixState(device);
+    mVoice.mChans[0].mPrevSamples.fill(0.0f);
+    if(device->AvgSpeakerDist > 0.0f)
+    {
+        const float w1{SPEEDOFSOUNDMETRESPERSEC /
+            (device->AvgSpeakerDist * static_cast<float>(device->Frequency))};
+        mVoice.mChans[0].mDryParams.NFCtrlFilter.init(w1);
+    }
+
+    /* The cluster only has a dry path, its members handle the sends. */
+    mVoice.mDirect.Buffer = {};
+    std::fill(mVoice.mSend.begin(), mVoice.mSend.end(), Voice::TargetData{});
+
+    mBus.mClearCount = 0u;
+    mNumMembers = 0u;
+    mNewMembers = 0u;
+    mActive = false;
+}
+
+void WorldBus::init(const ALCdevice *device)
+{
+    const ALuint order{device->mAmbiOrder};
+    const size_t numlines{AmbiChannelsFromOrder(order)};
+    mBus.mBuffer.resize(numlines);
+
+    mMix.AmbiMap.fill(BFChannelConfig{});
+    for(size_t i{0};i < numlines;++i)
+        mMix.AmbiMap[i] = BFChannelConfig{1.0f, static_cast<ALuint>(i)};
+    mMix.Buffer = mBus.mBuffer;
+
+    mVoice.mFrequency = device->Frequency;
+    mVoice.mFmtChannels = FmtBFormat3D;
+    mVoice.mSampleSize = sizeof(float);
+    mVoice.mAmbiLayout = AmbiLayout::ACN;
+    mVoice.mAmbiScaling = AmbiNorm::N3D;
+    mVoice.mAmbiOrder = order;
+    mVoice.mFlags = VOICE_IS_BUS;
+    mVoice.mSubmixInput = &mBus;
+    mVoice.mStep = FRACTIONONE;
+    mVoice.mPosition.store(0u, std::memory_order_relaxed);
+    mVoice.mPositionFrac.store(0u, std::memory_order_relaxed);
+
+    mVoice.mChans.resize(numlines);
+    mVoice.initMixState(device);
+    for(auto &chandata : mVoice.mChans)
+        chandata.mPrevSamples.fill(0.0f);
+    if(device->AvgSpeakerDist > 0.0f)
+    {
+        const float w1{SPEEDOFSOUNDMETRESPERSEC /
+            (device->AvgSpeakerDist * static_cast<float>(device->Frequency))};
+        for(auto &chandata : mVoice.mChans)
+            chandata.mDryParams.NFCtrlFilter.init(w1);
+    }
+
+    /* The bus only has a dry path, its members handle the sends. */
+    mVoice.mDirect.Buffer = {};
+    std::fill(mVoice.mSend.begin(), mVoice.mSend.end(), Voice::TargetData{});
+
+    mBus.mClearCount = 0u;
+    mNumMembers = 0u;
+    mNewMembers = 0u;
+    mActive = false;
+}
+
 void Voice::mix(const State vstate, ALCcontext *Context, const ALuint SamplesToDo)
 {
     static constexpr std::array<float,MAX_OUTPUT_CHANNELS> SilentTarget{};
@@ -597,7 +935,22 @@ void Voice::mix(const State vstate, ALCcontext *Context, const ALuint SamplesToD
 
     ALCdevice *Device{Context->mDevice.get()};
     const ALuint NumSends{Device->NumAuxSends};
-    const ALuint IrSize{Device->mHrtf ? Device->mHrtf->irSize : 0};
+    const ALuint IrSize{mMixHrirSize};
+
+    /* Bus members and the bus itself make sure the bus lines only hold this
+     * update's mix. A stopped bus fades out with silence instead, since it may
+     * be getting deleted. Spatial clusters aren't sources, and are always
+     * mixed as playing.
+     */
+    SubmixBus *BusInput{nullptr};
+    if(SubmixBus *bus{mDryBus})
+        bus->prepare(Device->MixCount.load(std::memory_order_relaxed), SamplesToDo);
+    else if UNLIKELY((mFlags&VOICE_IS_BUS)
+        && (vstate == Playing || mSourceID.load(std::memory_order_relaxed) != 0))
+    {
+        BusInput = mSubmixInput;
+        BusInput->prepare(Device->MixCount.load(std::memory_order_relaxed), SamplesToDo);
+    }
 
     ResamplerFunc Resample{(increment == FRACTIONONE && DataPosFrac == 0) ?
                            Resample_<CopyTag,CTag> : mResampler};
@@ -611,9 +964,10 @@ void Voice::mix(const State vstate, ALCcontext *Context, const ALuint SamplesToD
             {
                 DirectParams &parms = chandata.mDryParams;
                 if(!(mFlags&VOICE_HAS_HRTF))
-                    parms.Gains.Current = parms.Gains.Target;
+                    std::copy(parms.Gains.Target.begin(), parms.Gains.Target.end(),
+                        parms.Gains.Current.begin());
                 else
-                    parms.Hrtf.Old = parms.Hrtf.Target;
+                    parms.Hrtf->Old = parms.Hrtf->Target;
             }
             for(ALuint send{0};send < NumSends;++send)
             {
@@ -621,12 +975,14 @@ void Voice::mix(const State vstate, ALCcontext *Context, const ALuint SamplesToD
                     continue;
 
                 SendParams &parms = chandata.mWetParams[send];
-                parms.Gains.Current = parms.Gains.Target;
+                std::copy(parms.Gains.Target.begin(), parms.Gains.Target.end(),
+                    parms.Gains.Current.begin());
             }
         }
     }
 
     ALuint buffers_done{0u};
+    bool underrun{false};
     ALuint OutPos{0u};
     do {
         /* Figure out how many buffer samples will be needed */
@@ -675,6 +1031,7 @@ void Voice::mix(const State vstate, ALCcontext *Context, const ALuint SamplesToD
             }
         }
 
+        bool restarting{false};
         if((mFlags&(VOICE_IS_CALLBACK|VOICE_CALLBACK_STOPPED)) == VOICE_IS_CALLBACK
             && BufferListItem)
         {
@@ -682,7 +1039,40 @@ void Voice::mix(const State vstate, ALCcontext *Context, const ALuint SamplesToD
 
             /* Exclude resampler pre-padding from the needed size. */
             const ALuint toLoad{SrcBufferSize - (MAX_RESAMPLER_PADDING>>1)};
-            if(toLoad > mNumCallbackSamples)
+            if(const RingBuffer *ring{buffer->mCallbackRing.get()})
+            {
+                /* A newly started voice has the worker restart the callback
+                 * (from the voice's position, for files), then plays silence
+                 * until the ring has been refilled.
+                 */
+                buffer->mCallbackLoop.store(BufferLoopItem != nullptr, std::memory_order_relaxed);
+                if((mFlags&VOICE_CALLBACK_RESTART))
+                {
+                    mFlags &= ~VOICE_CALLBACK_RESTART;
+                    mNumCallbackSamples = 0;
+                    buffer->mCallbackRestartPos = DataPosInt;
+                    buffer->mCallbackRestart.store(true, std::memory_order_release);
+                    Device->mBufferWorker->wake();
+                }
+                if(buffer->mCallbackRestart.load(std::memory_order_acquire))
+                {
+                    restarting = true;
+                    mNumCallbackSamples = 0;
+                }
+                else
+                {
+                    /* Prefetched callbacks just use what's been made
+                     * available, stopping once the callback ended and its
+                     * ring is drained.
+                     */
+                    const bool ended{buffer->mCallbackEnded.load(std::memory_order_acquire)};
+                    const size_t avail{ring->readSpace()};
+                    mNumCallbackSamples = static_cast<ALuint>(minz(avail, toLoad));
+                    if(ended && avail < toLoad)
+                        mFlags |= VOICE_CALLBACK_STOPPED;
+                }
+            }
+            else if(toLoad > mNumCallbackSamples)
             {
                 const size_t byteOffset{mNumCallbackSamples*FrameSize};
                 const size_t needBytes{toLoad*FrameSize - byteOffset};
@@ -702,92 +1092,237 @@ void Voice::mix(const State vstate, ALCcontext *Context, const ALuint SamplesToD
             }
         }
 
-        ASSUME(DstBufferSize > 0);
-        for(auto &chandata : mChans)
+        /* A static buffer with a resample cache for this step can play from
+         * the cache instead of resampling, when the part of the buffer the
+         * resampler would read is wholly within the range being played. The
+         * position gets rounded to the nearest cached sample.
+         */
+        const float *CachedData{nullptr};
+        size_t CachedStride{0u};
+        if((mFlags&VOICE_IS_STATIC) && BufferListItem)
         {
-            const size_t num_chans{mChans.size()};
-            const auto chan = static_cast<size_t>(std::distance(mChans.data(),
-                std::addressof(chandata)));
-            const al::span<float> SrcData{Device->SourceData, SrcBufferSize};
-
-            /* Load the previous samples into the source data first, then load
-             * what we can from the buffer queue.
+            const ALbuffer *buffer{BufferListItem->mBuffer};
+            /* Check the cache is ready before its step, which is only stable
+             * while it's ready.
              */
-            auto srciter = std::copy_n(chandata.mPrevSamples.begin(), MAX_RESAMPLER_PADDING>>1,
-                SrcData.begin());
-
-            if UNLIKELY(!BufferListItem)
-                srciter = std::copy(chandata.mPrevSamples.begin()+(MAX_RESAMPLER_PADDING>>1),
-                    chandata.mPrevSamples.end(), srciter);
-            else if((mFlags&VOICE_IS_STATIC))
-                srciter = LoadBufferStatic(BufferListItem, BufferLoopItem, num_chans,
-                    SampleSize, chan, DataPosInt, {srciter, SrcData.end()});
-            else if((mFlags&VOICE_IS_CALLBACK))
-                srciter = LoadBufferCallback(BufferListItem, num_chans, SampleSize, chan,
-                    mNumCallbackSamples, {srciter, SrcData.end()});
-            else
-                srciter = LoadBufferQueue(BufferListItem, BufferLoopItem, num_chans,
-                    SampleSize, chan, DataPosInt, {srciter, SrcData.end()});
-
-            if UNLIKELY(srciter != SrcData.end())
+            if(buffer->mResampledReady.load(std::memory_order_acquire)
+                && increment == buffer->mResampledStep)
             {
-                /* If the source buffer wasn't filled, copy the last sample for
-                 * the remaining buffer. Ideally it should have ended with
-                 * silence, but if not the gain fading should help avoid clicks
-                 * from sudden amplitude changes.
+                constexpr uint64_t Padding{MAX_RESAMPLER_PADDING >> 1};
+                const uint64_t pos{(uint64_t{DataPosInt}<<FRACTIONBITS) | DataPosFrac};
+                const uint64_t idx{(pos + (increment>>1)) / increment};
+                const uint64_t start{idx * increment};
+                const uint64_t last{(idx+DstBufferSize-1)*increment + (Padding<<FRACTIONBITS)};
+                /* The samples kept for the next update are loaded directly
+                 * from the buffer, so they also need to be within range.
                  */
-                const float sample{*(srciter-1)};
-                std::fill(srciter, SrcData.end(), sample);
+                const uint64_t prevend{((start + DstBufferSize*increment)>>FRACTIONBITS)
+                    + Padding};
+                const uint64_t lo{BufferLoopItem ? buffer->LoopStart+Padding : 0u};
+                const uint64_t hi{BufferLoopItem ? buffer->LoopEnd : buffer->SampleLen};
+                if(start >= (lo<<FRACTIONBITS) && last < (hi<<FRACTIONBITS) && prevend <= hi
+                    && idx+DstBufferSize <= buffer->mResampledLen)
+                {
+                    DataPosInt = static_cast<ALuint>(start >> FRACTIONBITS);
+                    DataPosFrac = static_cast<ALuint>(start & FRACTIONMASK);
+                    CachedData = &buffer->mResampledData[static_cast<size_t>(idx)];
+                    CachedStride = buffer->mResampledLen;
+                }
             }
+        }
 
-            /* Store the last source samples used for next time. */
-            std::copy_n(&SrcData[(increment*DstBufferSize + DataPosFrac)>>FRACTIONBITS],
-                chandata.mPrevSamples.size(), chandata.mPrevSamples.begin());
-
-            /* Resample, then apply ambisonic upsampling as needed. */
-            const float *ResampledData{Resample(&mResampleState,
-                &SrcData[MAX_RESAMPLER_PADDING>>1], DataPosFrac, increment,
-                {Device->ResampledData, DstBufferSize})};
-            if((mFlags&VOICE_IS_AMBISONIC))
-            {
-                const float hfscale{chandata.mAmbiScale};
-                /* Beware the evil const_cast. It's safe since it's pointing to
-                 * either SourceData or ResampledData (both non-const), but the
-                 * resample method takes the source as const float* and may
-                 * return it without copying to output, making it currently
-                 * unavoidable.
-                 */
-                const al::span<float> samples{const_cast<float*>(ResampledData), DstBufferSize};
-                chandata.mAmbiSplitter.processHfScale(samples, hfscale);
-            }
+        ASSUME(DstBufferSize > 0);
+        const size_t num_chans{mChans.size()};
+        for(size_t chanbase{0u};chanbase < num_chans;chanbase += ALCdevice::MixerLanes)
+        {
+            const size_t num_lanes{minz(num_chans-chanbase, ALCdevice::MixerLanes)};
+            const al::span<ChannelData> lanechans{&mChans[chanbase], num_lanes};
 
-            /* Now filter and mix to the appropriate outputs. */
-            float (&FilterBuf)[BUFFERSIZE] = Device->FilteredData;
+            const float *ResampledData[ALCdevice::MixerLanes];
+            for(size_t lane{0u};lane < num_lanes;++lane)
             {
-                DirectParams &parms = chandata.mDryParams;
-                const float *samples{DoFilters(parms.LowPass, parms.HighPass, FilterBuf,
-                    {ResampledData, DstBufferSize}, mDirect.FilterType)};
-
-                if((mFlags&VOICE_HAS_HRTF))
+                ChannelData &chandata = lanechans[lane];
+                const size_t chan{chanbase + lane};
+                if UNLIKELY((mFlags&VOICE_IS_BUS))
                 {
-                    const float TargetGain{UNLIKELY(vstate == Stopping) ? 0.0f :
-                        parms.Hrtf.Target.Gain};
-                    DoHrtfMix(samples, DstBufferSize, parms, TargetGain, Counter, OutPos, IrSize,
-                        Device);
+                    /* The bus lines are already at the output rate, so play
+                     * them directly.
+                     */
+                    if(BusInput)
+                        ResampledData[lane] = BusInput->mBuffer[chan].data() + OutPos;
+                    else
+                    {
+                        std::fill_n(Device->ResampledData[lane], DstBufferSize, 0.0f);
+                        ResampledData[lane] = Device->ResampledData[lane];
+                    }
                 }
-                else if((mFlags&VOICE_HAS_NFC))
+                else
                 {
-                    const float *TargetGains{UNLIKELY(vstate == Stopping) ? SilentTarget.data()
-                        : parms.Gains.Target.data()};
-                    DoNfcMix({samples, DstBufferSize}, mDirect.Buffer.data(), parms, TargetGains,
-                        Counter, OutPos, Device);
+                    const al::span<float> SrcData{Device->SourceData[lane], SrcBufferSize};
+                    const size_t prevpos{(increment*DstBufferSize + DataPosFrac)>>FRACTIONBITS};
+                    auto srcend = SrcData.end();
+
+                    /* Load the previous samples into the source data first,
+                     * then load what we can from the buffer queue.
+                     */
+                    auto srciter = std::copy_n(chandata.mPrevSamples.begin(),
+                        MAX_RESAMPLER_PADDING>>1, SrcData.begin());
+
+                    if UNLIKELY(!BufferListItem)
+                        srciter = std::copy(
+                            chandata.mPrevSamples.begin()+(MAX_RESAMPLER_PADDING>>1),
+                            chandata.mPrevSamples.end(), srciter);
+                    else if((mFlags&VOICE_IS_STATIC))
+                    {
+                        /* Playing from the cache only needs the samples kept
+                         * for next time, which the cache check made sure are
+                         * all within the buffer.
+                         */
+                        size_t skip{0u};
+                        if(CachedData)
+                        {
+                            if(prevpos > (MAX_RESAMPLER_PADDING>>1))
+                                skip = prevpos - (MAX_RESAMPLER_PADDING>>1);
+                            srciter += skip;
+                            srcend = SrcData.begin() + prevpos + MAX_RESAMPLER_PADDING;
+                        }
+                        srciter = LoadBufferStatic(BufferListItem, BufferLoopItem, num_chans,
+                            SampleSize, chan, DataPosInt+skip, {srciter, srcend});
+                    }
+                    else if((mFlags&VOICE_IS_CALLBACK))
+                        srciter = LoadBufferCallback(BufferListItem, num_chans, SampleSize, chan,
+                            mNumCallbackSamples, {srciter, SrcData.end()});
+                    else
+                        srciter = LoadBufferQueue(BufferListItem, BufferLoopItem, num_chans,
+                            SampleSize, chan, DataPosInt, {srciter, SrcData.end()});
+
+                    if UNLIKELY(srciter != srcend)
+                    {
+                        /* If the source buffer wasn't filled, copy the last
+                         * sample for the remaining buffer. Ideally it should
+                         * have ended with silence, but if not the gain fading
+                         * should help avoid clicks from sudden amplitude
+                         * changes.
+                         */
+                        const float sample{*(srciter-1)};
+                        std::fill(srciter, srcend, sample);
+                    }
+
+                    /* Store the last source samples used for next time. */
+                    std::copy_n(&SrcData[prevpos], chandata.mPrevSamples.size(),
+                        chandata.mPrevSamples.begin());
+
+                    /* Resample (or use the cached samples), then apply
+                     * ambisonic upsampling as needed.
+                     */
+                    if(!CachedData)
+                    {
+                        const float *src{&SrcData[MAX_RESAMPLER_PADDING>>1]};
+                        ResampledData[lane] = Resample(&mResampleState, src, DataPosFrac,
+                            increment, {Device->ResampledData[lane], DstBufferSize});
+                        if UNLIKELY(mPrevResampler && Counter && Resample == mResampler)
+                        {
+                            /* Crossfade from the previous resampler's output
+                             * over the gain fade.
+                             */
+                            alignas(16) std::array<float,BUFFERSIZE> prevdata;
+                            const float *prev{mPrevResampler(&mPrevResampleState, src,
+                                DataPosFrac, increment, {prevdata.data(), DstBufferSize})};
+                            const float *cur{ResampledData[lane]};
+                            float *out{Device->ResampledData[lane]};
+                            for(size_t i{0};i < DstBufferSize;++i)
+                            {
+                                const float a{static_cast<float>(OutPos+i+1) /
+                                    static_cast<float>(SamplesToDo)};
+                                out[i] = lerp(prev[i], cur[i], a);
+                            }
+                            ResampledData[lane] = out;
+                        }
+                    }
+                    else
+                    {
+                        /* The mixers need aligned input, and ambisonic HF
+                         * scaling below is done in place, so copy the cached
+                         * samples unless they can be used as-is.
+                         */
+                        const float *cached{CachedData + chan*CachedStride};
+                        if(!(mFlags&VOICE_IS_AMBISONIC)
+                            && !(reinterpret_cast<uintptr_t>(cached)&15))
+                            ResampledData[lane] = cached;
+                        else
+                        {
+                            std::copy_n(cached, DstBufferSize, Device->ResampledData[lane]);
+                            ResampledData[lane] = Device->ResampledData[lane];
+                        }
+                    }
                 }
-                else
+                if((mFlags&VOICE_IS_AMBISONIC))
                 {
-                    const float *TargetGains{UNLIKELY(vstate == Stopping) ? SilentTarget.data()
-                        : parms.Gains.Target.data()};
-                    MixSamples({samples, DstBufferSize}, mDirect.Buffer,
-                        parms.Gains.Current.data(), TargetGains, Counter, OutPos);
+                    const float hfscale{chandata.mAmbiScale};
+                    /* Beware the evil const_cast. It's safe since it's
+                     * pointing to either SourceData, ResampledData, or the bus
+                     * lines (all non-const), but the resample method takes the
+                     * source as const float* and may return it without copying
+                     * to output, making it currently unavoidable.
+                     */
+                    const al::span<float> samples{const_cast<float*>(ResampledData[lane]),
+                        DstBufferSize};
+                    chandata.mAmbiSplitter.processHfScale(samples, hfscale);
+                }
+            }
+
+            /* Now filter the group's lines together for the dry path and each
+             * send, each into its own filter buffer, skipping the targets that
+             * are silent. Then mix each line to all of its plain (non-HRTF and
+             * non-NFC) targets at once.
+             */
+            MixTarget targets[ALCdevice::MixerLanes][MAX_SENDS+1];
+            size_t numtargets[ALCdevice::MixerLanes]{};
+            float *FilterBuf[ALCdevice::MixerLanes];
+            const bool stopping{vstate == Stopping};
+            {
+                DirectParams *parms[ALCdevice::MixerLanes];
+                for(size_t lane{0u};lane < num_lanes;++lane)
+                    parms[lane] = &lanechans[lane].mDryParams;
+
+                const bool plain{!(mFlags&(VOICE_HAS_HRTF|VOICE_HAS_NFC|VOICE_NFC_FADING))};
+                if(!plain || !SkipSilentTarget(al::span<DirectParams*>{parms, num_lanes},
+                    mDirect.Buffer.size(), stopping))
+                {
+                    for(size_t lane{0u};lane < num_lanes;++lane)
+                        FilterBuf[lane] = Device->FilteredData[0][lane];
+                    const float *const *samples{DoFilters(
+                        al::span<DirectParams*>{parms, num_lanes}, ResampledData, FilterBuf,
+                        DstBufferSize, mDirect.FilterType)};
+
+                    for(size_t lane{0u};lane < num_lanes;++lane)
+                    {
+                        DirectParams &dparms = *parms[lane];
+                        if((mFlags&VOICE_HAS_HRTF))
+                        {
+                            const float TargetGain{UNLIKELY(stopping) ? 0.0f :
+                                dparms.Hrtf->Target.Gain};
+                            DoHrtfMix(samples[lane], DstBufferSize, dparms, TargetGain, Counter,
+                                OutPos, IrSize, Device);
+                        }
+                        else if((mFlags&(VOICE_HAS_NFC|VOICE_NFC_FADING)))
+                        {
+                            const float *TargetGains{UNLIKELY(stopping) ?
+                                SilentTarget.data() : dparms.Gains.Target.data()};
+                            const float nfcto{(mFlags&VOICE_HAS_NFC) ? 1.0f : 0.0f};
+                            const float nfcfrom{((mFlags&VOICE_NFC_FADING) && Counter) ?
+                                1.0f-nfcto : nfcto};
+                            DoNfcMix({samples[lane], DstBufferSize}, mDirect.Buffer.data(),
+                                dparms, TargetGains, Counter, OutPos, nfcfrom, nfcto, Device);
+                        }
+                        else
+                        {
+                            const float *TargetGains{UNLIKELY(stopping) ?
+                                SilentTarget.data() : dparms.Gains.Target.data()};
+                            targets[lane][numtargets[lane]++] = MixTarget{samples[lane],
+                                mDirect.Buffer, dparms.Gains.Current.data(), TargetGains};
+                        }
+                    }
                 }
             }
 
@@ -796,14 +1331,33 @@ void Voice::mix(const State vstate, ALCcontext *Context, const ALuint SamplesToD
                 if(mSend[send].Buffer.empty())
                     continue;
 
-                SendParams &parms = chandata.mWetParams[send];
-                const float *samples{DoFilters(parms.LowPass, parms.HighPass, FilterBuf,
-                    {ResampledData, DstBufferSize}, mSend[send].FilterType)};
+                SendParams *parms[ALCdevice::MixerLanes];
+                for(size_t lane{0u};lane < num_lanes;++lane)
+                    parms[lane] = &lanechans[lane].mWetParams[send];
+                if(SkipSilentTarget(al::span<SendParams*>{parms, num_lanes},
+                    mSend[send].Buffer.size(), stopping))
+                    continue;
 
-                const float *TargetGains{UNLIKELY(vstate == Stopping) ? SilentTarget.data()
-                    : parms.Gains.Target.data()};
-                MixSamples({samples, DstBufferSize}, mSend[send].Buffer,
-                    parms.Gains.Current.data(), TargetGains, Counter, OutPos);
+                for(size_t lane{0u};lane < num_lanes;++lane)
+                    FilterBuf[lane] = Device->FilteredData[send+1][lane];
+                const float *const *samples{DoFilters(al::span<SendParams*>{parms, num_lanes},
+                    ResampledData, FilterBuf, DstBufferSize, mSend[send].FilterType)};
+
+                for(size_t lane{0u};lane < num_lanes;++lane)
+                {
+                    SendParams &sparms = *parms[lane];
+                    const float *TargetGains{UNLIKELY(stopping) ?
+                        SilentTarget.data() : sparms.Gains.Target.data()};
+                    targets[lane][numtargets[lane]++] = MixTarget{samples[lane],
+                        mSend[send].Buffer, sparms.Gains.Current.data(), TargetGains};
+                }
+            }
+
+            for(size_t lane{0u};lane < num_lanes;++lane)
+            {
+                if(numtargets[lane] > 0)
+                    MixMultiSamples({targets[lane], numtargets[lane]}, DstBufferSize, Counter,
+                        OutPos);
             }
         }
         /* Update positions */
@@ -846,7 +1400,72 @@ void Voice::mix(const State vstate, ALCcontext *Context, const ALuint SamplesToD
         else if((mFlags&VOICE_IS_CALLBACK))
         {
             ALbuffer *buffer{BufferListItem->mBuffer};
-            if(SrcSamplesDone < mNumCallbackSamples)
+            if(RingBuffer *ring{buffer->mCallbackRing.get()})
+            {
+                if(restarting)
+                {
+                    /* Nothing is taken from the ring while restarting, so the
+                     * position stays put.
+                     */
+                    DataPosInt -= SrcSamplesDone;
+                    mNumCallbackSamples = 0;
+                }
+                else
+                {
+                    const ALuint consumed{minu(SrcSamplesDone, mNumCallbackSamples)};
+                    ring->readAdvance(consumed);
+                    Device->mBufferWorker->wake();
+
+                    /* A file's position follows what was read from it. It
+                     * wraps around at the end when looping (the worker starts
+                     * the file over when prefetching), and otherwise stops
+                     * there, even if the ring has more from before looping
+                     * was turned off.
+                     */
+                    bool fileEnded{false};
+                    if(const ALuint SampleLen{BufferListItem->mSampleLen})
+                    {
+                        DataPosInt -= SrcSamplesDone - consumed;
+                        if(DataPosInt >= SampleLen)
+                        {
+                            if(BufferLoopItem)
+                                DataPosInt %= SampleLen;
+                            else
+                                fileEnded = true;
+                        }
+                    }
+
+                    if(fileEnded)
+                    {
+                        BufferListItem = nullptr;
+                        mNumCallbackSamples = 0;
+                    }
+                    else if(SrcSamplesDone < mNumCallbackSamples)
+                    {
+                        mNumCallbackSamples -= SrcSamplesDone;
+                        mFlags &= ~VOICE_CALLBACK_UNDERRUN;
+                    }
+                    else if(!(mFlags&VOICE_CALLBACK_STOPPED))
+                    {
+                        /* The ring ran dry before the callback ended. Keep
+                         * going with what's there next time, and report the
+                         * underrun.
+                         */
+                        mNumCallbackSamples = 0;
+                        if(!(mFlags&VOICE_CALLBACK_UNDERRUN))
+                        {
+                            mFlags |= VOICE_CALLBACK_UNDERRUN;
+                            underrun = true;
+                        }
+                    }
+                    else
+                    {
+                        BufferListItem = nullptr;
+                        mNumCallbackSamples = 0;
+                    }
+                }
+            }
+            else if(SrcSamplesDone < mNumCallbackSamples)
             {
                 const size_t byteOffset{SrcSamplesDone*FrameSize};
                 const size_t byteEnd{mNumCallbackSamples*FrameSize};
@@ -878,6 +1497,22 @@ void Voice::mix(const State vstate, ALCcontext *Context, const ALuint SamplesToD
 
     mFlags |= VOICE_IS_FADING;
 
+    /* The old HRTF coefficients, resampler, and near-field compensation, and
+     * any sends being dropped, have faded out now.
+     */
+    mMixHrirSize = mHrirSize;
+    mPrevResampler = nullptr;
+    mFlags &= ~VOICE_NFC_FADING;
+    if UNLIKELY(mFadingSends)
+    {
+        for(ALuint send{0};send < NumSends;++send)
+        {
+            if((mFadingSends&(1u<<send)))
+                mSend[send].Buffer = {};
+        }
+        mFadingSends = 0u;
+    }
+
     /* Don't update positions and buffers if we were stopping. */
     if UNLIKELY(vstate == Stopping)
     {
@@ -892,7 +1527,9 @@ void Voice::mix(const State vstate, ALCcontext *Context, const ALuint SamplesToD
     mPosition.store(DataPosInt, std::memory_order_relaxed);
     mPositionFrac.store(DataPosFrac, std::memory_order_relaxed);
     mCurrentBuffer.store(BufferListItem, std::memory_order_relaxed);
-    if(!BufferListItem)
+    /* A bus has no buffers, and plays until it's stopped. */
+    const bool ended{!BufferListItem && !(mFlags&VOICE_IS_BUS)};
+    if(ended)
     {
         mLoopBuffer.store(nullptr, std::memory_order_relaxed);
         mSourceID.store(0u, std::memory_order_relaxed);
@@ -914,7 +1551,23 @@ void Voice::mix(const State vstate, ALCcontext *Context, const ALuint SamplesToD
         }
     }
 
-    if(!BufferListItem)
+    if(underrun && (enabledevt&EventType_Performance))
+    {
+        RingBuffer *ring{Context->mAsyncEvents.get()};
+        auto evt_vec = ring->getWriteVector();
+        if(evt_vec.first.len > 0)
+        {
+            static constexpr char msg[]{"Callback buffer underrun"};
+            AsyncEvent *evt{::new(evt_vec.first.buf) AsyncEvent{EventType_Performance}};
+            evt->u.user.type = AL_EVENT_TYPE_PERFORMANCE_SOFT;
+            evt->u.user.id = SourceID;
+            evt->u.user.param = 0;
+            std::copy(std::begin(msg), std::end(msg), evt->u.user.msg);
+            ring->writeAdvance(1);
+        }
+    }
+
+    if(ended)
     {
         /* If the voice just ended, set it to Stopping so the next render
          * ensures any residual noise fades to 0 amplitude.
@@ -1,7 +1,9 @@
 #ifndef VOICE_H
 #define VOICE_H
 
+#include <algorithm>
 #include <array>
+#include <cstddef>
 
 #include "AL/al.h"
 #include "AL/alext.h"
@@ -10,12 +12,16 @@
 #include "almalloc.h"
 #include "alspan.h"
 #include "alu.h"
+#include "atomic.h"
 #include "devformat.h"
 #include "filters/biquad.h"
 #include "filters/nfc.h"
 #include "filters/splitter.h"
 #include "hrtf.h"
+#include "vector.h"
 
+struct ALCdevice;
+struct SpatialCluster;
 enum class DistanceModel;
 
 
@@ -58,6 +64,14 @@ struct BsincState {
      * index follows contiguously.
      */
     const float *filter;
+    /* Filter coefficients for when the step keeps the position aligned to
+     * whole phases, so no phase interpolation is needed. The filter for a
+     * given fraction starts at polyfilter + (frac>>pshift)*pstride. Null if
+     * the step can't stay aligned.
+     */
+    const float *polyfilter;
+    ALuint pshift;
+    ALuint pstride;
 };
 
 union InterpState {
@@ -69,6 +83,10 @@ using ResamplerFunc = const float*(*)(const InterpState *state, const float *RES
 
 ResamplerFunc PrepareResampler(Resampler resampler, ALuint increment, InterpState *state);
 
+/* Converts 'samples' samples of the given type, 'srcstep' apart, to float. */
+void LoadSamples(float *RESTRICT dst, const al::byte *src, const size_t srcstep, FmtType srctype,
+    const size_t samples) noexcept;
+
 
 enum {
     AF_None = 0,
@@ -92,15 +110,18 @@ struct DirectParams {
 
     NfcFilter NFCtrlFilter;
 
-    struct {
+    struct HrtfParams {
         HrtfFilter Old;
         HrtfFilter Target;
         alignas(16) std::array<float,HRTF_HISTORY_LENGTH> History;
-    } Hrtf;
+    };
+    /* Only set when the device renders with HRTF. */
+    HrtfParams *Hrtf;
 
+    /* Sized to the larger of the device's dry and real output. */
     struct {
-        std::array<float,MAX_OUTPUT_CHANNELS> Current;
-        std::array<float,MAX_OUTPUT_CHANNELS> Target;
+        al::span<float> Current;
+        al::span<float> Target;
     } Gains;
 };
 
@@ -108,13 +129,54 @@ struct SendParams {
     BiquadFilter LowPass;
     BiquadFilter HighPass;
 
+    /* Sized to the device's effect slot output. */
     struct {
-        std::array<float,MAX_OUTPUT_CHANNELS> Current;
-        std::array<float,MAX_OUTPUT_CHANNELS> Target;
+        al::span<float> Current;
+        al::span<float> Target;
     } Gains;
 };
 
 
+/* A mix of sources that share their position, filters, and sends. Member
+ * voices are resampled and mixed into the bus lines with just their gain, and
+ * the bus's own voice then plays the lines as its input, being filtered,
+ * panned, and sent once for the whole group.
+ */
+struct SubmixBus {
+    /* Enough for a first-order ambisonic bus. */
+    static constexpr size_t MaxLines{4};
+
+    FmtChannels mFmtChannels{FmtMono};
+    al::vector<FloatBufferLine,16> mBuffer;
+
+    /* The device mix count the lines were last cleared for. */
+    ALuint mClearCount{0u};
+
+    /* The number of voice property sets targeting this bus, either as a
+     * voice's current properties or as a pending update. The lines can't be
+     * freed while voices may still mix into them.
+     */
+    RefCount mVoiceRef{0u};
+
+    SubmixBus(FmtChannels chans, size_t numlines) : mFmtChannels{chans}, mBuffer(numlines) { }
+
+    /**
+     * Clears the lines for the given mix, if they haven't been already. The
+     * first of the members (or the bus itself, if no member played) to be
+     * mixed for each update does the clearing.
+     */
+    void prepare(const ALuint mixcount, const ALuint samplesToDo)
+    {
+        if(mClearCount == mixcount) return;
+        mClearCount = mixcount;
+        for(auto &line : mBuffer)
+            std::fill_n(line.begin(), samplesToDo, 0.0f);
+    }
+
+    DEF_NEWDEL(SubmixBus)
+};
+
+
 struct VoiceProps {
     float Pitch;
     float Gain;
@@ -149,6 +211,7 @@ struct VoiceProps {
     std::array<float,2> StereoPan;
 
     float Radius;
+    float Priority;
 
     /** Direct filter and auxiliary send info. */
     struct {
@@ -166,6 +229,11 @@ struct VoiceProps {
         float GainLF;
         float LFReference;
     } Send[MAX_SENDS];
+
+    /* The submix bus this voice mixes into, if it's a bus member. Each
+     * property set holds a reference on the bus.
+     */
+    SubmixBus *mSubmix;
 };
 
 struct VoicePropsItem : public VoiceProps {
@@ -181,9 +249,26 @@ struct VoicePropsItem : public VoiceProps {
 #define VOICE_IS_FADING        (1u<<4) /* Fading sources use gain stepping for smooth transitions. */
 #define VOICE_HAS_HRTF         (1u<<5)
 #define VOICE_HAS_NFC          (1u<<6)
+#define VOICE_CALLBACK_UNDERRUN (1u<<7) /* A prefetching callback's ring ran dry. */
+#define VOICE_IS_BUS           (1u<<8) /* Plays a submix bus, after its members are mixed. */
+#define VOICE_IS_WORLD_LOCKED  (1u<<9) /* Pans into the world-locked bus. */
+#define VOICE_CALLBACK_RESTART (1u<<10) /* A prefetching callback needs to start over. */
+#define VOICE_SWITCHING_DRY    (1u<<11) /* Faded out to move to a new dry path. */
+#define VOICE_NFC_FADING       (1u<<12) /* Near-field compensation turns on or off. */
 
 #define VOICE_TYPE_MASK (VOICE_IS_STATIC | VOICE_IS_CALLBACK)
 
+/* Groups of voice properties an update can change, so only the affected
+ * stages of the parameter calculation need to run.
+ */
+#define VOICE_CHANGED_PITCH    (1u<<0) /* Pitch and resampler. */
+#define VOICE_CHANGED_GAIN     (1u<<1) /* Source, direct, and send gains. */
+#define VOICE_CHANGED_FILTER   (1u<<2) /* Direct and send filters. */
+#define VOICE_CHANGED_SPATIAL  (1u<<3) /* Position, orientation, and the rest. */
+
+#define VOICE_CHANGED_ALL (VOICE_CHANGED_PITCH | VOICE_CHANGED_GAIN | VOICE_CHANGED_FILTER \
+    | VOICE_CHANGED_SPATIAL)
+
 struct Voice {
     enum State {
         Stopped,
@@ -192,11 +277,9 @@ struct Voice {
         Pending
     };
 
-    std::atomic<VoicePropsItem*> mUpdate{nullptr};
-
-    VoiceProps mProps;
-
-    std::atomic<ALuint> mSourceID{0u};
+    /* State used while mixing comes first, followed by the less frequently
+     * accessed properties.
+     */
     std::atomic<State> mPlayState{Stopped};
     std::atomic<bool> mPendingChange{false};
 
@@ -216,24 +299,44 @@ struct Voice {
      */
     std::atomic<ALbufferlistitem*> mLoopBuffer;
 
-    /* Properties for the attached buffer(s). */
-    FmtChannels mFmtChannels;
-    ALuint mFrequency;
-    ALuint mSampleSize;
-    AmbiLayout mAmbiLayout;
-    AmbiNorm mAmbiScaling;
-    ALuint mAmbiOrder;
-
     /** Current target parameters used for mixing. */
     ALuint mStep{0};
 
     ResamplerFunc mResampler;
+    /* The doppler shift and sample rate conversion applied to the pitch, for
+     * pitch changes to be applied alone.
+     */
+    float mPitchScale{1.0f};
 
     InterpState mResampleState;
 
+    /* The resampler being crossfaded from for the next mix, after a level of
+     * detail change.
+     */
+    ResamplerFunc mPrevResampler{nullptr};
+    InterpState mPrevResampleState;
+
     ALuint mFlags{};
     ALuint mNumCallbackSamples{0};
 
+    /* The submix bus played by a bus voice. */
+    SubmixBus *mSubmixInput{nullptr};
+    /* The submix bus or spatial cluster line the dry path mixes into, and the
+     * cluster the voice is a member of.
+     */
+    SubmixBus *mDryBus{nullptr};
+    SpatialCluster *mCluster{nullptr};
+
+    /* The level of detail the voice is rendered with (0 being full quality),
+     * the HRIR length of its target HRTF coefficients and of the mix (which
+     * covers the old coefficients while fading), and the sends that have
+     * faded out to be dropped after the next mix.
+     */
+    ALuint mLodLevel{0u};
+    ALuint mHrirSize{0u};
+    ALuint mMixHrirSize{0u};
+    ALuint mFadingSends{0u};
+
     struct TargetData {
         int FilterType;
         al::span<FloatBufferLine> Buffer;
@@ -248,18 +351,109 @@ struct Voice {
         BandSplitter mAmbiSplitter;
 
         DirectParams mDryParams;
-        std::array<SendParams,MAX_SENDS> mWetParams;
+        /* One for each of the device's auxiliary sends. */
+        SendParams *mWetParams;
     };
     al::vector<ChannelData> mChans{2};
 
+    /* Backing storage for the channels' gains, sends, and HRTF filters, sized
+     * for the device's output when the voice is set up.
+     */
+    al::vector<float,16> mGainStorage;
+    al::vector<SendParams> mSendStorage;
+    al::vector<DirectParams::HrtfParams,16> mHrtfStorage;
+
+    /* Properties for the attached buffer(s). */
+    FmtChannels mFmtChannels;
+    ALuint mFrequency;
+    ALuint mSampleSize;
+    AmbiLayout mAmbiLayout;
+    AmbiNorm mAmbiScaling;
+    ALuint mAmbiOrder;
+
+    std::atomic<ALuint> mSourceID{0u};
+
+    std::atomic<VoicePropsItem*> mUpdate{nullptr};
+
+    VoiceProps mProps;
+
     Voice() = default;
     Voice(const Voice&) = delete;
     ~Voice() { delete mUpdate.exchange(nullptr, std::memory_order_acq_rel); }
     Voice& operator=(const Voice&) = delete;
 
+    /**
+     * Sizes the gain, send, and HRTF storage of the voice's current channels
+     * to the device's output, and clears the channels' filter and gain state.
+     * Must not be called while the voice is being mixed.
+     */
+    void initMixState(const ALCdevice *device);
+
     void mix(const State vstate, ALCcontext *Context, const ALuint SamplesToDo);
 
     DEF_NEWDEL(Voice)
 };
 
+
+/* A group of distant voices spatialised together. Members mix their dry path
+ * into the cluster's line with just their gain and filters, and the cluster's
+ * voice then pans (or HRTF filters) the line once, toward the direction of the
+ * member that started the group. Members still pan their own sends.
+ */
+struct SpatialCluster {
+    SubmixBus mBus{FmtMono, 1};
+    Voice mVoice;
+
+    /* Listener-relative direction, and distance in meters. */
+    std::array<float,3> mDirection{};
+    float mDistance{0.0f};
+
+    /* Members counted in the last update, and so far in the current one. A
+     * cluster with neither is free to be moved for a new group.
+     */
+    ALuint mNumMembers{0u};
+    ALuint mNewMembers{0u};
+    /* Set if the cluster is mixed for the current update. */
+    bool mActive{false};
+
+    SpatialCluster() = default;
+    ~SpatialCluster();
+
+    /**
+     * Sets up the cluster's voice to play its line on the given device,
+     * clearing any members. Must not be called while the device is mixing.
+     */
+    void init(const ALCdevice *device);
+
+    DEF_NEWDEL(SpatialCluster)
+};
+
+
+/* An ambisonic bus locked to the world's axes instead of the listener's.
+ * Positioned mono voices pan into it by their world-space direction, so they
+ * don't need updating when the listener only turns, and the bus voice applies
+ * the listener's rotation to the whole mix once.
+ */
+struct WorldBus {
+    SubmixBus mBus{FmtBFormat3D, 1};
+    Voice mVoice;
+    /* Identity mapping for panning members into the bus lines. */
+    MixParams mMix;
+
+    /* Members counted in the last update, and so far in the current one. */
+    ALuint mNumMembers{0u};
+    ALuint mNewMembers{0u};
+    /* Set if the bus is mixed for the current update. */
+    bool mActive{false};
+
+    /**
+     * Sizes the bus to the device's ambisonic order and sets up its voice to
+     * play it, clearing any members. Must not be called while the device is
+     * mixing.
+     */
+    void init(const ALCdevice *device);
+
+    DEF_NEWDEL(WorldBus)
+};
+
 #endif /* VOICE_H */
@@ -0,0 +1,204 @@
+/*
+ * OpenAL Shared Memory Ring Reader Example
+ *
+ * Copyright (c) 2026 by authors.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/* This file contains an example for reading the output of a device using the
+ * shared memory ring backend, from another process. The frames are written
+ * raw (interleaved, in the device's sample type) to the given file, if any.
+ */
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+#include "backends/shmring.h"
+
+
+namespace {
+
+/* Waits up to 100ms for the device to post that it wrote more frames. */
+void WaitForFrames(ShmRingHeader *header)
+{
+    timespec ts{};
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_nsec += 100000000;
+    if(ts.tv_nsec >= 1000000000)
+    {
+        ts.tv_nsec -= 1000000000;
+        ++ts.tv_sec;
+    }
+    while(sem_timedwait(&header->dataReady, &ts) != 0 && errno == EINTR) {
+    }
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    if(argc < 2)
+    {
+        fprintf(stderr, "Usage: %s <shm name> [raw output file]\n", argv[0]);
+        return 1;
+    }
+
+    /* The device creates the object when it opens, so wait a few seconds for
+     * it to show up.
+     */
+    int fd{-1};
+    for(int i{0};i < 500 && fd < 0;++i)
+    {
+        fd = shm_open(argv[1], O_RDWR, 0);
+        if(fd < 0 && errno == ENOENT)
+            usleep(10000);
+        else
+            break;
+    }
+    if(fd < 0)
+    {
+        fprintf(stderr, "Failed to open %s: %s\n", argv[1], strerror(errno));
+        return 1;
+    }
+
+    struct stat st{};
+    if(fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(ShmRingHeader))
+    {
+        fprintf(stderr, "Invalid shared memory object %s\n", argv[1]);
+        close(fd);
+        return 1;
+    }
+    const auto objsize = static_cast<size_t>(st.st_size);
+    void *ptr{mmap(nullptr, objsize, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0)};
+    close(fd);
+    if(ptr == MAP_FAILED)
+    {
+        fprintf(stderr, "Failed to map %s: %s\n", argv[1], strerror(errno));
+        return 1;
+    }
+    auto *header = static_cast<ShmRingHeader*>(ptr);
+
+    /* The magic is set last, once the rest of the header is ready. */
+    for(int i{0};i < 500 && memcmp(header->magic, ShmRingMagic, sizeof(ShmRingMagic)) != 0;++i)
+        usleep(10000);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if(memcmp(header->magic, ShmRingMagic, sizeof(ShmRingMagic)) != 0
+        || header->version != ShmRingVersion)
+    {
+        fprintf(stderr, "Unsupported shared memory ring in %s\n", argv[1]);
+        munmap(ptr, objsize);
+        return 1;
+    }
+
+    const uint32_t capacity{header->capacity};
+    const uint32_t framesize{header->frameSize};
+    printf("Reading %uhz, %u channel(s) (mask 0x%x), type 0x%x, %u frame ring%s\n",
+        header->sampleRate, header->channelCount, header->channelMask, header->sampleType,
+        capacity, header->blocking ? ", blocking" : "");
+
+    FILE *outfile{nullptr};
+    if(argc > 2)
+    {
+        outfile = fopen(argv[2], "wb");
+        if(!outfile)
+        {
+            fprintf(stderr, "Failed to open %s for writing: %s\n", argv[2], strerror(errno));
+            munmap(ptr, objsize);
+            return 1;
+        }
+    }
+
+    const char *ring{static_cast<const char*>(ptr) + header->dataOffset};
+    std::vector<char> frames(size_t{std::max(header->updateSize, 1u)} * framesize);
+    const uint64_t maxframes{frames.size() / framesize};
+
+    uint64_t total{0}, lost{0};
+    while(header->state.load(std::memory_order_acquire) != ShmRingClosed)
+    {
+        uint64_t readpos{header->readPos.load(std::memory_order_relaxed)};
+        const uint64_t writepos{header->writePos.load(std::memory_order_acquire)};
+        if(readpos == writepos)
+        {
+            WaitForFrames(header);
+            continue;
+        }
+
+        /* Skip ahead if the device overwrote what wasn't read in time. */
+        if(writepos - readpos > capacity)
+        {
+            lost += writepos - capacity - readpos;
+            readpos = writepos - capacity;
+            header->readPos.store(readpos, std::memory_order_release);
+        }
+
+        /* Copy the frames out, which may wrap around the end of the ring. */
+        const uint64_t todo{std::min(writepos - readpos, maxframes)};
+        const auto offset = static_cast<size_t>(readpos % capacity);
+        const size_t len1{std::min(static_cast<size_t>(todo), capacity - offset)};
+        const size_t len2{static_cast<size_t>(todo) - len1};
+        std::copy_n(ring + offset*framesize, len1*framesize, frames.begin());
+        std::copy_n(ring, len2*framesize, frames.begin() + static_cast<ptrdiff_t>(len1*framesize));
+
+        /* Make sure the device didn't start overwriting them while copying.
+         * writeEnd is set before the device mixes into the ring, so anything
+         * before writeEnd-capacity may be torn. Drop those and try again with
+         * the rest.
+         */
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const uint64_t writeend{header->writeEnd.load(std::memory_order_relaxed)};
+        if(writeend - readpos > capacity)
+        {
+            lost += writeend - capacity - readpos;
+            header->readPos.store(writeend - capacity, std::memory_order_release);
+            continue;
+        }
+
+        if(outfile)
+            fwrite(frames.data(), framesize, static_cast<size_t>(todo), outfile);
+        total += todo;
+
+        /* Free the space, and let a blocking device know it's there. */
+        header->readPos.store(readpos + todo, std::memory_order_release);
+        int val{0};
+        if(sem_getvalue(&header->spaceReady, &val) == 0 && val <= 0)
+            sem_post(&header->spaceReady);
+    }
+
+    printf("Read %" PRIu64 " frames, %" PRIu64 " lost (%" PRIu64 " overruns reported)\n",
+        total, lost, header->overruns.load(std::memory_order_relaxed));
+
+    if(outfile)
+        fclose(outfile);
+    munmap(ptr, objsize);
+    return 0;
+}
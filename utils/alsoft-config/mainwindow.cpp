@@ -68,6 +68,9 @@ static const struct {
     { "null", "Null Output" },
 #ifdef HAVE_WAVE
     { "wave", "Wave Writer" },
+#endif
+#ifdef HAVE_SHM
+    { "shm", "Shared Memory" },
 #endif
     { "", "" }
 };
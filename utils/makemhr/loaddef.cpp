@@ -1724,17 +1724,14 @@ static double AverageHrirOnset(const uint rate, const uint n, const double *hrir
 
 // Calculate the magnitude response of an HRIR and average it with any
 // existing responses for its field, elevation, azimuth, and ear.
-static void AverageHrirMagnitude(const uint points, const uint n, const double *hrir, const double f, double *mag)
+static void AverageHrirMagnitude(const RealFft &fft, const uint points, const double *hrir, const double f, double *mag)
 {
+    const uint n{fft.size()};
     uint m = 1 + (n / 2), i;
-    std::vector<complex_d> h(n);
-    std::vector<double> r(n);
-
-    for(i = 0;i < points;i++)
-        h[i] = complex_d{hrir[i], 0.0};
-    for(;i < n;i++)
-        h[i] = complex_d{0.0, 0.0};
-    FftForward(n, h.data());
+    std::vector<complex_d> h(m);
+    std::vector<double> r(m);
+
+    fft.forward(hrir, points, h.data());
     MagnitudeResponse(n, h.data(), r.data());
     for(i = 0;i < m;i++)
         mag[i] = Lerp(mag[i], r[i], f);
@@ -1747,6 +1744,7 @@ static int ProcessSources(TokenReaderT *tr, HrirDataT *hData)
     hData->mHrirsBase.resize(channels * hData->mIrCount * hData->mIrSize);
     double *hrirs = hData->mHrirsBase.data();
     std::vector<double> hrir(hData->mIrPoints);
+    const RealFft fft{hData->mFftSize};
     uint line, col, fi, ei, ai;
     int count;
 
@@ -1865,14 +1863,14 @@ static int ProcessSources(TokenReaderT *tr, HrirDataT *hData)
                 ExtractSofaHrir(sofa, si, 0, src.mOffset, hData->mIrPoints, hrir.data());
                 azd->mIrs[0] = &hrirs[hData->mIrSize * azd->mIndex];
                 azd->mDelays[0] = AverageHrirOnset(hData->mIrRate, hData->mIrPoints, hrir.data(), 1.0, azd->mDelays[0]);
-                AverageHrirMagnitude(hData->mIrPoints, hData->mFftSize, hrir.data(), 1.0, azd->mIrs[0]);
+                AverageHrirMagnitude(fft, hData->mIrPoints, hrir.data(), 1.0, azd->mIrs[0]);
 
                 if(src.mChannel == 1)
                 {
                     ExtractSofaHrir(sofa, si, 1, src.mOffset, hData->mIrPoints, hrir.data());
                     azd->mIrs[1] = &hrirs[hData->mIrSize * (hData->mIrCount + azd->mIndex)];
                     azd->mDelays[1] = AverageHrirOnset(hData->mIrRate, hData->mIrPoints, hrir.data(), 1.0, azd->mDelays[1]);
-                    AverageHrirMagnitude(hData->mIrPoints, hData->mFftSize, hrir.data(), 1.0, azd->mIrs[1]);
+                    AverageHrirMagnitude(fft, hData->mIrPoints, hrir.data(), 1.0, azd->mIrs[1]);
                 }
 
                 // TODO: Since some SOFA files contain minimum phase HRIRs,
@@ -1930,7 +1928,7 @@ static int ProcessSources(TokenReaderT *tr, HrirDataT *hData)
             }
             azd->mIrs[ti] = &hrirs[hData->mIrSize * (ti * hData->mIrCount + azd->mIndex)];
             azd->mDelays[ti] = AverageHrirOnset(hData->mIrRate, hData->mIrPoints, hrir.data(), 1.0 / factor[ti], azd->mDelays[ti]);
-            AverageHrirMagnitude(hData->mIrPoints, hData->mFftSize, hrir.data(), 1.0 / factor[ti], azd->mIrs[ti]);
+            AverageHrirMagnitude(fft, hData->mIrPoints, hrir.data(), 1.0 / factor[ti], azd->mIrs[ti]);
             factor[ti] += 1.0;
             if(!TrIsOperator(tr, "+"))
                 break;
@@ -245,14 +245,11 @@ static double CalcHrirOnset(PPhaseResampler &rs, const uint rate, const uint n,
 }
 
 /* Calculate the magnitude response of a HRIR. */
-static void CalcHrirMagnitude(const uint points, const uint n, std::vector<complex_d> &h,
+static void CalcHrirMagnitude(const RealFft &fft, const uint points, std::vector<complex_d> &h,
     double *hrir)
 {
-    auto iter = std::copy_n(hrir, points, h.begin());
-    std::fill(iter, h.end(), complex_d{0.0, 0.0});
-
-    FftForward(n, h.data());
-    MagnitudeResponse(n, h.data(), hrir);
+    fft.forward(hrir, points, h.data());
+    MagnitudeResponse(fft.size(), h.data(), hrir);
 }
 
 static bool LoadResponses(MYSOFA_HRTF *sofaHrtf, HrirDataT *hData)
@@ -336,44 +333,6 @@ static bool LoadResponses(MYSOFA_HRTF *sofaHrtf, HrirDataT *hData)
 }
 
 
-/* Calculates the frequency magnitudes of the HRIR set. Work is delegated to
- * this struct, which runs asynchronously on one or more threads (sharing the
- * same calculator object).
- */
-struct MagCalculator {
-    const uint mFftSize{};
-    const uint mIrPoints{};
-    std::vector<double*> mIrs{};
-    std::atomic<size_t> mCurrent{};
-    std::atomic<size_t> mDone{};
-
-    void Worker()
-    {
-        auto htemp = std::vector<complex_d>(mFftSize);
-
-        while(1)
-        {
-            /* Load the current index to process. */
-            size_t idx{mCurrent.load()};
-            do {
-                /* If the index is at the end, we're done. */
-                if(idx >= mIrs.size())
-                    return;
-                /* Otherwise, increment the current index atomically so other
-                 * threads know to go to the next one. If this call fails, the
-                 * current index was just changed by another thread and the new
-                 * value is loaded into idx, which we'll recheck.
-                 */
-            } while(!mCurrent.compare_exchange_weak(idx, idx+1, std::memory_order_relaxed));
-
-            CalcHrirMagnitude(mIrPoints, mFftSize, htemp, mIrs[idx]);
-
-            /* Increment the number of IRs done. */
-            mDone.fetch_add(1);
-        }
-    }
-};
-
 bool LoadSofaFile(const char *filename, const uint numThreads, const uint fftSize,
     const uint truncSize, const ChannelModeT chanMode, HrirDataT *hData)
 {
@@ -473,7 +432,8 @@ bool LoadSofaFile(const char *filename, const uint numThreads, const uint fftSiz
     }
 
 
-    size_t hrir_total{0};
+    /* Gather the measured HRIRs, with the delays they set. */
+    std::vector<std::pair<double*,double*>> irs;
     const uint channels{(hData->mChannelType == CT_STEREO) ? 2u : 1u};
     double *hrirs = hData->mHrirsBase.data();
     for(uint fi{0u};fi < hData->mFdCount;fi++)
@@ -488,81 +448,39 @@ bool LoadSofaFile(const char *filename, const uint numThreads, const uint fftSiz
             }
         }
 
-        for(uint ei{hData->mFds[fi].mEvStart};ei < hData->mFds[fi].mEvCount;ei++)
-            hrir_total += hData->mFds[fi].mEvs[ei].mAzCount * channels;
-    }
-
-    std::atomic<size_t> hrir_done{0};
-    auto onset_proc = [hData,channels,&hrir_done]() -> bool
-    {
-        /* Temporary buffer used to calculate the IR's onset. */
-        auto upsampled = std::vector<double>(OnsetRateMultiple * hData->mIrPoints);
-        /* This resampler is used to help detect the response onset. */
-        PPhaseResampler rs;
-        rs.init(hData->mIrRate, OnsetRateMultiple*hData->mIrRate);
-
-        for(uint fi{0u};fi < hData->mFdCount;fi++)
-        {
-            for(uint ei{hData->mFds[fi].mEvStart};ei < hData->mFds[fi].mEvCount;ei++)
-            {
-                for(uint ai{0};ai < hData->mFds[fi].mEvs[ei].mAzCount;ai++)
-                {
-                    HrirAzT &azd = hData->mFds[fi].mEvs[ei].mAzs[ai];
-                    for(uint ti{0};ti < channels;ti++)
-                    {
-                        hrir_done.fetch_add(1u, std::memory_order_acq_rel);
-                        azd.mDelays[ti] = CalcHrirOnset(rs, hData->mIrRate, hData->mIrPoints,
-                            upsampled, azd.mIrs[ti]);
-                    }
-                }
-            }
-        }
-        return true;
-    };
-
-    std::future_status load_status{};
-    auto load_future = std::async(std::launch::async, onset_proc);
-    do {
-        load_status = load_future.wait_for(std::chrono::milliseconds{50});
-        printf("\rCalculating HRIR onsets... %zu of %zu", hrir_done.load(), hrir_total);
-        fflush(stdout);
-    } while(load_status != std::future_status::ready);
-    fputc('\n', stdout);
-    if(!load_future.get())
-        return false;
-
-    MagCalculator calculator{hData->mFftSize, hData->mIrPoints};
-    for(uint fi{0u};fi < hData->mFdCount;fi++)
-    {
         for(uint ei{hData->mFds[fi].mEvStart};ei < hData->mFds[fi].mEvCount;ei++)
         {
-            for(uint ai{0};ai < hData->mFds[fi].mEvs[ei].mAzCount;ai++)
+            for(uint ai{0u};ai < hData->mFds[fi].mEvs[ei].mAzCount;ai++)
             {
                 HrirAzT &azd = hData->mFds[fi].mEvs[ei].mAzs[ai];
-                for(uint ti{0};ti < channels;ti++)
-                    calculator.mIrs.push_back(azd.mIrs[ti]);
+                for(uint ti{0u};ti < channels;ti++)
+                    irs.emplace_back(azd.mIrs[ti], &azd.mDelays[ti]);
             }
         }
     }
 
-    std::vector<std::thread> thrds;
-    thrds.reserve(numThreads);
-    for(size_t i{0};i < numThreads;++i)
-        thrds.emplace_back(std::mem_fn(&MagCalculator::Worker), &calculator);
-    size_t count;
-    do {
-        std::this_thread::sleep_for(std::chrono::milliseconds{50});
-        count = calculator.mDone.load();
+    ParallelFor("Calculating HRIR onsets", irs.size(), numThreads, [hData,&irs]()
+    {
+        /* Temporary buffer used to calculate the IR's onset. */
+        auto upsampled = std::make_shared<std::vector<double>>(
+            OnsetRateMultiple * hData->mIrPoints);
+        /* This resampler is used to help detect the response onset. */
+        auto rs = std::make_shared<PPhaseResampler>();
+        rs->init(hData->mIrRate, OnsetRateMultiple*hData->mIrRate);
 
-        printf("\rCalculating HRIR magnitudes... %zu of %zu", count, calculator.mIrs.size());
-        fflush(stdout);
-    } while(count != calculator.mIrs.size());
-    fputc('\n', stdout);
+        return [hData,&irs,upsampled,rs](const size_t idx) -> void
+        {
+            *irs[idx].second = CalcHrirOnset(*rs, hData->mIrRate, hData->mIrPoints, *upsampled,
+                irs[idx].first);
+        };
+    });
 
-    for(auto &thrd : thrds)
+    const RealFft fft{hData->mFftSize};
+    ParallelFor("Calculating HRIR magnitudes", irs.size(), numThreads, [hData,&irs,&fft]()
     {
-        if(thrd.joinable())
-            thrd.join();
-    }
+        auto htemp = std::make_shared<std::vector<complex_d>>(fft.size()/2 + 1);
+        return [hData,&irs,&fft,htemp](const size_t idx) -> void
+        { CalcHrirMagnitude(fft, hData->mIrPoints, *htemp, irs[idx].first); };
+    });
     return true;
 }
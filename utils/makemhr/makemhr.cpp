@@ -69,6 +69,7 @@
 #include <chrono>
 #include <cmath>
 #include <complex>
+#include <condition_variable>
 #include <cstdint>
 #include <cstdio>
 #include <cstdlib>
@@ -77,6 +78,7 @@
 #include <iostream>
 #include <limits>
 #include <memory>
+#include <mutex>
 #include <numeric>
 #include <thread>
 #include <utility>
@@ -253,72 +255,105 @@ static void FftArrange(const uint n, complex_d *inout)
     }
 }
 
-// Performs the summation.
-static void FftSummation(const uint n, const double s, complex_d *cplx)
+/* Complex multiplication without the inf/NaN recovery of std::complex, which
+ * is only a hindrance in the FFT's inner loops.
+ */
+static inline complex_d ComplexMul(const complex_d &a, const complex_d &b)
 {
-    double pi;
-    uint m, m2;
-    uint i, k, mk;
+    return complex_d{a.real()*b.real() - a.imag()*b.imag(),
+        a.real()*b.imag() + a.imag()*b.real()};
+}
+
+RealFft::RealFft(const uint n) : mSize{n}, mTwiddles(n / 2)
+{
+    for(uint i{0};i < n/2;++i)
+        mTwiddles[i] = std::polar(1.0, -2.0*M_PI*i/n);
+}
 
-    pi = s * M_PI;
-    for(m = 1, m2 = 2;m < n; m <<= 1, m2 <<= 1)
+// Performs the half-size complex transform, with bit-reversal ordering.
+void RealFft::transform(complex_d *inout, const bool inverse) const
+{
+    const uint n{mSize / 2};
+    FftArrange(n, inout);
+    for(uint m{1}, m2{2};m < n;m <<= 1, m2 <<= 1)
     {
-        // v = Complex (-2.0 * sin (0.5 * pi / m) * sin (0.5 * pi / m), -sin (pi / m))
-        double sm = std::sin(0.5 * pi / m);
-        auto v = complex_d{-2.0*sm*sm, -std::sin(pi / m)};
-        auto w = complex_d{1.0, 0.0};
-        for(i = 0;i < m;i++)
+        /* The twiddle factors for this stage are every (n/m)'th entry of the
+         * table. Going through the butterflies in memory order keeps the
+         * accesses local for larger transforms.
+         */
+        const uint stride{n / m};
+        for(uint k{0};k < n;k += m2)
         {
-            for(k = i;k < n;k += m2)
+            complex_d *RESTRICT lo{inout + k};
+            complex_d *RESTRICT hi{inout + k + m};
+            for(uint i{0};i < m;i++)
             {
-                mk = k + m;
-                auto t = w * cplx[mk];
-                cplx[mk] = cplx[k] - t;
-                cplx[k] = cplx[k] + t;
+                const complex_d w{inverse ? std::conj(mTwiddles[i*stride]) :
+                    mTwiddles[i*stride]};
+                const complex_d t{ComplexMul(w, hi[i])};
+                hi[i] = lo[i] - t;
+                lo[i] += t;
             }
-            w += v*w;
         }
     }
 }
 
-// Performs a forward FFT.
-void FftForward(const uint n, complex_d *inout)
+void RealFft::forward(const double *in, const uint count, complex_d *out) const
 {
-    FftArrange(n, inout);
-    FftSummation(n, 1.0, inout);
-}
+    const uint n{mSize / 2};
 
-// Performs an inverse FFT.
-void FftInverse(const uint n, complex_d *inout)
-{
-    FftArrange(n, inout);
-    FftSummation(n, -1.0, inout);
-    double f{1.0 / n};
+    /* Pack the even and odd samples into the real and imaginary parts of a
+     * half-size complex signal.
+     */
     for(uint i{0};i < n;i++)
-        inout[i] *= f;
+    {
+        const uint i0{i*2}, i1{i*2 + 1};
+        out[i] = complex_d{(i0 < count) ? in[i0] : 0.0, (i1 < count) ? in[i1] : 0.0};
+    }
+    transform(out, false);
+
+    /* Separate the spectra of the even and odd samples, and combine them into
+     * the spectrum of the full signal.
+     */
+    const complex_d z0{out[0]};
+    out[0] = complex_d{z0.real() + z0.imag(), 0.0};
+    out[n] = complex_d{z0.real() - z0.imag(), 0.0};
+    for(uint k{1};k <= n/2;k++)
+    {
+        const complex_d a{out[k]}, b{std::conj(out[n - k])};
+        const complex_d even{(a + b) * 0.5};
+        const complex_d odd{ComplexMul(a - b, complex_d{0.0, -0.5})};
+        const complex_d wodd{ComplexMul(mTwiddles[k], odd)};
+        out[k] = even + wodd;
+        out[n - k] = std::conj(even - wodd);
+    }
 }
 
-/* Calculate the complex helical sequence (or discrete-time analytical signal)
- * of the given input using the Hilbert transform. Given the natural logarithm
- * of a signal's magnitude response, the imaginary components can be used as
- * the angles for minimum-phase reconstruction.
- */
-static void Hilbert(const uint n, complex_d *inout)
+void RealFft::inverse(complex_d *inout, double *out, const uint count) const
 {
-    uint i;
+    const uint n{mSize / 2};
+
+    /* Rebuild the spectra of the even and odd samples, and pack them into a
+     * half-size complex signal.
+     */
+    const complex_d a0{inout[0]}, b0{std::conj(inout[n])};
+    inout[0] = (a0 + b0)*0.5 + ComplexMul(a0 - b0, complex_d{0.0, 0.5});
+    for(uint k{1};k <= n/2;k++)
+    {
+        const complex_d a{inout[k]}, b{std::conj(inout[n - k])};
+        const complex_d even{(a + b) * 0.5};
+        const complex_d odd{ComplexMul(a - b, std::conj(mTwiddles[k])) * 0.5};
+        inout[k] = even + ComplexMul(complex_d{0.0, 1.0}, odd);
+        inout[n - k] = std::conj(even) + ComplexMul(complex_d{0.0, 1.0}, std::conj(odd));
+    }
+    transform(inout, true);
 
-    // Handle in-place operation.
-    for(i = 0;i < n;i++)
-        inout[i].imag(0.0);
-
-    FftInverse(n, inout);
-    for(i = 1;i < (n+1)/2;i++)
-        inout[i] *= 2.0;
-    /* Increment i if n is even. */
-    i += (n&1)^1;
-    for(;i < n;i++)
-        inout[i] = complex_d{0.0, 0.0};
-    FftForward(n, inout);
+    const double f{1.0 / n};
+    for(uint i{0};i < count;i++)
+    {
+        const complex_d &z = inout[i / 2];
+        out[i] = ((i&1) ? z.imag() : z.real()) * f;
+    }
 }
 
 /* Calculate the magnitude response of the given input.  This is used in
@@ -363,35 +398,32 @@ static void LimitMagnitudeResponse(const uint n, const uint m, const double limi
         out[i] = std::pow(10.0, out[i] / 20.0);
 }
 
-/* Reconstructs the minimum-phase component for the given magnitude response
- * of a signal.  This is equivalent to phase recomposition, sans the missing
- * residuals (which were discarded).  The mirrored half of the response is
- * reconstructed.
+/* Reconstructs the minimum-phase response for the given magnitude response of
+ * a signal, writing the first count samples of its impulse response.  This is
+ * equivalent to phase recomposition, sans the missing residuals (which were
+ * discarded).  The phase is found with the Hilbert transform of the log
+ * magnitudes, done by folding the (real) cepstrum.  The work buffers need room
+ * for n/2 + 1 complex values and n real values.
  */
-static void MinimumPhase(const uint n, const double *in, complex_d *out)
+static void MinimumPhase(const RealFft &fft, const double *in, complex_d *work, double *ceps,
+    double *out, const uint count)
 {
-    const uint m = 1 + (n / 2);
-    std::vector<double> mags(n);
+    const uint n{fft.size()};
+    const uint m{1 + (n / 2)};
 
     uint i;
     for(i = 0;i < m;i++)
-    {
-        mags[i] = std::max(EPSILON, in[i]);
-        out[i] = complex_d{std::log(mags[i]), 0.0};
-    }
-    for(;i < n;i++)
-    {
-        mags[i] = mags[n - i];
-        out[i] = out[n - i];
-    }
-    Hilbert(n, out);
+        work[i] = complex_d{std::log(std::max(EPSILON, in[i])), 0.0};
+    fft.inverse(work, ceps, n);
+    for(i = 1;i < n/2;i++)
+        ceps[i] *= 2.0;
+    fft.forward(ceps, m, work);
+
     // Remove any DC offset the filter has.
-    mags[0] = EPSILON;
-    for(i = 0;i < n;i++)
-    {
-        auto a = std::exp(complex_d{0.0, out[i].imag()});
-        out[i] = complex_d{mags[i], 0.0} * a;
-    }
+    work[0] = complex_d{EPSILON, 0.0};
+    for(i = 1;i < m;i++)
+        work[i] = std::polar(std::max(EPSILON, in[i]), work[i].imag());
+    fft.inverse(work, out, count);
 }
 
 
@@ -519,57 +551,136 @@ static int StoreMhr(const HrirDataT *hData, const char *filename)
 }
 
 
-/***********************
- *** HRTF processing ***
- ***********************/
+/**************************
+ *** Parallel execution ***
+ **************************/
 
-/* Balances the maximum HRIR magnitudes of multi-field data sets by
- * independently normalizing each field in relation to the overall maximum.
- * This is done to ignore distance attenuation.
- */
-static void BalanceFieldMagnitudes(const HrirDataT *hData, const uint channels, const uint m)
+void ParallelFor(const char *desc, const size_t count, const uint numThreads,
+    const std::function<std::function<void(size_t)>()> &makeProc)
 {
-    double maxMags[MAX_FD_COUNT];
-    uint fi, ei, ai, ti, i;
-
-    double maxMag{0.0};
-    for(fi = 0;fi < hData->mFdCount;fi++)
+    using clock = std::chrono::steady_clock;
+
+    const auto start = clock::now();
+    std::atomic<size_t> current{0u};
+    std::atomic<size_t> done{0u};
+    std::mutex donelock;
+    std::condition_variable donecond;
+    auto worker = [&makeProc,&current,&done,&donelock,&donecond,count]() -> void
     {
-        maxMags[fi] = 0.0;
-
-        for(ei = hData->mFds[fi].mEvStart;ei < hData->mFds[fi].mEvCount;ei++)
+        const auto proc = makeProc();
+        size_t idx;
+        while((idx=current.fetch_add(1u, std::memory_order_relaxed)) < count)
         {
-            for(ai = 0;ai < hData->mFds[fi].mEvs[ei].mAzCount;ai++)
+            proc(idx);
+            if(done.fetch_add(1u, std::memory_order_acq_rel)+1 == count)
             {
-                HrirAzT *azd = &hData->mFds[fi].mEvs[ei].mAzs[ai];
-                for(ti = 0;ti < channels;ti++)
-                {
-                    for(i = 0;i < m;i++)
-                        maxMags[fi] = std::max(azd->mIrs[ti][i], maxMags[fi]);
-                }
+                /* Wake the reporting thread once the last item is done. */
+                std::lock_guard<std::mutex> _{donelock};
+                donecond.notify_all();
             }
         }
+    };
+
+    std::vector<std::thread> thrds;
+    thrds.reserve(numThreads);
+    for(size_t i{0};i < std::max(numThreads, 1u);++i)
+        thrds.emplace_back(worker);
 
-        maxMag = std::max(maxMags[fi], maxMag);
+    /* Keep track of the number of items done, periodically reporting it. */
+    std::unique_lock<std::mutex> donewait{donelock};
+    size_t finished{done.load(std::memory_order_acquire)};
+    while(finished < count)
+    {
+        const size_t pcdone{finished * 100 / count};
+        printf("\r%s: %3zu%% done (%zu of %zu)", desc, pcdone, finished, count);
+        fflush(stdout);
+
+        donecond.wait_for(donewait, std::chrono::milliseconds{50},
+            [&done,count]() { return done.load(std::memory_order_acquire) >= count; });
+        finished = done.load(std::memory_order_acquire);
     }
+    donewait.unlock();
 
-    for(fi = 0;fi < hData->mFdCount;fi++)
+    for(auto &thrd : thrds)
     {
-        const double magFactor{maxMag / maxMags[fi]};
+        if(thrd.joinable())
+            thrd.join();
+    }
 
-        for(ei = hData->mFds[fi].mEvStart;ei < hData->mFds[fi].mEvCount;ei++)
+    const std::chrono::duration<double> elapsed{clock::now() - start};
+    printf("\r%s: 100%% done (%zu of %zu) in %.3fs\n", desc, count, count, elapsed.count());
+}
+
+
+/***********************
+ *** HRTF processing ***
+ ***********************/
+
+/* A reference to one channel's response of an HRIR, for splitting the work of
+ * the processing stages between threads.
+ */
+struct HrirRef {
+    uint mField;
+    uint mElev;
+    uint mChannel;
+    double *mIr;
+};
+
+/* Gathers references to the HRIR responses in field, elevation, azimuth, and
+ * channel order. Optionally only the measured (non-synthesized) HRIRs are
+ * included.
+ */
+static std::vector<HrirRef> GetHrirRefs(const HrirDataT *hData, const uint channels,
+    const bool measuredOnly)
+{
+    std::vector<HrirRef> refs;
+    refs.reserve(hData->mIrCount * channels);
+    for(uint fi{0u};fi < hData->mFdCount;fi++)
+    {
+        const HrirFdT &field = hData->mFds[fi];
+        for(uint ei{measuredOnly ? field.mEvStart : 0u};ei < field.mEvCount;ei++)
         {
-            for(ai = 0;ai < hData->mFds[fi].mEvs[ei].mAzCount;ai++)
+            const HrirEvT &elev = field.mEvs[ei];
+            for(uint ai{0u};ai < elev.mAzCount;ai++)
             {
-                HrirAzT *azd = &hData->mFds[fi].mEvs[ei].mAzs[ai];
-                for(ti = 0;ti < channels;ti++)
-                {
-                    for(i = 0;i < m;i++)
-                        azd->mIrs[ti][i] *= magFactor;
-                }
+                for(uint ti{0u};ti < channels;ti++)
+                    refs.emplace_back(HrirRef{fi, ei, ti, elev.mAzs[ai].mIrs[ti]});
             }
         }
     }
+    return refs;
+}
+
+/* Balances the maximum HRIR magnitudes of multi-field data sets by
+ * independently normalizing each field in relation to the overall maximum.
+ * This is done to ignore distance attenuation.
+ */
+static void BalanceFieldMagnitudes(const HrirDataT *hData, const uint channels, const uint m,
+    const uint numThreads)
+{
+    const std::vector<HrirRef> irs{GetHrirRefs(hData, channels, true)};
+
+    std::vector<double> irMaxs(irs.size());
+    ParallelFor("Finding peak magnitudes", irs.size(), numThreads, [&irs,&irMaxs,m]()
+    {
+        return [&irs,&irMaxs,m](const size_t idx) -> void
+        { irMaxs[idx] = *std::max_element(irs[idx].mIr, irs[idx].mIr+m); };
+    });
+
+    double maxMags[MAX_FD_COUNT]{};
+    for(size_t i{0};i < irs.size();i++)
+        maxMags[irs[i].mField] = std::max(irMaxs[i], maxMags[irs[i].mField]);
+    const double maxMag{*std::max_element(maxMags, maxMags+hData->mFdCount)};
+
+    ParallelFor("Scaling magnitudes", irs.size(), numThreads, [&irs,&maxMags,maxMag,m]()
+    {
+        return [&irs,&maxMags,maxMag,m](const size_t idx) -> void
+        {
+            const double magFactor{maxMag / maxMags[irs[idx].mField]};
+            std::transform(irs[idx].mIr, irs[idx].mIr+m, irs[idx].mIr,
+                std::bind(std::multiplies<double>{}, _1, magFactor));
+        };
+    });
 }
 
 /* Calculate the contribution of each HRIR to the diffuse-field average based
@@ -630,10 +741,11 @@ static void CalculateDfWeights(const HrirDataT *hData, double *weights)
  * coverage of each HRIR.  The final average can then be limited by the
  * specified magnitude range (in positive dB; 0.0 to skip).
  */
-static void CalculateDiffuseFieldAverage(const HrirDataT *hData, const uint channels, const uint m, const int weighted, const double limit, double *dfa)
+static void CalculateDiffuseFieldAverage(const HrirDataT *hData, const uint channels, const uint m,
+    const int weighted, const double limit, const uint numThreads, double *dfa)
 {
     std::vector<double> weights(hData->mFdCount * MAX_EV_COUNT);
-    uint count, ti, fi, ei, i, ai;
+    uint count, ti, fi, ei, i;
 
     if(weighted)
     {
@@ -660,26 +772,41 @@ static void CalculateDiffuseFieldAverage(const HrirDataT *hData, const uint chan
                 weights[(fi * MAX_EV_COUNT) + ei] = weight;
         }
     }
-    for(ti = 0;ti < channels;ti++)
+
+    /* The average is split by frequency between the threads, with each one
+     * summing every HRIR's contribution to its band. This keeps the order of
+     * the summation, and the result, the same regardless of the thread count.
+     */
+    static constexpr uint BandSize{1024u};
+    const uint bands{(m + BandSize - 1) / BandSize};
+    const std::vector<HrirRef> irs{GetHrirRefs(hData, channels, true)};
+    ParallelFor("Averaging responses", size_t{channels} * bands, numThreads,
+        [&irs,&weights,bands,m,dfa]()
     {
-        for(i = 0;i < m;i++)
-            dfa[(ti * m) + i] = 0.0;
-        for(fi = 0;fi < hData->mFdCount;fi++)
+        return [&irs,&weights,bands,m,dfa](const size_t idx) -> void
         {
-            for(ei = hData->mFds[fi].mEvStart;ei < hData->mFds[fi].mEvCount;ei++)
+            const auto chan = static_cast<uint>(idx / bands);
+            const auto start = static_cast<uint>(idx%bands * BandSize);
+            const uint end{std::min(start + BandSize, m)};
+            double *avg{&dfa[chan * m]};
+
+            std::fill(avg+start, avg+end, 0.0);
+            for(const HrirRef &ref : irs)
             {
-                for(ai = 0;ai < hData->mFds[fi].mEvs[ei].mAzCount;ai++)
-                {
-                    HrirAzT *azd = &hData->mFds[fi].mEvs[ei].mAzs[ai];
-                    // Get the weight for this HRIR's contribution.
-                    double weight = weights[(fi * MAX_EV_COUNT) + ei];
+                if(ref.mChannel != chan) continue;
 
-                    // Add this HRIR's weighted power average to the total.
-                    for(i = 0;i < m;i++)
-                        dfa[(ti * m) + i] += weight * azd->mIrs[ti][i] * azd->mIrs[ti][i];
-                }
+                // Get the weight for this HRIR's contribution.
+                const double weight{weights[(ref.mField * MAX_EV_COUNT) + ref.mElev]};
+
+                // Add this HRIR's weighted power average to the total.
+                for(uint j{start};j < end;j++)
+                    avg[j] += weight * ref.mIr[j] * ref.mIr[j];
             }
-        }
+        };
+    });
+
+    for(ti = 0;ti < channels;ti++)
+    {
         // Finish the average calculation and keep it from being too small.
         for(i = 0;i < m;i++)
             dfa[(ti * m) + i] = std::max(sqrt(dfa[(ti * m) + i]), EPSILON);
@@ -692,30 +819,23 @@ static void CalculateDiffuseFieldAverage(const HrirDataT *hData, const uint chan
 
 // Perform diffuse-field equalization on the magnitude responses of the HRIR
 // set using the given average response.
-static void DiffuseFieldEqualize(const uint channels, const uint m, const double *dfa, const HrirDataT *hData)
+static void DiffuseFieldEqualize(const uint channels, const uint m, const double *dfa,
+    const HrirDataT *hData, const uint numThreads)
 {
-    uint ti, fi, ei, ai, i;
-
-    for(fi = 0;fi < hData->mFdCount;fi++)
+    const std::vector<HrirRef> irs{GetHrirRefs(hData, channels, true)};
+    ParallelFor("Equalizing responses", irs.size(), numThreads, [&irs,dfa,m]()
     {
-        for(ei = hData->mFds[fi].mEvStart;ei < hData->mFds[fi].mEvCount;ei++)
+        return [&irs,dfa,m](const size_t idx) -> void
         {
-            for(ai = 0;ai < hData->mFds[fi].mEvs[ei].mAzCount;ai++)
-            {
-                HrirAzT *azd = &hData->mFds[fi].mEvs[ei].mAzs[ai];
-
-                for(ti = 0;ti < channels;ti++)
-                {
-                    for(i = 0;i < m;i++)
-                        azd->mIrs[ti][i] /= dfa[(ti * m) + i];
-                }
-            }
-        }
-    }
+            const double *avg{&dfa[irs[idx].mChannel * m]};
+            for(uint i{0};i < m;i++)
+                irs[idx].mIr[i] /= avg[i];
+        };
+    });
 }
 
 // Resamples the HRIRs for use at the given sampling rate.
-static void ResampleHrirs(const uint rate, HrirDataT *hData)
+static void ResampleHrirs(const uint rate, HrirDataT *hData, const uint numThreads)
 {
     struct Resampler {
         const double scale;
@@ -765,13 +885,12 @@ static void ResampleHrirs(const uint rate, HrirDataT *hData)
     };
 
     while(rate > hData->mIrRate*2)
-        ResampleHrirs(hData->mIrRate*2, hData);
+        ResampleHrirs(hData->mIrRate*2, hData, numThreads);
     while(rate < (hData->mIrRate+1)/2)
-        ResampleHrirs((hData->mIrRate+1)/2, hData);
+        ResampleHrirs((hData->mIrRate+1)/2, hData, numThreads);
 
     const auto scale = static_cast<double>(rate) / hData->mIrRate;
     const size_t m{hData->mFftSize/2u + 1u};
-    auto resampled = std::vector<double>(m);
 
     const Resampler resampler{scale, m};
     auto do_resample = std::bind(
@@ -779,26 +898,21 @@ static void ResampleHrirs(const uint rate, HrirDataT *hData)
         _1, _2);
 
     const uint channels{(hData->mChannelType == CT_STEREO) ? 2u : 1u};
-    for(uint fi{0};fi < hData->mFdCount;++fi)
+    const std::vector<HrirRef> irs{GetHrirRefs(hData, channels, true)};
+    ParallelFor("Resampling responses", irs.size(), numThreads, [&irs,&do_resample,m]()
     {
-        for(uint ei{hData->mFds[fi].mEvStart};ei < hData->mFds[fi].mEvCount;++ei)
+        auto resampled = std::make_shared<std::vector<double>>(m);
+        return [&irs,&do_resample,resampled](const size_t idx) -> void
         {
-            for(uint ai{0};ai < hData->mFds[fi].mEvs[ei].mAzCount;++ai)
-            {
-                HrirAzT *azd = &hData->mFds[fi].mEvs[ei].mAzs[ai];
-                for(uint ti{0};ti < channels;++ti)
-                {
-                    do_resample(resampled.data(), azd->mIrs[ti]);
-                    /* This should probably be rescaled according to the scale,
-                     * however it'll all be normalized in the end so a constant
-                     * scalar is fine to leave.
-                     */
-                    std::transform(resampled.cbegin(), resampled.cend(), azd->mIrs[ti],
-                        [](const double d) { return std::max(d, EPSILON); });
-                }
-            }
-        }
-    }
+            do_resample(resampled->data(), irs[idx].mIr);
+            /* This should probably be rescaled according to the scale,
+             * however it'll all be normalized in the end so a constant
+             * scalar is fine to leave.
+             */
+            std::transform(resampled->cbegin(), resampled->cend(), irs[idx].mIr,
+                [](const double d) { return std::max(d, EPSILON); });
+        };
+    });
     hData->mIrRate = rate;
 }
 
@@ -945,18 +1059,48 @@ static void SynthesizeOnsets(HrirDataT *hData)
  * applies a low-pass filter to simulate body occlusion.  It is a simple, if
  * inaccurate model.
  */
-static void SynthesizeHrirs(HrirDataT *hData)
+static void SynthesizeHrirs(HrirDataT *hData, const uint numThreads)
 {
     const uint channels{(hData->mChannelType == CT_STEREO) ? 2u : 1u};
-    auto htemp = std::vector<complex_d>(hData->mFftSize);
+    const RealFft fft{hData->mFftSize};
     const uint m{hData->mFftSize/2u + 1u};
-    auto filter = std::vector<double>(m);
     const double beta{3.5e-6 * hData->mIrRate};
 
-    auto proc_field = [channels,m,beta,&htemp,&filter](HrirFdT &field) -> void
+    /* Calculates the magnitude response of a low-pass filter to simulate body
+     * occlusion (phase will be reconstructed later).
+     */
+    auto calc_filter = [&fft,m](const double b, std::vector<double> &filter) -> void
+    {
+        auto htemp = std::vector<double>(fft.size());
+        auto hfreq = std::vector<complex_d>(m);
+        double lp[4]{};
+        lp[0] = Lerp(1.0, lp[0], b);
+        lp[1] = Lerp(lp[0], lp[1], b);
+        lp[2] = Lerp(lp[1], lp[2], b);
+        lp[3] = Lerp(lp[2], lp[3], b);
+        htemp[0] = lp[3];
+        for(size_t i{1u};i < fft.size();i++)
+        {
+            lp[0] = Lerp(0.0, lp[0], b);
+            lp[1] = Lerp(lp[0], lp[1], b);
+            lp[2] = Lerp(lp[1], lp[2], b);
+            lp[3] = Lerp(lp[2], lp[3], b);
+            htemp[i] = lp[3];
+        }
+        fft.forward(htemp.data(), fft.size(), hfreq.data());
+        std::transform(hfreq.cbegin(), hfreq.cend(), filter.begin(),
+            [](const complex_d &c) -> double { return std::abs(c); });
+    };
+
+    /* First synthesize the -90 elevation of each field, which the other
+     * synthesized elevations are blended with.
+     */
+    std::vector<std::pair<uint,uint>> elevs;
+    for(uint fi{0u};fi < hData->mFdCount;fi++)
     {
+        HrirFdT &field = hData->mFds[fi];
         const uint oi{field.mEvStart};
-        if(oi <= 0) return;
+        if(oi <= 0) continue;
 
         for(uint ti{0u};ti < channels;ti++)
         {
@@ -977,33 +1121,23 @@ static void SynthesizeHrirs(HrirDataT *hData)
             }
         }
 
-        for(uint ei{1u};ei < field.mEvStart;ei++)
-        {
-            const double of{static_cast<double>(ei) / field.mEvStart};
-            const double b{(1.0 - of) * beta};
-            double lp[4]{};
+        for(uint ei{1u};ei < oi;ei++)
+            elevs.emplace_back(fi, ei);
+    }
 
-            /* Calculate a low-pass filter to simulate body occlusion. */
-            lp[0] = Lerp(1.0, lp[0], b);
-            lp[1] = Lerp(lp[0], lp[1], b);
-            lp[2] = Lerp(lp[1], lp[2], b);
-            lp[3] = Lerp(lp[2], lp[3], b);
-            htemp[0] = lp[3];
-            for(size_t i{1u};i < htemp.size();i++)
-            {
-                lp[0] = Lerp(0.0, lp[0], b);
-                lp[1] = Lerp(lp[0], lp[1], b);
-                lp[2] = Lerp(lp[1], lp[2], b);
-                lp[3] = Lerp(lp[2], lp[3], b);
-                htemp[i] = lp[3];
-            }
-            /* Get the filter's frequency-domain response and extract the
-             * frequency magnitudes (phase will be reconstructed later)).
-             */
-            FftForward(static_cast<uint>(htemp.size()), htemp.data());
-            std::transform(htemp.cbegin(), htemp.cbegin()+m, filter.begin(),
-                [](const complex_d &c) -> double { return std::abs(c); });
+    /* Then each elevation in between, which are independent of each other. */
+    ParallelFor("Synthesizing elevations", elevs.size(), numThreads,
+        [hData,&elevs,&calc_filter,channels,m,beta]()
+    {
+        return [hData,&elevs,&calc_filter,channels,m,beta](const size_t idx) -> void
+        {
+            HrirFdT &field = hData->mFds[elevs[idx].first];
+            const uint oi{field.mEvStart};
+            const uint ei{elevs[idx].second};
+            const double of{static_cast<double>(ei) / oi};
+            auto filter = std::vector<double>(m);
 
+            calc_filter((1.0 - of) * beta, filter);
             for(uint ai{0u};ai < field.mEvs[ei].mAzCount;ai++)
             {
                 uint a0, a1;
@@ -1024,171 +1158,83 @@ static void SynthesizeHrirs(HrirDataT *hData)
                     }
                 }
             }
-        }
-        const double b{beta};
-        double lp[4]{};
-        lp[0] = Lerp(1.0, lp[0], b);
-        lp[1] = Lerp(lp[0], lp[1], b);
-        lp[2] = Lerp(lp[1], lp[2], b);
-        lp[3] = Lerp(lp[2], lp[3], b);
-        htemp[0] = lp[3];
-        for(size_t i{1u};i < htemp.size();i++)
-        {
-            lp[0] = Lerp(0.0, lp[0], b);
-            lp[1] = Lerp(lp[0], lp[1], b);
-            lp[2] = Lerp(lp[1], lp[2], b);
-            lp[3] = Lerp(lp[2], lp[3], b);
-            htemp[i] = lp[3];
-        }
-        FftForward(static_cast<uint>(htemp.size()), htemp.data());
-        std::transform(htemp.cbegin(), htemp.cbegin()+m, filter.begin(),
-            [](const complex_d &c) -> double { return std::abs(c); });
+        };
+    });
 
-        for(uint ti{0u};ti < channels;ti++)
+    /* Finally apply the full low-pass filter to the -90 elevations. */
+    if(!elevs.empty())
+    {
+        auto filter = std::vector<double>(m);
+        calc_filter(beta, filter);
+        for(uint fi{0u};fi < hData->mFdCount;fi++)
         {
-            for(uint i{0u};i < m;i++)
-                field.mEvs[0].mAzs[0].mIrs[ti][i] *= filter[i];
+            HrirFdT &field = hData->mFds[fi];
+            if(field.mEvStart <= 0) continue;
+
+            for(uint ti{0u};ti < channels;ti++)
+            {
+                for(uint i{0u};i < m;i++)
+                    field.mEvs[0].mAzs[0].mIrs[ti][i] *= filter[i];
+            }
         }
-    };
-    std::for_each(hData->mFds.begin(), hData->mFds.begin()+hData->mFdCount, proc_field);
+    }
 }
 
 // The following routines assume a full set of HRIRs for all elevations.
 
 /* Perform minimum-phase reconstruction using the magnitude responses of the
- * HRIR set. Work is delegated to this struct, which runs asynchronously on one
- * or more threads (sharing the same reconstructor object).
+ * HRIR set, keeping the leading points of the time-domain responses.
  */
-struct HrirReconstructor {
-    std::vector<double*> mIrs;
-    std::atomic<size_t> mCurrent;
-    std::atomic<size_t> mDone;
-    uint mFftSize;
-    uint mIrPoints;
-
-    void Worker()
-    {
-        auto h = std::vector<complex_d>(mFftSize);
-
-        while(1)
-        {
-            /* Load the current index to process. */
-            size_t idx{mCurrent.load()};
-            do {
-                /* If the index is at the end, we're done. */
-                if(idx >= mIrs.size())
-                    return;
-                /* Otherwise, increment the current index atomically so other
-                 * threads know to go to the next one. If this call fails, the
-                 * current index was just changed by another thread and the new
-                 * value is loaded into idx, which we'll recheck.
-                 */
-            } while(!mCurrent.compare_exchange_weak(idx, idx+1, std::memory_order_relaxed));
-
-            /* Now do the reconstruction, and apply the inverse FFT to get the
-             * time-domain response.
-             */
-            MinimumPhase(mFftSize, mIrs[idx], h.data());
-            FftInverse(mFftSize, h.data());
-            for(uint i{0u};i < mIrPoints;++i)
-                mIrs[idx][i] = h[i].real();
-
-            /* Increment the number of IRs done. */
-            mDone.fetch_add(1);
-        }
-    }
-};
-
 static void ReconstructHrirs(const HrirDataT *hData, const uint numThreads)
 {
     const uint channels{(hData->mChannelType == CT_STEREO) ? 2u : 1u};
+    const RealFft fft{hData->mFftSize};
+    const uint irPoints{hData->mIrPoints};
 
-    /* Set up the reconstructor with the needed size info and pointers to the
-     * IRs to process.
-     */
-    HrirReconstructor reconstructor;
-    reconstructor.mCurrent.store(0, std::memory_order_relaxed);
-    reconstructor.mDone.store(0, std::memory_order_relaxed);
-    reconstructor.mFftSize = hData->mFftSize;
-    reconstructor.mIrPoints = hData->mIrPoints;
-    for(uint fi{0u};fi < hData->mFdCount;fi++)
+    const std::vector<HrirRef> irs{GetHrirRefs(hData, channels, false)};
+    ParallelFor("Reconstructing minimum-phase responses", irs.size(), numThreads,
+        [&irs,&fft,irPoints]()
     {
-        const HrirFdT &field = hData->mFds[fi];
-        for(uint ei{0};ei < field.mEvCount;ei++)
+        auto work = std::make_shared<std::vector<complex_d>>(fft.size()/2 + 1);
+        auto ceps = std::make_shared<std::vector<double>>(fft.size());
+        return [&irs,&fft,irPoints,work,ceps](const size_t idx) -> void
         {
-            const HrirEvT &elev = field.mEvs[ei];
-            for(uint ai{0u};ai < elev.mAzCount;ai++)
-            {
-                const HrirAzT &azd = elev.mAzs[ai];
-                for(uint ti{0u};ti < channels;ti++)
-                    reconstructor.mIrs.push_back(azd.mIrs[ti]);
-            }
-        }
-    }
-
-    /* Launch threads to work on reconstruction. */
-    std::vector<std::thread> thrds;
-    thrds.reserve(numThreads);
-    for(size_t i{0};i < numThreads;++i)
-        thrds.emplace_back(std::mem_fn(&HrirReconstructor::Worker), &reconstructor);
-
-    /* Keep track of the number of IRs done, periodically reporting it. */
-    size_t count;
-    do {
-        std::this_thread::sleep_for(std::chrono::milliseconds{50});
-
-        count = reconstructor.mDone.load();
-        size_t pcdone{count * 100 / reconstructor.mIrs.size()};
-
-        printf("\r%3zu%% done (%zu of %zu)", pcdone, count, reconstructor.mIrs.size());
-        fflush(stdout);
-    } while(count < reconstructor.mIrs.size());
-    fputc('\n', stdout);
-
-    for(auto &thrd : thrds)
-    {
-        if(thrd.joinable())
-            thrd.join();
-    }
+            double *ir{irs[idx].mIr};
+            MinimumPhase(fft, ir, work->data(), ceps->data(), ir, irPoints);
+        };
+    });
 }
 
 // Normalize the HRIR set and slightly attenuate the result.
-static void NormalizeHrirs(HrirDataT *hData)
+static void NormalizeHrirs(HrirDataT *hData, const uint numThreads)
 {
     const uint channels{(hData->mChannelType == CT_STEREO) ? 2u : 1u};
     const uint irSize{hData->mIrPoints};
+    const std::vector<HrirRef> irs{GetHrirRefs(hData, channels, false)};
 
     /* Find the maximum amplitude and RMS out of all the IRs. */
     struct LevelPair { double amp, rms; };
-    auto proc0_field = [channels,irSize](const LevelPair levels0, const HrirFdT &field) -> LevelPair
+    std::vector<LevelPair> levels(irs.size());
+    ParallelFor("Measuring levels", irs.size(), numThreads, [&irs,&levels,irSize]()
     {
-        auto proc_elev = [channels,irSize](const LevelPair levels1, const HrirEvT &elev) -> LevelPair
+        return [&irs,&levels,irSize](const size_t idx) -> void
         {
-            auto proc_azi = [channels,irSize](const LevelPair levels2, const HrirAzT &azi) -> LevelPair
-            {
-                auto proc_channel = [irSize](const LevelPair levels3, const double *ir) -> LevelPair
+            /* Calculate the peak amplitude and RMS of this IR. */
+            const double *ir{irs[idx].mIr};
+            auto current = std::accumulate(ir, ir+irSize, LevelPair{0.0, 0.0},
+                [](const LevelPair cur, const double impulse) -> LevelPair
                 {
-                    /* Calculate the peak amplitude and RMS of this IR. */
-                    auto current = std::accumulate(ir, ir+irSize, LevelPair{0.0, 0.0},
-                        [](const LevelPair cur, const double impulse) -> LevelPair
-                        {
-                            return {std::max(std::abs(impulse), cur.amp),
-                                cur.rms + impulse*impulse};
-                        });
-                    current.rms = std::sqrt(current.rms / irSize);
-
-                    /* Accumulate levels by taking the maximum amplitude and RMS. */
-                    return LevelPair{std::max(current.amp, levels3.amp),
-                        std::max(current.rms, levels3.rms)};
-                };
-                return std::accumulate(azi.mIrs, azi.mIrs+channels, levels2, proc_channel);
-            };
-            return std::accumulate(elev.mAzs, elev.mAzs+elev.mAzCount, levels1, proc_azi);
+                    return {std::max(std::abs(impulse), cur.amp),
+                        cur.rms + impulse*impulse};
+                });
+            current.rms = std::sqrt(current.rms / irSize);
+            levels[idx] = current;
         };
-        return std::accumulate(field.mEvs, field.mEvs+field.mEvCount, levels0, proc_elev);
-    };
-    const auto maxlev = std::accumulate(hData->mFds.begin(), hData->mFds.begin()+hData->mFdCount,
-        LevelPair{0.0, 0.0}, proc0_field);
+    });
+    /* Accumulate levels by taking the maximum amplitude and RMS. */
+    const auto maxlev = std::accumulate(levels.cbegin(), levels.cend(), LevelPair{0.0, 0.0},
+        [](const LevelPair cur, const LevelPair lev) -> LevelPair
+        { return LevelPair{std::max(cur.amp, lev.amp), std::max(cur.rms, lev.rms)}; });
 
     /* Normalize using the maximum RMS of the HRIRs. The RMS measure for the
      * non-filtered signal is of an impulse with equal length (to the filter):
@@ -1205,24 +1251,9 @@ static void NormalizeHrirs(HrirDataT *hData)
     factor = std::min(factor, 0.99/maxlev.amp);
 
     /* Now scale all IRs by the given factor. */
-    auto proc1_field = [channels,irSize,factor](HrirFdT &field) -> void
-    {
-        auto proc_elev = [channels,irSize,factor](HrirEvT &elev) -> void
-        {
-            auto proc_azi = [channels,irSize,factor](HrirAzT &azi) -> void
-            {
-                auto proc_channel = [irSize,factor](double *ir) -> void
-                {
-                    std::transform(ir, ir+irSize, ir,
-                        std::bind(std::multiplies<double>{}, _1, factor));
-                };
-                std::for_each(azi.mIrs, azi.mIrs+channels, proc_channel);
-            };
-            std::for_each(elev.mAzs, elev.mAzs+elev.mAzCount, proc_azi);
-        };
-        std::for_each(field.mEvs, field.mEvs+field.mEvCount, proc_elev);
-    };
-    std::for_each(hData->mFds.begin(), hData->mFds.begin()+hData->mFdCount, proc1_field);
+    for(const HrirRef &ref : irs)
+        std::transform(ref.mIr, ref.mIr+irSize, ref.mIr,
+            std::bind(std::multiplies<double>{}, _1, factor));
 }
 
 // Calculate the left-ear time delay using a spherical head model.
@@ -1386,6 +1417,48 @@ int PrepareHrirData(const uint fdCount, const double (&distances)[MAX_FD_COUNT],
 }
 
 
+/* Keeps the time spent in each of the processing stages, for a summary once
+ * the data set is done.
+ */
+class StageTimer {
+    using clock = std::chrono::steady_clock;
+
+    std::vector<std::pair<const char*,double>> mStages;
+    const char *mCurrent{nullptr};
+    clock::time_point mStart;
+
+public:
+    // Ends the current stage, if any, and starts timing the next.
+    void next(const char *name)
+    {
+        end();
+        mCurrent = name;
+        mStart = clock::now();
+    }
+
+    void end()
+    {
+        if(!mCurrent) return;
+        const std::chrono::duration<double> elapsed{clock::now() - mStart};
+        mStages.emplace_back(mCurrent, elapsed.count());
+        mCurrent = nullptr;
+    }
+
+    void report(const uint numThreads)
+    {
+        end();
+        fprintf(stdout, "Processing times with %u thread%s:\n", numThreads,
+            (numThreads==1)?"":"s");
+        double total{0.0};
+        for(const auto &stage : mStages)
+        {
+            fprintf(stdout, "  %-32s %9.3fs\n", stage.first, stage.second);
+            total += stage.second;
+        }
+        fprintf(stdout, "  %-32s %9.3fs\n", "Total", total);
+    }
+};
+
 /* Parse the data set definition and process the source data, storing the
  * resulting data set as desired.  If the input name is NULL it will read
  * from standard input.
@@ -1397,8 +1470,10 @@ static int ProcessDefinition(const char *inName, const uint outRate, const Chann
 {
     char rateStr[8+1], expName[MAX_PATH_LEN];
     HrirDataT hData;
+    StageTimer timer;
 
     fprintf(stdout, "Using %u thread%s.\n", numThreads, (numThreads==1)?"":"s");
+    timer.next("Loading");
     if(!inName)
     {
         inName = "stdin";
@@ -1448,13 +1523,16 @@ static int ProcessDefinition(const char *inName, const uint outRate, const Chann
 
         if(hData.mFdCount > 1)
         {
+            timer.next("Field balancing");
             fprintf(stdout, "Balancing field magnitudes...\n");
-            BalanceFieldMagnitudes(&hData, c, m);
+            BalanceFieldMagnitudes(&hData, c, m, numThreads);
         }
+        timer.next("Diffuse-field average");
         fprintf(stdout, "Calculating diffuse-field average...\n");
-        CalculateDiffuseFieldAverage(&hData, c, m, surface, limit, dfa.data());
+        CalculateDiffuseFieldAverage(&hData, c, m, surface, limit, numThreads, dfa.data());
+        timer.next("Diffuse-field equalization");
         fprintf(stdout, "Performing diffuse-field equalization...\n");
-        DiffuseFieldEqualize(c, m, dfa.data(), &hData);
+        DiffuseFieldEqualize(c, m, dfa.data(), &hData, numThreads);
     }
     if(hData.mFds.size() > 1)
     {
@@ -1472,25 +1550,33 @@ static int ProcessDefinition(const char *inName, const uint outRate, const Chann
     }
     if(outRate != 0 && outRate != hData.mIrRate)
     {
+        timer.next("Resampling");
         fprintf(stdout, "Resampling HRIRs...\n");
-        ResampleHrirs(outRate, &hData);
+        ResampleHrirs(outRate, &hData, numThreads);
     }
+    timer.next("Elevation synthesis");
     fprintf(stdout, "Synthesizing missing elevations...\n");
     if(model == HM_DATASET)
         SynthesizeOnsets(&hData);
-    SynthesizeHrirs(&hData);
+    SynthesizeHrirs(&hData, numThreads);
+    timer.next("Minimum-phase reconstruction");
     fprintf(stdout, "Performing minimum phase reconstruction...\n");
     ReconstructHrirs(&hData, numThreads);
     fprintf(stdout, "Truncating minimum-phase HRIRs...\n");
     hData.mIrPoints = truncSize;
+    timer.next("Normalization");
     fprintf(stdout, "Normalizing final HRIRs...\n");
-    NormalizeHrirs(&hData);
+    NormalizeHrirs(&hData, numThreads);
+    timer.next("Impulse delays");
     fprintf(stdout, "Calculating impulse delays...\n");
     CalculateHrtds(model, (radius > DEFAULT_CUSTOM_RADIUS) ? radius : hData.mRadius, &hData);
     snprintf(rateStr, sizeof(rateStr), "%u", hData.mIrRate);
     StrSubst(outName, "%r", rateStr, sizeof(expName), expName);
+    timer.next("Storing");
     fprintf(stdout, "Creating MHR data set %s...\n", expName);
-    return StoreMhr(&hData, expName);
+    const int ret{StoreMhr(&hData, expName)};
+    timer.report(numThreads);
+    return ret;
 }
 
 static void PrintHelp(const char *argv0, FILE *ofile)
@@ -3,6 +3,7 @@
 
 #include <vector>
 #include <complex>
+#include <functional>
 
 #include "polyphase_resampler.h"
 
@@ -107,10 +108,42 @@ struct HrirDataT {
 };
 
 
+/* Performs FFTs of real signals with a given power-of-two size, using a
+ * complex FFT of half the size and precalculated twiddle factors. The object
+ * isn't modified by the transforms, so it can be shared between threads.
+ */
+class RealFft {
+    uint mSize;
+    std::vector<complex_d> mTwiddles;
+
+    void transform(complex_d *inout, const bool inverse) const;
+
+public:
+    explicit RealFft(const uint n);
+
+    uint size() const noexcept { return mSize; }
+
+    /* Calculates the n/2 + 1 frequency bins of the given real samples, which
+     * are zero-padded from count up to n.
+     */
+    void forward(const double *in, const uint count, complex_d *out) const;
+
+    /* Calculates the first count real samples from the n/2 + 1 frequency bins
+     * (scaled by 1/n). The input bins are overwritten.
+     */
+    void inverse(complex_d *inout, double *out, const uint count) const;
+};
+
 int PrepareHrirData(const uint fdCount, const double (&distances)[MAX_FD_COUNT], const uint (&evCounts)[MAX_FD_COUNT], const uint azCounts[MAX_FD_COUNT * MAX_EV_COUNT], HrirDataT *hData);
 void MagnitudeResponse(const uint n, const complex_d *in, double *out);
-void FftForward(const uint n, complex_d *inout);
-void FftInverse(const uint n, complex_d *inout);
+
+/* Calls a function for each index from 0 to count-1 on the given number of
+ * threads, reporting the progress and time taken with the given description.
+ * Each thread gets its function from makeProc, so it can have its own scratch
+ * buffers.
+ */
+void ParallelFor(const char *desc, const size_t count, const uint numThreads,
+    const std::function<std::function<void(size_t)>()> &makeProc);
 
 
 // Performs linear interpolation.